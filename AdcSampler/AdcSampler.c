@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  AdcSampler.c - Background VSYS & temperature sampler.
+//
+//  DESCRIPTION
+//      Free-running ADC sampler of VSYS and the on-chip temperature sensor.
+//      ADC round-robins both inputs into its FIFO, DMA drains the FIFO into
+//      a block buffer, DMA IRQ averages the block and updates fixed-point
+//      EMA filters. Readers get the latest filtered values in O(1) without
+//      touching ADC.
+//
+//      The inputs are told apart by their position in the block only, so
+//      a FIFO overflow (e.g. IRQs off for a flash write) or a block which
+//      never comes restarts the round robin from VSYS and drops the block.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "AdcSampler.h"
+#include <stdlib.h>
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include <defines.h>
+
+#define LOG_MODULE POWER
+#include "debug/log.h"
+
+static AdcSamplerContext *spADC = NULL;
+
+/// @brief Updates EMA filter by a new block average.
+/// @param pu32_q8 Ptr to the filter state, Q24.8.
+/// @param u32_sum Sum of the block samples of the input.
+/// @param first Whether it is the first block.
+static void __not_in_flash_func (AdcSamplerFilter)(volatile uint32_t *pu32_q8,
+                                                   uint32_t u32_sum, int first)
+{
+    const int32_t i32_avg_q8 = (int32_t)((u32_sum << 8) / (ADC_SAMPLER_BLOCK / 2));
+    if(first)
+    {
+        *pu32_q8 = (uint32_t)i32_avg_q8;
+        return;
+    }
+    *pu32_q8 += (i32_avg_q8 - (int32_t)*pu32_q8) >> ADC_SAMPLER_EMA_SHIFT;
+}
+
+/// @brief Restarts sampling from VSYS on an empty FIFO. Called from IRQs
+/// @brief of the same priority only, so they never preempt each other.
+/// @param p Context.
+static void __not_in_flash_func (AdcSamplerRestart)(AdcSamplerContext *p)
+{
+    adc_run(false);
+    dma_channel_set_irq0_enabled(p->_dma_chan, false);
+    dma_channel_abort(p->_dma_chan);
+    dma_channel_acknowledge_irq0(p->_dma_chan);
+    dma_channel_set_irq0_enabled(p->_dma_chan, true);
+
+    adc_fifo_drain();                   /* Waits for a conversion under way. */
+    adc_hw->fcs |= ADC_FCS_OVER_BITS | ADC_FCS_UNDER_BITS;
+    adc_select_input(ADC_SAMPLER_VSYS_INPUT);
+
+    ++p->_u32_nrestarts;
+    dma_channel_set_write_addr(p->_dma_chan, p->_pu16_block, true);
+    adc_run(true);
+}
+
+/// @brief DMA IRQ: accounts the block and restarts DMA at once.
+/// @brief ADC FIFO (4 samples = 5 ms) covers the restart latency; if it
+/// @brief hasn't, samples are lost and the block is dropped.
+static void __not_in_flash_func (AdcSamplerISR)(void)
+{
+    AdcSamplerContext *p = spADC;
+    dma_channel_acknowledge_irq0(p->_dma_chan);
+
+    if(adc_hw->fcs & (ADC_FCS_OVER_BITS | ADC_FCS_UNDER_BITS))
+    {
+        AdcSamplerRestart(p);
+        return;
+    }
+
+    uint32_t u32_vsys = 0, u32_temp = 0;
+    for(int i = 0; i < ADC_SAMPLER_BLOCK; i += 2)
+    {
+        u32_vsys += p->_pu16_block[i] & 0xFFF;
+        u32_temp += p->_pu16_block[i + 1] & 0xFFF;
+    }
+
+    dma_channel_set_write_addr(p->_dma_chan, p->_pu16_block, true);
+
+    AdcSamplerFilter(&p->_u32_vsys_q8, u32_vsys, !p->_u32_nblocks);
+    AdcSamplerFilter(&p->_u32_temp_q8, u32_temp, !p->_u32_nblocks);
+    ++p->_u32_nblocks;
+}
+
+/// @brief Alarm: restarts sampling if no block has come since the last one,
+/// @brief e.g. the DMA IRQ has been lost.
+static int64_t __not_in_flash_func (AdcSamplerWatchdog)(alarm_id_t id, void *pdata)
+{
+    AdcSamplerContext *p = (AdcSamplerContext *)pdata;
+    if(p->_u32_nblocks == p->_u32_watch_nblocks)
+    {
+        AdcSamplerRestart(p);
+    }
+    p->_u32_watch_nblocks = p->_u32_nblocks;
+
+    return ADC_SAMPLER_WATCHDOG_US;
+}
+
+/// @brief Initializes ADC, DMA and starts sampling in background.
+/// @return the Context.
+AdcSamplerContext *AdcSamplerInit(void)
+{
+    assert_(!spADC);
+
+    AdcSamplerContext *p = calloc(1, sizeof(AdcSamplerContext));
+    assert_(p);
+
+    adc_init();
+    adc_gpio_init(PICO_VSYS_PIN);
+    adc_set_temp_sensor_enabled(true);
+
+    /* VSYS goes first, so even samples are VSYS, odd ones are temperature. */
+    adc_select_input(ADC_SAMPLER_VSYS_INPUT);
+    adc_set_round_robin((1U << ADC_SAMPLER_VSYS_INPUT) | (1U << ADC_TEMPERATURE_CHANNEL_NUM));
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv(ADC_SAMPLER_CLKDIV);
+
+    p->_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(p->_dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    dma_channel_configure(p->_dma_chan, &cfg, p->_pu16_block, &adc_hw->fifo,
+                          ADC_SAMPLER_BLOCK, false);
+
+    spADC = p;
+    dma_channel_set_irq0_enabled(p->_dma_chan, true);
+    irq_set_exclusive_handler(DMA_IRQ_0, AdcSamplerISR);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    adc_fifo_drain();
+    dma_channel_set_write_addr(p->_dma_chan, p->_pu16_block, true);
+    adc_run(true);
+
+    p->_watchdog = add_alarm_in_us(ADC_SAMPLER_WATCHDOG_US, AdcSamplerWatchdog, p, true);
+    assert_(p->_watchdog > 0);
+
+    LOG_D("AdcSampler: dma:%d", p->_dma_chan);
+
+    return p;
+}
+
+/// @brief Checks whether at least one block has been accounted.
+/// @param pctx Context.
+/// @return 1 if values are valid.
+int AdcSamplerIsValid(const AdcSamplerContext *pctx)
+{
+    assert_(pctx);
+
+    return pctx->_u32_nblocks > 0;
+}
+
+/// @brief Gets filtered VSYS.
+/// @param pctx Context.
+/// @return VSYS, mV.
+uint32_t AdcSamplerGetVsysMv(const AdcSamplerContext *pctx)
+{
+    assert_(pctx);
+
+    /* VSYS/3 divider, 3.3 V reference, 12 bit. */
+    return (uint32_t)(((uint64_t)pctx->_u32_vsys_q8 * 3U * 3300U) >> (12 + 8));
+}
+
+/// @brief Gets filtered on-chip temperature.
+/// @param pctx Context.
+/// @return Temperature, 0.01 C.
+int32_t AdcSamplerGetTempCenti(const AdcSamplerContext *pctx)
+{
+    assert_(pctx);
+
+    /* RP2040 datasheet: T = 27 - (Vbe - 0.706) / 0.001721 */
+    const int32_t i32_uv = (int32_t)(((uint64_t)pctx->_u32_temp_q8 * 3300000U) >> (12 + 8));
+
+    return 2700 - (i32_uv - 706000) * 100 / 1721;
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  AdcSampler.h - Background VSYS & temperature sampler.
+//
+//  DESCRIPTION
+//      Free-running ADC sampler of VSYS and the on-chip temperature sensor.
+//      ADC round-robins both inputs into its FIFO, DMA drains the FIFO into
+//      a block buffer, DMA IRQ averages the block and updates fixed-point
+//      EMA filters. Readers get the latest filtered values in O(1) without
+//      touching ADC.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef ADCSAMPLER_H_
+#define ADCSAMPLER_H_
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "../pico-hf-oscillator/lib/assert.h"
+
+/* Every block IRQ and watchdog alarm wakes core0 out of WFE, idle or
+   sleeping (see PowerMgrDumpStats): a block of 1.4 s and a 5 s watchdog
+   cost ~0.9 wakeups/s, vs. ~3.9 of 256 samples and 1 s. */
+#define ADC_SAMPLER_BLOCK       1024        /* Samples per DMA IRQ, both inputs. */
+#define ADC_SAMPLER_CLKDIV      65535.f     /* 48 MHz / 65536 = ~732 samples/s. */
+#define ADC_SAMPLER_EMA_SHIFT   1           /* Block averages EMA weight 1/2, ~2 s. */
+#define ADC_SAMPLER_VSYS_INPUT  3           /* GPIO29, VSYS/3. */
+#define ADC_SAMPLER_WATCHDOG_US 5000000     /* ~3.5 blocks are due within. */
+
+typedef struct
+{
+    int _dma_chan;
+    uint16_t _pu16_block[ADC_SAMPLER_BLOCK];    /* Even - VSYS, odd - temp. */
+
+    volatile uint32_t _u32_vsys_q8;         /* Filtered ADC counts, Q24.8. */
+    volatile uint32_t _u32_temp_q8;         /* Filtered ADC counts, Q24.8. */
+    volatile uint32_t _u32_nblocks;         /* Blocks accounted. */
+    volatile uint32_t _u32_nrestarts;       /* Blocks dropped on FIFO faults. */
+    uint32_t _u32_watch_nblocks;            /* _u32_nblocks at the last watchdog. */
+    alarm_id_t _watchdog;
+
+} AdcSamplerContext;
+
+AdcSamplerContext *AdcSamplerInit(void);
+int AdcSamplerIsValid(const AdcSamplerContext *pctx);
+uint32_t AdcSamplerGetVsysMv(const AdcSamplerContext *pctx);
+int32_t AdcSamplerGetTempCenti(const AdcSamplerContext *pctx);
+
+#endif
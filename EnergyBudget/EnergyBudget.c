@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  EnergyBudget.c - Energy aware TX duty cycle.
+//
+//  DESCRIPTION
+//      Tracks VSYS history, estimates battery state of charge (Li-ion open
+//      circuit voltage table) and charge rate (EMA of dV/dt). Maps them
+//      onto a power level which stretches the slot skip count and drops
+//      aux. channels when the battery is low. Pure C, also builds on host
+//      for tools/energy_sim.c.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "EnergyBudget.h"
+#include <stdlib.h>
+
+/* Li-ion cell at rest, mV -> % state of charge. */
+static const uint16_t skSocTable[][2] =
+{
+    { 3300,   0 }, { 3500,   5 }, { 3600,  10 }, { 3700,  30 },
+    { 3750,  45 }, { 3800,  55 }, { 3850,  65 }, { 3900,  72 },
+    { 3950,  80 }, { 4000,  85 }, { 4100,  93 }, { 4200, 100 }
+};
+#define EB_SOC_TABLE_LEN (sizeof(skSocTable) / sizeof(skSocTable[0]))
+
+/// @brief Initializes energy budget context.
+/// @param base_skip Slot skip count configured for a healthy battery.
+/// @param slot_step Slots per eligible one, 2 if the schedule keeps to even
+/// @param or odd slots (the skip counts eligible slots only), else 1.
+/// @param base_naux Aux. channels configured for a healthy battery.
+/// @return the Context.
+EnergyBudgetContext *EnergyBudgetInit(uint8_t base_skip, uint8_t slot_step, uint8_t base_naux)
+{
+    assert_(slot_step && slot_step <= EB_CRITICAL_TX_SLOTS);
+
+    EnergyBudgetContext *p = calloc(1, sizeof(EnergyBudgetContext));
+    assert_(p);
+
+    p->_u8_base_skip = base_skip;
+    p->_u8_base_naux = base_naux;
+    p->_u8_slot_step = slot_step;
+    p->_u8_soc_pct = 100;
+    p->_u8_level = EB_LEVEL_NORMAL;
+
+    return p;
+}
+
+/// @brief Checks whether it is time to take a next VSYS sample.
+/// @param pctx Context.
+/// @param u64_now_us Current time, us.
+/// @return 1 if due.
+int EnergyBudgetIsDue(const EnergyBudgetContext *pctx, uint64_t u64_now_us)
+{
+    assert_(pctx);
+
+    if(!pctx->_u32_nsamples)
+    {
+        return 1;
+    }
+
+    const EnergySample *plast = &pctx->_pSamples[(pctx->_u32_nsamples - 1) & (EB_HISTORY_LEN - 1)];
+
+    return u64_now_us - plast->_u64_time_us >= EB_SAMPLE_PERIOD_US;
+}
+
+/// @brief Estimates state of charge by battery voltage at rest.
+/// @param u32_mv Voltage, mV.
+/// @return SoC, %.
+uint8_t EnergyBudgetSocFromMv(uint32_t u32_mv)
+{
+    if(u32_mv <= skSocTable[0][0])
+    {
+        return 0;
+    }
+
+    for(uint32_t i = 1; i < EB_SOC_TABLE_LEN; ++i)
+    {
+        if(u32_mv < skSocTable[i][0])
+        {
+            const uint32_t u32_v0 = skSocTable[i - 1][0], u32_s0 = skSocTable[i - 1][1];
+            const uint32_t u32_v1 = skSocTable[i][0], u32_s1 = skSocTable[i][1];
+            return (uint8_t)(u32_s0 + (u32_mv - u32_v0) * (u32_s1 - u32_s0) / (u32_v1 - u32_v0));
+        }
+    }
+
+    return 100;
+}
+
+/// @brief Chooses power level by SoC and charge rate.
+/// @brief Going down is immediate, going up needs EB_SOC_HYST_PCT margin.
+/// @param pctx Context.
+/// @return EB_LEVEL_*
+static uint8_t EnergyBudgetLevel(const EnergyBudgetContext *pctx)
+{
+    const int i_soc = pctx->_u8_soc_pct;
+    const int i_low = EB_SOC_LOW_PCT
+                      + (pctx->_u8_level < EB_LEVEL_NORMAL ? EB_SOC_HYST_PCT : 0);
+    const int i_critical = EB_SOC_CRITICAL_PCT
+                           + (pctx->_u8_level < EB_LEVEL_LOW ? EB_SOC_HYST_PCT : 0);
+
+    uint8_t level = i_soc >= i_low ? EB_LEVEL_NORMAL
+                  : i_soc >= i_critical ? EB_LEVEL_LOW : EB_LEVEL_CRITICAL;
+
+    /* The sun pays for the extra beacons. */
+    if(pctx->_i32_rate_mv_h >= EB_CHARGING_MV_H && level < EB_LEVEL_NORMAL)
+    {
+        ++level;
+    }
+
+    return level;
+}
+
+/// @brief Accounts a VSYS sample. Should be taken while not transmitting.
+/// @param pctx Context.
+/// @param u64_now_us Sample time, us.
+/// @param u32_vsys_mv VSYS, mV.
+void EnergyBudgetUpdate(EnergyBudgetContext *pctx, uint64_t u64_now_us, uint32_t u32_vsys_mv)
+{
+    assert_(pctx);
+
+    const uint32_t n = pctx->_u32_nsamples;
+    EnergySample *pnew = &pctx->_pSamples[n & (EB_HISTORY_LEN - 1)];
+
+    /* The oldest sample is about to be overwritten by the newest one. */
+    if(n)
+    {
+        const EnergySample *pold = &pctx->_pSamples[n < EB_HISTORY_LEN ? 0 : n & (EB_HISTORY_LEN - 1)];
+        const int64_t i64_dt_us = (int64_t)(u64_now_us - pold->_u64_time_us);
+        if(i64_dt_us > 0)
+        {
+            const int32_t i32_rate = (int32_t)(((int64_t)u32_vsys_mv - pold->_u16_vsys_mv)
+                                               * 3600000000LL / i64_dt_us);
+            pctx->_i32_rate_mv_h += (i32_rate - pctx->_i32_rate_mv_h) >> EB_RATE_EMA_SHIFT;
+        }
+    }
+
+    pnew->_u64_time_us = u64_now_us;
+    pnew->_u16_vsys_mv = (uint16_t)u32_vsys_mv;
+    pctx->_u32_nsamples = n + 1;
+
+    /* A few latest samples average ADC noise out. */
+    const uint32_t u32_navg = pctx->_u32_nsamples < 4 ? pctx->_u32_nsamples : 4;
+    uint32_t u32_sum = 0;
+    for(uint32_t i = 0; i < u32_navg; ++i)
+    {
+        u32_sum += pctx->_pSamples[(n - i) & (EB_HISTORY_LEN - 1)]._u16_vsys_mv;
+    }
+    pctx->_u8_soc_pct = EnergyBudgetSocFromMv(u32_sum / u32_navg);
+    pctx->_u8_level = EnergyBudgetLevel(pctx);
+}
+
+/// @brief Gets slot skip count according to power level.
+/// @param pctx Context.
+/// @return Slot skip count to be used by scheduler.
+uint8_t EnergyBudgetSlotSkip(const EnergyBudgetContext *pctx)
+{
+    assert_(pctx);
+
+    switch(pctx->_u8_level)
+    {
+        case EB_LEVEL_CRITICAL:
+        {
+        const uint8_t u8_skip = EB_CRITICAL_TX_SLOTS / pctx->_u8_slot_step - 1;
+        return pctx->_u8_base_skip > u8_skip ? pctx->_u8_base_skip : u8_skip;
+        }
+
+        case EB_LEVEL_LOW:
+        return pctx->_u8_base_skip >= 127 ? 255 : 2 * pctx->_u8_base_skip + 1;
+
+        default:
+        break;
+    }
+
+    return pctx->_u8_base_skip;
+}
+
+/// @brief Gets a count of aux. channels (extra bands) allowed.
+/// @param pctx Context.
+/// @return Aux. channels to be used.
+uint8_t EnergyBudgetMaxAux(const EnergyBudgetContext *pctx)
+{
+    assert_(pctx);
+
+    return EB_LEVEL_NORMAL == pctx->_u8_level ? pctx->_u8_base_naux : 0;
+}
@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  EnergyBudget.h - Energy aware TX duty cycle.
+//
+//  DESCRIPTION
+//      Tracks VSYS history, estimates battery state of charge (Li-ion open
+//      circuit voltage table) and charge rate (EMA of dV/dt). Maps them
+//      onto a power level which stretches the slot skip count and drops
+//      aux. channels when the battery is low. Pure C, also builds on host
+//      for tools/energy_sim.c.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef ENERGYBUDGET_H_
+#define ENERGYBUDGET_H_
+
+#include <stdint.h>
+
+#ifdef ENERGY_BUDGET_HOST
+#include <assert.h>
+#define assert_ assert
+#else
+#include "../pico-hf-oscillator/lib/assert.h"
+#endif
+
+#define EB_HISTORY_LEN          32          /* VSYS samples kept, power of two. */
+#define EB_SAMPLE_PERIOD_US     60000000ULL /* VSYS sampling period. */
+#define EB_RATE_EMA_SHIFT       2           /* Charge rate EMA weight 1/4. */
+
+/* Thresholds may be overridden by -D, see tools/energy_sim.c */
+#ifndef EB_SOC_LOW_PCT
+#define EB_SOC_LOW_PCT          50          /* Below: stretch the schedule. */
+#endif
+#ifndef EB_SOC_CRITICAL_PCT
+#define EB_SOC_CRITICAL_PCT     20          /* Below: rare beacons only. */
+#endif
+#ifndef EB_SOC_HYST_PCT
+#define EB_SOC_HYST_PCT         3           /* To go back to a higher level. */
+#endif
+#ifndef EB_CHARGING_MV_H
+#define EB_CHARGING_MV_H        20          /* Rate to be treated as charging. */
+#endif
+#ifndef EB_CRITICAL_TX_SLOTS
+#define EB_CRITICAL_TX_SLOTS    240         /* 1 TX per hour of FT8 slots. */
+#endif
+
+enum
+{
+    EB_LEVEL_CRITICAL = 0,                  /* 1 TX per EB_CRITICAL_TX_SLOTS. */
+    EB_LEVEL_LOW,                           /* Twice the skip, no aux channels. */
+    EB_LEVEL_NORMAL                         /* Schedule as configured. */
+};
+
+typedef struct
+{
+    uint64_t _u64_time_us;
+    uint16_t _u16_vsys_mv;
+
+} EnergySample;
+
+typedef struct
+{
+    EnergySample _pSamples[EB_HISTORY_LEN];
+    uint32_t _u32_nsamples;                 /* Total, free running. */
+
+    int32_t _i32_rate_mv_h;                 /* Filtered dV/dt, mV per hour. */
+    uint8_t _u8_soc_pct;                    /* State of charge estimate. */
+    uint8_t _u8_level;                      /* EB_LEVEL_* */
+
+    uint8_t _u8_base_skip;                  /* Configured slot skip. */
+    uint8_t _u8_base_naux;                  /* Configured aux. channels. */
+    uint8_t _u8_slot_step;                  /* Slots per eligible one: 2 if parity set. */
+
+} EnergyBudgetContext;
+
+EnergyBudgetContext *EnergyBudgetInit(uint8_t base_skip, uint8_t slot_step, uint8_t base_naux);
+int EnergyBudgetIsDue(const EnergyBudgetContext *pctx, uint64_t u64_now_us);
+void EnergyBudgetUpdate(EnergyBudgetContext *pctx, uint64_t u64_now_us, uint32_t u32_vsys_mv);
+
+uint8_t EnergyBudgetSocFromMv(uint32_t u32_mv);
+uint8_t EnergyBudgetSlotSkip(const EnergyBudgetContext *pctx);
+uint8_t EnergyBudgetMaxAux(const EnergyBudgetContext *pctx);
+
+#endif
@@ -0,0 +1,294 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  Metrics.c - Runtime metrics registry.
+//
+//  DESCRIPTION
+//      Counters, gauges and log2 histograms of the beacon's health, kept in
+//      a fixed table indexed by MetricId. On request from USB CDC the whole
+//      table is sent as a compact binary snapshot, parsed by
+//      tools/metrics_poll.py.
+//
+//      Reply frame, little endian:
+//          u8 sync (0xA5), u8 version, u8 type ('m' or 'M'), u16 length,
+//          payload, u16 Fletcher-16 of the payload.
+//      Snapshot ('m') payload:
+//          u32 uptime s, u8 count, then per metric: counter u32, gauge i32
+//          histogram u32 count, u32 sum, u32 max, u32 bins[12]
+//          or timer u32 count, u32 last, u32 min, u32 max.
+//      Schema ('M') payload:
+//          u8 node len, node, u8 count, then per metric:
+//          u8 kind, u8 arg, u8 name len, name.
+//
+//      The values are updated by the main loop only, no locking is needed.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "Metrics.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "../pico-hf-oscillator/lib/assert.h"
+#include "debug/stagetimer.h"
+
+#define METRICS_MAX_FRAME       768         /* Bytes, the schema is the longest. */
+
+static const MetricDescriptor skMetrics[METRIC_COUNT] =
+{
+    [METRIC_FRAMES_SENT]            = { "frames_sent",       METRIC_COUNTER,   0 },
+    [METRIC_SLOTS_MISSED]           = { "slots_missed",      METRIC_COUNTER,   0 },
+    [METRIC_JITTER_MAX_US]          = { "jitter_max_us",     METRIC_HISTOGRAM, 1 },
+    [METRIC_JITTER_MISSED]          = { "jitter_missed",     METRIC_COUNTER,   0 },
+    [METRIC_START_ERROR_US]         = { "start_err_us",      METRIC_GAUGE,     0 },
+    [METRIC_GPS_ERRORS]             = { "gps_errors",        METRIC_COUNTER,   0 },
+    [METRIC_GPS_FIX_AGE_S]          = { "gps_fix_age_s",     METRIC_GAUGE,     0 },
+    [METRIC_GPS_PPB]                = { "gps_ppb",           METRIC_GAUGE,     0 },
+    [METRIC_FALLBACK_PPB]           = { "fallback_ppb",      METRIC_GAUGE,     0 },
+    [METRIC_VSYS_MV]                = { "vsys_mv",           METRIC_GAUGE,     0 },
+    [METRIC_TEMP_CENTI]             = { "temp_centi",        METRIC_GAUGE,     0 },
+    [METRIC_ENCODE_US]              = { "encode_us",         METRIC_HISTOGRAM, 8 },
+    [METRIC_STAGE_CREATE_PACKET]    = { "st_create_packet",  METRIC_TIMER,     STAGE_CREATE_PACKET },
+    [METRIC_STAGE_VSYS_READ]        = { "st_vsys_read",      METRIC_TIMER,     STAGE_VSYS_READ },
+    [METRIC_STAGE_MESSAGE_FORMAT]   = { "st_message_format", METRIC_TIMER,     STAGE_MESSAGE_FORMAT },
+    [METRIC_STAGE_MESSAGE_ENCODE]   = { "st_message_encode", METRIC_TIMER,     STAGE_MESSAGE_ENCODE },
+    [METRIC_STAGE_TONE_ENCODE]      = { "st_tone_encode",    METRIC_TIMER,     STAGE_TONE_ENCODE },
+    [METRIC_STAGE_SEND_PACKET]      = { "st_send_packet",    METRIC_TIMER,     STAGE_SEND_PACKET },
+};
+
+static const char *spNode = "";
+static uint32_t spu32_value[METRIC_COUNT];          /* Counters & gauges. */
+static MetricHistogram sHist[METRIC_COUNT];         /* Histograms only. */
+
+static uint8_t spu8_frame[METRICS_MAX_FRAME];
+static int sFrameLen;
+
+/// @brief Initializes the registry.
+/// @param pnode Name of the beacon reported in the schema, e.g. callsign.
+void MetricsInit(const char *pnode)
+{
+    spNode = pnode ? pnode : "";
+    memset(spu32_value, 0, sizeof(spu32_value));
+    memset(sHist, 0, sizeof(sHist));
+}
+
+/// @brief Increments a counter.
+/// @param id Metric.
+/// @param n Increment.
+void MetricsAdd(MetricId id, uint32_t n)
+{
+    assert_(id < METRIC_COUNT);
+    spu32_value[id] += n;
+}
+
+/// @brief Sets a gauge, or a counter mirrored from another module.
+/// @param id Metric.
+/// @param value The value.
+void MetricsSet(MetricId id, int32_t value)
+{
+    assert_(id < METRIC_COUNT);
+    spu32_value[id] = (uint32_t)value;
+}
+
+/// @brief Accounts an observation in a histogram.
+/// @param id Metric.
+/// @param value The value observed.
+void MetricsObserve(MetricId id, uint32_t value)
+{
+    assert_(id < METRIC_COUNT);
+    assert_(METRIC_HISTOGRAM == skMetrics[id]._u8_kind);
+
+    MetricHistogram *ph = &sHist[id];
+    int bin = 0;
+    for(uint32_t v = value >> skMetrics[id]._u8_arg; v && bin < METRICS_HIST_BINS - 1; v >>= 1)
+    {
+        ++bin;
+    }
+    ++ph->_pu32_bins[bin];
+    ++ph->_u32_count;
+    ph->_u32_sum += value;
+    if(value > ph->_u32_max)
+    {
+        ph->_u32_max = value;
+    }
+}
+
+/// @brief Gets a counter or gauge value; a count of observations of a histogram;
+/// @brief the last duration of a timer.
+/// @param id Metric.
+/// @return The value.
+int32_t MetricsGet(MetricId id)
+{
+    assert_(id < METRIC_COUNT);
+
+    switch(skMetrics[id]._u8_kind)
+    {
+        case METRIC_HISTOGRAM:
+        return (int32_t)sHist[id]._u32_count;
+
+        case METRIC_TIMER:
+        return (int32_t)StageTimerGet(skMetrics[id]._u8_arg)->_u32_last;
+
+        default:
+        return (int32_t)spu32_value[id];
+    }
+}
+
+/// @brief Appends a little endian value to the frame being built.
+static void Put8(uint8_t v)
+{
+    assert_(sFrameLen < METRICS_MAX_FRAME);
+    spu8_frame[sFrameLen++] = v;
+}
+
+static void Put16(uint16_t v)
+{
+    Put8(v & 0xFF);
+    Put8(v >> 8);
+}
+
+static void Put32(uint32_t v)
+{
+    Put16(v & 0xFFFF);
+    Put16(v >> 16);
+}
+
+/// @brief Appends a string prefixed by its length.
+static void PutString(const char *ps)
+{
+    const size_t len = strlen(ps);
+    assert_(len < 256);
+    Put8((uint8_t)len);
+    for(size_t i = 0; i < len; ++i)
+    {
+        Put8((uint8_t)ps[i]);
+    }
+}
+
+/// @brief Sends the frame bypassing stdio: no CR/LF translation, USB only.
+static void SendFrame(uint8_t type)
+{
+    const int len = sFrameLen - 5;
+    spu8_frame[0] = METRICS_SYNC;
+    spu8_frame[1] = METRICS_VERSION;
+    spu8_frame[2] = type;
+    spu8_frame[3] = len & 0xFF;
+    spu8_frame[4] = len >> 8;
+
+    uint16_t u16_a = 0, u16_b = 0;
+    for(int i = 5; i < sFrameLen; ++i)
+    {
+        u16_a = (u16_a + spu8_frame[i]) % 255;
+        u16_b = (u16_b + u16_a) % 255;
+    }
+    Put16(u16_b << 8 | u16_a);
+
+#if LIB_PICO_STDIO_USB
+    stdio_flush();
+    stdio_usb.out_chars((const char *)spu8_frame, sFrameLen);
+#endif
+}
+
+/// @brief Checks USB CDC for a request byte. Other bytes are ignored.
+/// @return METRICS_CMD_* or -1 if no request.
+int MetricsPollCommand(void)
+{
+#if LIB_PICO_STDIO_USB
+    char c;
+    while(1 == stdio_usb.in_chars(&c, 1))
+    {
+        if(METRICS_CMD_SNAPSHOT == c || METRICS_CMD_SCHEMA == c)
+        {
+            return c;
+        }
+    }
+#endif
+    return -1;
+}
+
+/// @brief Replies to a request with a snapshot or the schema.
+/// @param cmd METRICS_CMD_*.
+void MetricsReply(int cmd)
+{
+    sFrameLen = 5;
+    if(METRICS_CMD_SCHEMA == cmd)
+    {
+        PutString(spNode);
+        Put8(METRIC_COUNT);
+        for(int i = 0; i < METRIC_COUNT; ++i)
+        {
+            Put8(skMetrics[i]._u8_kind);
+            Put8(skMetrics[i]._u8_arg);
+            PutString(skMetrics[i]._pname);
+        }
+    }
+    else
+    {
+        Put32((uint32_t)(time_us_64() / 1000000ULL));
+        Put8(METRIC_COUNT);
+        for(int i = 0; i < METRIC_COUNT; ++i)
+        {
+            if(METRIC_TIMER == skMetrics[i]._u8_kind)
+            {
+                const StageTimerStats *ps = StageTimerGet(skMetrics[i]._u8_arg);
+                Put32(ps->_u32_count);
+                Put32(ps->_u32_last);
+                Put32(ps->_u32_min);
+                Put32(ps->_u32_max);
+                continue;
+            }
+            if(METRIC_HISTOGRAM != skMetrics[i]._u8_kind)
+            {
+                Put32(spu32_value[i]);
+                continue;
+            }
+            const MetricHistogram *ph = &sHist[i];
+            Put32(ph->_u32_count);
+            Put32(ph->_u32_sum);
+            Put32(ph->_u32_max);
+            for(int j = 0; j < METRICS_HIST_BINS; ++j)
+            {
+                Put32(ph->_pu32_bins[j]);
+            }
+        }
+    }
+
+    SendFrame((uint8_t)cmd);
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  Metrics.h - Runtime metrics registry.
+//
+//  DESCRIPTION
+//      Counters, gauges and log2 histograms of the beacon's health, kept in
+//      a fixed table indexed by MetricId. On request from USB CDC the whole
+//      table is sent as a compact binary snapshot, parsed by
+//      tools/metrics_poll.py.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdint.h>
+
+#define METRICS_HIST_BINS       12          /* log2 bins, the last one is open. */
+#define METRICS_SYNC            0xA5        /* The 1st byte of a reply frame. */
+#define METRICS_VERSION         1
+
+/* Request bytes received from USB CDC. */
+#define METRICS_CMD_SNAPSHOT    'm'
+#define METRICS_CMD_SCHEMA      'M'
+
+typedef enum
+{
+    METRIC_COUNTER = 0,                     /* Monotonic count. */
+    METRIC_GAUGE = 1,                       /* The last value, signed. */
+    METRIC_HISTOGRAM = 2,                   /* Distribution of observations. */
+    METRIC_TIMER = 3                        /* Stage timer, see stagetimer.h. */
+
+} MetricKind;
+
+/* Append only: the id is a position in the snapshot. */
+typedef enum
+{
+    METRIC_FRAMES_SENT = 0,
+    METRIC_SLOTS_MISSED,
+    METRIC_JITTER_MAX_US,                   /* Worst ISR lateness per frame. */
+    METRIC_JITTER_MISSED,                   /* Symbols over the deadline. */
+    METRIC_START_ERROR_US,
+    METRIC_GPS_ERRORS,
+    METRIC_GPS_FIX_AGE_S,
+    METRIC_GPS_PPB,
+    METRIC_FALLBACK_PPB,                    /* Temperature model correction. */
+    METRIC_VSYS_MV,
+    METRIC_TEMP_CENTI,
+    METRIC_ENCODE_US,
+    METRIC_STAGE_CREATE_PACKET,
+    METRIC_STAGE_VSYS_READ,
+    METRIC_STAGE_MESSAGE_FORMAT,
+    METRIC_STAGE_MESSAGE_ENCODE,
+    METRIC_STAGE_TONE_ENCODE,
+    METRIC_STAGE_SEND_PACKET,
+
+    METRIC_COUNT
+
+} MetricId;
+
+typedef struct
+{
+    uint32_t _u32_count;
+    uint32_t _u32_sum;                      /* Wraps, host uses deltas. */
+    uint32_t _u32_max;
+    uint32_t _pu32_bins[METRICS_HIST_BINS];
+
+} MetricHistogram;
+
+typedef struct
+{
+    const char *_pname;
+    uint8_t _u8_kind;                       /* MetricKind. */
+    uint8_t _u8_arg;                        /* Hist.: the 1st bin is < 1 << arg;
+                                               timer: StageId. */
+
+} MetricDescriptor;
+
+void MetricsInit(const char *pnode);
+void MetricsAdd(MetricId id, uint32_t n);
+void MetricsSet(MetricId id, int32_t value);
+void MetricsObserve(MetricId id, uint32_t value);
+int32_t MetricsGet(MetricId id);
+int MetricsPollCommand(void);
+void MetricsReply(int cmd);
+
+#endif
@@ -0,0 +1,456 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  Playlist.c - Message playlist and its slot scheduler.
+//
+//  DESCRIPTION
+//      Holds the messages the beacon sends in turn (CQ, telemetry, free
+//      text) with per-message rules: priority, weight, slot parity, band
+//      and a minimal gap between sends; and per-band gaps. PlaylistNext()
+//      picks the message for a TX slot in O(log n):
+//
+//      - entries which can't go yet wait in a min-heap by the first slot
+//        they are eligible at (own gap, band gap);
+//      - eligible ones sit in a ready heap per slot parity (any, even,
+//        odd), ordered by priority, then by pass of stride scheduling, so
+//        equal priorities share slots in proportion to their weights.
+//
+//      The higher priority always wins when eligible; use gaps to keep it
+//      from taking every slot. Config is text, one rule per line, the same
+//      for the firmware (see main.c) and tools/playlist_sim.c:
+//
+//          band <index> <freq_hz> [gap_slots]
+//          msg <prio> <weight> <any|even|odd> <band|-> <gap> <text|grid|tlm> [message]
+//
+//      A `grid` message is a pattern, `{}` is replaced by a grid telling
+//      battery level. A `tlm` one is a telemetry frame, see Telemetry.h;
+//      its message is just a label.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "Playlist.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+enum
+{
+    PLAYLIST_HEAP_WAITING = 0,
+    PLAYLIST_HEAP_READY
+};
+
+/// @brief Order of a heap: whether entry a goes before entry b.
+static int PlaylistBefore(const PlaylistContext *pctx, int heap, uint8_t a, uint8_t b)
+{
+    const PlaylistEntry *pa = &pctx->_pEntries[a];
+    const PlaylistEntry *pb = &pctx->_pEntries[b];
+
+    if(PLAYLIST_HEAP_WAITING == heap)
+    {
+        if(pa->_u64_eligible_slot != pb->_u64_eligible_slot)
+        {
+            return pa->_u64_eligible_slot < pb->_u64_eligible_slot;
+        }
+    }
+    else
+    {
+        if(pa->_u8_priority != pb->_u8_priority)
+        {
+            return pa->_u8_priority > pb->_u8_priority;
+        }
+        if(pa->_u32_pass != pb->_u32_pass)
+        {
+            return (int32_t)(pa->_u32_pass - pb->_u32_pass) < 0;
+        }
+    }
+
+    return a < b;                           /* Config order breaks ties. */
+}
+
+static void PlaylistHeapPush(const PlaylistContext *pctx, int heap, uint8_t *pheap,
+                             uint8_t *pn, uint8_t ix)
+{
+    int i = (*pn)++;
+    while(i)
+    {
+        const int parent = (i - 1) >> 1;
+        if(!PlaylistBefore(pctx, heap, ix, pheap[parent]))
+        {
+            break;
+        }
+        pheap[i] = pheap[parent];
+        i = parent;
+    }
+    pheap[i] = ix;
+}
+
+static uint8_t PlaylistHeapPop(const PlaylistContext *pctx, int heap, uint8_t *pheap, uint8_t *pn)
+{
+    const uint8_t top = pheap[0];
+    const int n = --*pn;
+    if(!n)
+    {
+        return top;
+    }
+
+    const uint8_t last = pheap[n];
+    int i = 0;
+    for(;;)
+    {
+        int child = 2 * i + 1;
+        if(child >= n)
+        {
+            break;
+        }
+        if(child + 1 < n && PlaylistBefore(pctx, heap, pheap[child + 1], pheap[child]))
+        {
+            ++child;
+        }
+        if(!PlaylistBefore(pctx, heap, pheap[child], last))
+        {
+            break;
+        }
+        pheap[i] = pheap[child];
+        i = child;
+    }
+    pheap[i] = last;
+
+    return top;
+}
+
+static void PlaylistWait(PlaylistContext *pctx, uint8_t ix)
+{
+    PlaylistHeapPush(pctx, PLAYLIST_HEAP_WAITING, pctx->_pu8_waiting, &pctx->_u8_nwaiting, ix);
+}
+
+/// @brief Initializes an empty playlist.
+/// @return the Context.
+PlaylistContext *PlaylistInit(void)
+{
+    PlaylistContext *p = calloc(1, sizeof(PlaylistContext));
+    assert_(p);
+
+    return p;
+}
+
+/// @brief Sets a band messages may be bound to.
+/// @param pctx Context.
+/// @param band Band index, 0..PLAYLIST_MAX_BANDS-1.
+/// @param u32_freq_hz TX dial freq. incl. shift, Hz.
+/// @param gap_slots Min. slots between two frames on the band, 0 - none.
+/// @return 0 if OK, -1 if the index or freq. is wrong.
+int PlaylistAddBand(PlaylistContext *pctx, uint8_t band, uint32_t u32_freq_hz, uint16_t gap_slots)
+{
+    assert_(pctx);
+
+    if(band >= PLAYLIST_MAX_BANDS || !u32_freq_hz)
+    {
+        return -1;
+    }
+
+    pctx->_pBands[band]._u32_freq_hz = u32_freq_hz;
+    pctx->_pBands[band]._u16_gap_slots = gap_slots;
+    pctx->_pBands[band]._u64_free_slot = 0;
+    if(band >= pctx->_u8_nbands)
+    {
+        pctx->_u8_nbands = band + 1;
+    }
+
+    return 0;
+}
+
+/// @brief Adds a message. It's eligible at once, with the pass of the
+/// @brief last pick, so it doesn't take over slots to catch up.
+/// @param pctx Context.
+/// @param pentry Message and its rules; the state fields are ignored.
+/// @return Index of the message, or -1 if it's wrong or playlist is full.
+int PlaylistAdd(PlaylistContext *pctx, const PlaylistEntry *pentry)
+{
+    assert_(pctx);
+    assert_(pentry);
+
+    if(pctx->_u8_nentries >= PLAYLIST_MAX_ENTRIES || !pentry->_u8_weight
+       || pentry->_u8_parity >= PLAYLIST_NPARITIES
+       || (PLAYLIST_BAND_DEFAULT != pentry->_u8_band
+           && (pentry->_u8_band >= pctx->_u8_nbands || !pctx->_pBands[pentry->_u8_band]._u32_freq_hz))
+       || !memchr(pentry->_pc_text, '\0', PLAYLIST_TEXT_LEN)
+       || pentry->_u8_kind > PLAYLIST_KIND_TELEMETRY
+       || (PLAYLIST_KIND_PATTERN == pentry->_u8_kind && !strstr(pentry->_pc_text, PLAYLIST_FIELD)))
+    {
+        return -1;
+    }
+
+    const uint8_t ix = pctx->_u8_nentries++;
+    PlaylistEntry *pe = &pctx->_pEntries[ix];
+    *pe = *pentry;
+    pe->_u32_pass = pctx->_u32_vtime;
+    pe->_u64_eligible_slot = 0;
+    pe->_u32_nsent = 0;
+    PlaylistWait(pctx, ix);
+
+    return ix;
+}
+
+/// @brief Parses one line of config, see Playlist.h.
+/// @param pctx Context.
+/// @param pline Line; empty ones and `#` comments are skipped.
+/// @return 0 if OK, -1 on a syntax error or a rule rejected.
+int PlaylistParseLine(PlaylistContext *pctx, const char *pline)
+{
+    assert_(pctx);
+    assert_(pline);
+
+    while(isspace((unsigned char)*pline))
+    {
+        ++pline;
+    }
+    if(!*pline || '#' == *pline)
+    {
+        return 0;
+    }
+
+    if(!strncmp(pline, "band", 4) && isspace((unsigned char)pline[4]))
+    {
+        unsigned band, gap = 0;
+        unsigned long freq;
+        if(sscanf(pline + 4, "%u %lu %u", &band, &freq, &gap) < 2 || band > 0xFF || gap > UINT16_MAX)
+        {
+            return -1;
+        }
+        return PlaylistAddBand(pctx, (uint8_t)band, (uint32_t)freq, (uint16_t)gap);
+    }
+
+    if(strncmp(pline, "msg", 3) || !isspace((unsigned char)pline[3]))
+    {
+        return -1;
+    }
+
+    unsigned prio, weight, gap;
+    char parity[5], band[4], kind[5];
+    int pos = 0;
+    if(6 != sscanf(pline + 3, "%u %u %4s %3s %u %4s %n", &prio, &weight, parity, band, &gap, kind, &pos)
+       || !pos || prio > 0xFF || weight > 0xFF || gap > UINT16_MAX)
+    {
+        return -1;
+    }
+
+    PlaylistEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry._u8_priority = (uint8_t)prio;
+    entry._u8_weight = (uint8_t)weight;
+    entry._u16_gap_slots = (uint16_t)gap;
+
+    if(!strcmp(parity, "any"))
+    {
+        entry._u8_parity = PLAYLIST_PARITY_ANY;
+    }
+    else if(!strcmp(parity, "even"))
+    {
+        entry._u8_parity = PLAYLIST_PARITY_EVEN;
+    }
+    else if(!strcmp(parity, "odd"))
+    {
+        entry._u8_parity = PLAYLIST_PARITY_ODD;
+    }
+    else
+    {
+        return -1;
+    }
+
+    if(!strcmp(band, "-"))
+    {
+        entry._u8_band = PLAYLIST_BAND_DEFAULT;
+    }
+    else
+    {
+        char *pend;
+        const unsigned long u32_band = strtoul(band, &pend, 10);
+        if(pend == band || *pend || u32_band > PLAYLIST_MAX_BANDS - 1)
+        {
+            return -1;
+        }
+        entry._u8_band = (uint8_t)u32_band;
+    }
+
+    if(!strcmp(kind, "text"))
+    {
+        entry._u8_kind = PLAYLIST_KIND_TEXT;
+    }
+    else if(!strcmp(kind, "grid"))
+    {
+        entry._u8_kind = PLAYLIST_KIND_PATTERN;
+    }
+    else if(!strcmp(kind, "tlm"))
+    {
+        entry._u8_kind = PLAYLIST_KIND_TELEMETRY;
+    }
+    else
+    {
+        return -1;
+    }
+
+    /* The rest of line is the message, upper case as ft8 packs it. */
+    const char *ptext = pline + 3 + pos;
+    size_t len = strcspn(ptext, "\r\n");
+    while(len && isspace((unsigned char)ptext[len - 1]))
+    {
+        --len;
+    }
+    if((!len && PLAYLIST_KIND_TELEMETRY != entry._u8_kind) || len >= PLAYLIST_TEXT_LEN)
+    {
+        return -1;
+    }
+    for(size_t i = 0; i < len; ++i)
+    {
+        entry._pc_text[i] = (char)toupper((unsigned char)ptext[i]);
+    }
+
+    return PlaylistAdd(pctx, &entry) < 0 ? -1 : 0;
+}
+
+/// @brief Makes every message and band eligible from the slot given,
+/// @brief forgets the history of picks. E.g. after the clock has jumped.
+/// @param pctx Context.
+/// @param u64_slot Slot index.
+void PlaylistReset(PlaylistContext *pctx, uint64_t u64_slot)
+{
+    assert_(pctx);
+
+    pctx->_u8_nwaiting = 0;
+    memset(pctx->_pu8_nready, 0, sizeof(pctx->_pu8_nready));
+    pctx->_u32_vtime = 0;
+
+    for(uint8_t i = 0; i < pctx->_u8_nbands; ++i)
+    {
+        pctx->_pBands[i]._u64_free_slot = u64_slot;
+    }
+    for(uint8_t i = 0; i < pctx->_u8_nentries; ++i)
+    {
+        pctx->_pEntries[i]._u32_pass = 0;
+        pctx->_pEntries[i]._u64_eligible_slot = u64_slot;
+        PlaylistWait(pctx, i);
+    }
+}
+
+/// @brief Picks the message to send in a TX slot and accounts it.
+/// @brief O(log n), amortized over messages bounced by a busy band.
+/// @param pctx Context.
+/// @param u64_slot Slot index (counted from unix epoch); must not decrease
+/// @param between calls.
+/// @return The message, or NULL if none may go in this slot.
+const PlaylistEntry *PlaylistNext(PlaylistContext *pctx, uint64_t u64_slot)
+{
+    assert_(pctx);
+
+    /* Messages whose gap is over get ready. Ones which waited don't keep
+       their old pass, or they would take a row of slots to catch up. */
+    while(pctx->_u8_nwaiting
+          && pctx->_pEntries[pctx->_pu8_waiting[0]]._u64_eligible_slot <= u64_slot)
+    {
+        const uint8_t ix = PlaylistHeapPop(pctx, PLAYLIST_HEAP_WAITING, pctx->_pu8_waiting,
+                                           &pctx->_u8_nwaiting);
+        PlaylistEntry *pe = &pctx->_pEntries[ix];
+        if((int32_t)(pe->_u32_pass - pctx->_u32_vtime) < 0)
+        {
+            pe->_u32_pass = pctx->_u32_vtime;
+        }
+        PlaylistHeapPush(pctx, PLAYLIST_HEAP_READY, pctx->_pu8_ready[pe->_u8_parity],
+                         &pctx->_pu8_nready[pe->_u8_parity], ix);
+    }
+
+    const int parity = (u64_slot & 1) ? PLAYLIST_PARITY_ODD : PLAYLIST_PARITY_EVEN;
+    for(;;)
+    {
+        int heap = -1;
+        if(pctx->_pu8_nready[PLAYLIST_PARITY_ANY])
+        {
+            heap = PLAYLIST_PARITY_ANY;
+        }
+        if(pctx->_pu8_nready[parity]
+           && (heap < 0 || PlaylistBefore(pctx, PLAYLIST_HEAP_READY, pctx->_pu8_ready[parity][0],
+                                          pctx->_pu8_ready[PLAYLIST_PARITY_ANY][0])))
+        {
+            heap = parity;
+        }
+        if(heap < 0)
+        {
+            return NULL;
+        }
+
+        const uint8_t ix = PlaylistHeapPop(pctx, PLAYLIST_HEAP_READY, pctx->_pu8_ready[heap],
+                                           &pctx->_pu8_nready[heap]);
+        PlaylistEntry *pe = &pctx->_pEntries[ix];
+        PlaylistBand *pband = PLAYLIST_BAND_DEFAULT == pe->_u8_band ? NULL : &pctx->_pBands[pe->_u8_band];
+
+        if(pband && pband->_u64_free_slot > u64_slot)
+        {
+            /* Its band is busy, wait for the band. */
+            pe->_u64_eligible_slot = pband->_u64_free_slot;
+            PlaylistWait(pctx, ix);
+            continue;
+        }
+
+        pctx->_u32_vtime = pe->_u32_pass;
+        pe->_u32_pass += PLAYLIST_STRIDE / pe->_u8_weight;
+        pe->_u64_eligible_slot = u64_slot + 1 + pe->_u16_gap_slots;
+        ++pe->_u32_nsent;
+        if(pband)
+        {
+            pband->_u64_free_slot = u64_slot + 1 + pband->_u16_gap_slots;
+        }
+        PlaylistWait(pctx, ix);
+
+        return pe;
+    }
+}
+
+/// @brief Gets TX dial freq. of a message.
+/// @param pctx Context.
+/// @param pentry Message.
+/// @return Freq. incl. shift, Hz; 0 - beacon's own one.
+uint32_t PlaylistFreqHz(const PlaylistContext *pctx, const PlaylistEntry *pentry)
+{
+    assert_(pctx);
+    assert_(pentry);
+
+    return PLAYLIST_BAND_DEFAULT == pentry->_u8_band ? 0 : pctx->_pBands[pentry->_u8_band]._u32_freq_hz;
+}
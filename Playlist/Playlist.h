@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  Playlist.h - Message playlist and its slot scheduler.
+//
+//  DESCRIPTION
+//      Holds the messages the beacon sends in turn (CQ, telemetry, free
+//      text) with per-message rules: priority, weight, slot parity, band
+//      and a minimal gap between sends; and per-band gaps. PlaylistNext()
+//      picks the message for a TX slot in O(log n):
+//
+//      - entries which can't go yet wait in a min-heap by the first slot
+//        they are eligible at (own gap, band gap);
+//      - eligible ones sit in a ready heap per slot parity (any, even,
+//        odd), ordered by priority, then by pass of stride scheduling, so
+//        equal priorities share slots in proportion to their weights.
+//
+//      The higher priority always wins when eligible; use gaps to keep it
+//      from taking every slot. Config is text, one rule per line, the same
+//      for the firmware (see main.c) and tools/playlist_sim.c:
+//
+//          band <index> <freq_hz> [gap_slots]
+//          msg <prio> <weight> <any|even|odd> <band|-> <gap> <text|grid|tlm> [message]
+//
+//      A `grid` message is a pattern, `{}` is replaced by a grid telling
+//      battery level. A `tlm` one is a telemetry frame, see Telemetry.h;
+//      its message is just a label.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef PLAYLIST_H_
+#define PLAYLIST_H_
+
+#include <stdint.h>
+
+#ifdef PLAYLIST_HOST
+#include <assert.h>
+#define assert_ assert
+#else
+#include "../pico-hf-oscillator/lib/assert.h"
+#endif
+
+#define PLAYLIST_MAX_ENTRIES    16
+#define PLAYLIST_MAX_BANDS      4
+#define PLAYLIST_TEXT_LEN       36          /* FTX_MAX_MESSAGE_LENGTH + 1. */
+#define PLAYLIST_STRIDE         0x10000UL   /* Pass step of weight 1. */
+#define PLAYLIST_BAND_DEFAULT   0xFF        /* Beacon's own dial freq. */
+#define PLAYLIST_FIELD          "{}"        /* Telemetry field of a pattern. */
+
+enum
+{
+    PLAYLIST_KIND_TEXT = 0,                 /* Sent as is. */
+    PLAYLIST_KIND_PATTERN,                  /* PLAYLIST_FIELD is filled in with a grid. */
+    PLAYLIST_KIND_TELEMETRY                 /* Binary telemetry, text is a label. */
+};
+
+enum
+{
+    PLAYLIST_PARITY_ANY = 0,                /* Same values as WSPR_SLOT_*. */
+    PLAYLIST_PARITY_EVEN,
+    PLAYLIST_PARITY_ODD,
+    PLAYLIST_NPARITIES
+};
+
+typedef struct
+{
+    char _pc_text[PLAYLIST_TEXT_LEN];
+    uint8_t _u8_kind;                       /* PLAYLIST_KIND_* */
+    uint8_t _u8_priority;                   /* Higher goes first. */
+    uint8_t _u8_weight;                     /* Share of slots among equal priority. */
+    uint8_t _u8_parity;                     /* PLAYLIST_PARITY_* */
+    uint8_t _u8_band;                       /* Band index or PLAYLIST_BAND_DEFAULT. */
+    uint16_t _u16_gap_slots;                /* Min. slots between two sends. */
+
+    uint32_t _u32_pass;                     /* Stride scheduling virtual time. */
+    uint64_t _u64_eligible_slot;            /* First slot it may go at. */
+    uint32_t _u32_nsent;
+
+} PlaylistEntry;
+
+typedef struct
+{
+    uint32_t _u32_freq_hz;                  /* TX dial freq. incl. shift. */
+    uint16_t _u16_gap_slots;                /* Min. slots between two frames. */
+    uint64_t _u64_free_slot;                /* First slot it may be used at. */
+
+} PlaylistBand;
+
+typedef struct
+{
+    PlaylistEntry _pEntries[PLAYLIST_MAX_ENTRIES];
+    uint8_t _u8_nentries;
+    PlaylistBand _pBands[PLAYLIST_MAX_BANDS];
+    uint8_t _u8_nbands;
+
+    uint8_t _pu8_waiting[PLAYLIST_MAX_ENTRIES];         /* Heap by eligible slot. */
+    uint8_t _u8_nwaiting;
+    uint8_t _pu8_ready[PLAYLIST_NPARITIES][PLAYLIST_MAX_ENTRIES]; /* Heaps by prio, pass. */
+    uint8_t _pu8_nready[PLAYLIST_NPARITIES];
+
+    uint32_t _u32_vtime;                    /* Pass of the last pick. */
+
+} PlaylistContext;
+
+PlaylistContext *PlaylistInit(void);
+int PlaylistAddBand(PlaylistContext *pctx, uint8_t band, uint32_t u32_freq_hz, uint16_t gap_slots);
+int PlaylistAdd(PlaylistContext *pctx, const PlaylistEntry *pentry);
+int PlaylistParseLine(PlaylistContext *pctx, const char *pline);
+void PlaylistReset(PlaylistContext *pctx, uint64_t u64_slot);
+
+const PlaylistEntry *PlaylistNext(PlaylistContext *pctx, uint64_t u64_slot);
+uint32_t PlaylistFreqHz(const PlaylistContext *pctx, const PlaylistEntry *pentry);
+
+#endif
@@ -0,0 +1,242 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  PowerMgr.c - Low power periods between TX slots.
+//
+//  DESCRIPTION
+//      Stops the DCO and core1, runs sys clock from USB PLL at 48 MHz and
+//      sleeps in WFE until a given time ahead of the next slot. Restores
+//      clocks and relaunches the DCO worker afterwards. Accounts time spent
+//      in each power state. The timer runs from clk_ref (XOSC) and isn't
+//      affected by sys clock changes, so GPS time keeping and slot alarms
+//      stay intact. True DORMANT mode would stop XOSC together with the
+//      timer and the GPS UART, so it isn't used.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "PowerMgr.h"
+#include <stdlib.h>
+#include "pico/multicore.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include <defines.h>
+#include <protos.h>
+
+#include "debug/logutils.h"
+
+/// @brief Accounts the time of the current state and switches to a new one.
+/// @param pctx Context.
+/// @param state New state.
+static void PowerMgrEnter(PowerMgrContext *pctx, uint8_t state)
+{
+    const uint64_t u64_now = time_us_64();
+    pctx->_pu64_state_us[pctx->_u8_state] += u64_now - pctx->_u64_state_since_us;
+    pctx->_u64_state_since_us = u64_now;
+    pctx->_u8_state = state;
+}
+
+/// @brief Sets UART bauds again, since clk_peri has just been changed.
+/// @param pctx Context.
+static void PowerMgrSetBauds(PowerMgrContext *pctx)
+{
+    if(pctx->_gps_uart)
+    {
+        uart_set_baudrate(pctx->_gps_uart, pctx->_u32_gps_baud);
+    }
+#if LIB_PICO_STDIO_UART
+    uart_set_baudrate(PICO_DEFAULT_UART_INSTANCE(), PICO_DEFAULT_UART_BAUD_RATE);
+#endif
+}
+
+/// @brief Wakes the sleep loop up. The IRQ itself does the job.
+static int64_t PowerMgrAlarm(alarm_id_t id, void *user_data)
+{
+    __sev();
+    return 0;
+}
+
+/// @brief Initializes power manager.
+/// @param pDCO DCO to stop before sleep.
+/// @param core1_resume Core1 entry which relaunches DCO worker after sleep.
+/// @param gps_uart GPS receiver UART (or NULL).
+/// @param gps_baud GPS receiver baud rate.
+/// @return the Context.
+PowerMgrContext *PowerMgrInit(PioDco *pDCO, void (*core1_resume)(void),
+                              uart_inst_t *gps_uart, uint32_t gps_baud)
+{
+    assert_(pDCO);
+    assert_(core1_resume);
+
+    PowerMgrContext *p = calloc(1, sizeof(PowerMgrContext));
+    assert_(p);
+
+    p->_pDCO = pDCO;
+    p->_core1_resume = core1_resume;
+    p->_gps_uart = gps_uart;
+    p->_u32_gps_baud = gps_baud;
+
+    p->_u8_state = POWER_RUN;
+    p->_u64_state_since_us = time_us_64();
+
+    return p;
+}
+
+/// @brief Sleeps in WFE at full clock until any IRQ or SEV.
+/// @param pctx Context.
+void PowerMgrWaitForEvent(PowerMgrContext *pctx)
+{
+    assert_(pctx);
+
+    PowerMgrEnter(pctx, POWER_IDLE);
+    __wfe();
+    ++pctx->_pu32_wakeups[POWER_IDLE];
+    PowerMgrEnter(pctx, POWER_RUN);
+}
+
+/// @brief Enters low power state until the given time (or *pabort is set
+/// @brief by an IRQ). Stops the DCO and core1, lowers sys clock.
+/// @brief On return, clocks are restored and DCO worker is relaunched, but
+/// @brief the DCO output stays stopped.
+/// @param pctx Context.
+/// @param u64_until_us Wake up time, us since boot. Should include
+/// @param u64_until_us POWER_WAKE_MARGIN_US ahead of the deadline.
+/// @param pabort Ptr to a flag to wake up earlier (or NULL).
+/// @return 0 if slept, -1 if the period is too short to bother.
+int PowerMgrSleepUntil(PowerMgrContext *pctx, uint64_t u64_until_us,
+                       volatile bool *pabort)
+{
+    assert_(pctx);
+
+    if(u64_until_us < time_us_64() + POWER_MIN_SLEEP_US)
+    {
+        return -1;
+    }
+
+    PioDCOStop(pctx->_pDCO);
+    multicore_reset_core1();
+
+    /* 48 MHz from pll_usb: pll_sys is switched off, which a lower
+       set_sys_clock_khz() wouldn't do. clk_peri follows clk_sys. */
+    set_sys_clock_48mhz();
+    PowerMgrSetBauds(pctx);
+
+    const alarm_id_t alarm = add_alarm_at(from_us_since_boot(u64_until_us),
+                                          PowerMgrAlarm, NULL, true);
+
+    ++pctx->_u32_sleep_count;
+    PowerMgrEnter(pctx, POWER_SLEEP);
+    while(time_us_64() < u64_until_us && !(pabort && *pabort))
+    {
+        __wfe();
+        ++pctx->_pu32_wakeups[POWER_SLEEP];
+    }
+    PowerMgrEnter(pctx, POWER_RUN);
+
+    if(alarm > 0)
+    {
+        cancel_alarm(alarm);
+    }
+
+    const uint64_t u64_t0 = time_us_64();
+    InitPicoClocks();
+    PowerMgrSetBauds(pctx);
+    multicore_launch_core1(pctx->_core1_resume);
+
+    const uint32_t u32_wake_us = (uint32_t)(time_us_64() - u64_t0);
+    if(u32_wake_us > pctx->_u32_wake_max_us)
+    {
+        pctx->_u32_wake_max_us = u32_wake_us;
+    }
+
+    return 0;
+}
+
+/// @brief Gets total time spent in a state, including the current period.
+/// @param pctx Context.
+/// @param state The state.
+/// @return Time, us.
+uint64_t PowerMgrGetStateTime(PowerMgrContext *pctx, int state)
+{
+    assert_(pctx);
+    assert_(state < POWER_NSTATES);
+
+    uint64_t u64_us = pctx->_pu64_state_us[state];
+    if(state == pctx->_u8_state)
+    {
+        u64_us += time_us_64() - pctx->_u64_state_since_us;
+    }
+
+    return u64_us;
+}
+
+/// @brief Prints time-in-state stats (ms) in a grep-friendly form:
+/// @brief PWR> run:<ms> idle:<ms> sleep:<ms> n:<sleeps> wake:<us> duty:<%>
+/// @brief wk:<idle wakeups>,<sleep wakeups> wkps:<wakeups/s of WFE>
+/// @brief Background IRQs (AdcSampler, GPS UART, USB) wake core0 too;
+/// @brief wkps shows what they cost while nothing is to be done.
+/// @param pctx Context.
+void PowerMgrDumpStats(PowerMgrContext *pctx)
+{
+    assert_(pctx);
+
+    uint64_t pu64_ms[POWER_NSTATES];
+    uint64_t u64_total = 0;
+    for(int i = 0; i < POWER_NSTATES; ++i)
+    {
+        pu64_ms[i] = PowerMgrGetStateTime(pctx, i) / 1000ULL;
+        u64_total += pu64_ms[i];
+    }
+
+    /* Share of time at full clock with core0 awake, 0.1%. */
+    const uint32_t u32_duty = u64_total ? (uint32_t)(pu64_ms[POWER_RUN] * 1000ULL / u64_total) : 0;
+
+    /* Wakeups per second of WFE, 0.1/s. */
+    const uint64_t u64_wfe_ms = pu64_ms[POWER_IDLE] + pu64_ms[POWER_SLEEP];
+    const uint32_t u32_nwakeups = pctx->_pu32_wakeups[POWER_IDLE] + pctx->_pu32_wakeups[POWER_SLEEP];
+    const uint32_t u32_wkps = u64_wfe_ms ? (uint32_t)(u32_nwakeups * 10000ULL / u64_wfe_ms) : 0;
+
+    StampPrintf("PWR> run:%llu idle:%llu sleep:%llu n:%lu wake:%lu duty:%lu.%lu wk:%lu,%lu wkps:%lu.%lu",
+                pu64_ms[POWER_RUN], pu64_ms[POWER_IDLE], pu64_ms[POWER_SLEEP],
+                pctx->_u32_sleep_count, pctx->_u32_wake_max_us,
+                u32_duty / 10, u32_duty % 10,
+                pctx->_pu32_wakeups[POWER_IDLE], pctx->_pu32_wakeups[POWER_SLEEP],
+                u32_wkps / 10, u32_wkps % 10);
+}
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  PowerMgr.h - Low power periods between TX slots.
+//
+//  DESCRIPTION
+//      Stops the DCO and core1, runs sys clock from USB PLL at 48 MHz and
+//      sleeps in WFE until a given time ahead of the next slot. Restores
+//      clocks and relaunches the DCO worker afterwards. Accounts time spent
+//      in each power state.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef POWERMGR_H_
+#define POWERMGR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+#include "../pico-hf-oscillator/lib/assert.h"
+#include <piodco.h>
+
+#define POWER_MIN_SLEEP_US      3000000ULL  /* Don't lower clocks for less. */
+#define POWER_WAKE_MARGIN_US    500000ULL   /* PLL relock, core1 start, GPS UART. */
+
+enum
+{
+    POWER_RUN = 0,                          /* Core0 busy at full clock. */
+    POWER_IDLE,                             /* Core0 in WFE at full clock. */
+    POWER_SLEEP,                            /* Low clock, core1 & DCO stopped. */
+    POWER_NSTATES
+};
+
+typedef struct
+{
+    PioDco *_pDCO;                          /* DCO to stop before sleep. */
+    void (*_core1_resume)(void);            /* Relaunches DCO worker on core1. */
+    uart_inst_t *_gps_uart;                 /* Its baud depends on clk_peri. */
+    uint32_t _u32_gps_baud;
+
+    uint8_t _u8_state;
+    uint64_t _u64_state_since_us;
+    uint64_t _pu64_state_us[POWER_NSTATES]; /* Time spent in each state. */
+    uint32_t _pu32_wakeups[POWER_NSTATES];  /* WFE returns in each state. */
+
+    uint32_t _u32_sleep_count;
+    uint32_t _u32_wake_max_us;              /* Worst clock & core1 restore time. */
+
+} PowerMgrContext;
+
+PowerMgrContext *PowerMgrInit(PioDco *pDCO, void (*core1_resume)(void),
+                              uart_inst_t *gps_uart, uint32_t gps_baud);
+
+void PowerMgrWaitForEvent(PowerMgrContext *pctx);
+int PowerMgrSleepUntil(PowerMgrContext *pctx, uint64_t u64_until_us,
+                       volatile bool *pabort);
+
+uint64_t PowerMgrGetStateTime(PowerMgrContext *pctx, int state);
+void PowerMgrDumpStats(PowerMgrContext *pctx);
+
+#endif
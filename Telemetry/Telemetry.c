@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  Telemetry.c - Beacon telemetry schema.
+//
+//  DESCRIPTION
+//      Packs beacon state into the 71 bits of an FT8/FT4 telemetry message
+//      (i3.n3 = 0.5), which WSJT-X shows as 18 hex digits, and unpacks it
+//      back. Far more than a battery level hidden in the grid square fits
+//      in one slot. Fields from the most significant bit:
+//
+//          version      3   TELEMETRY_VERSION
+//          flags        3   TELEMETRY_FLAG_*
+//          VSYS        10   10 mV
+//          temperature  8   0.5 C, from -40 C
+//          correction  15   ppb, signed
+//          uptime      18   minutes
+//          frames sent 14   wraps
+//
+//      Values out of range are saturated.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "Telemetry.h"
+#include <string.h>
+
+/* Field widths, from the most significant bit. */
+enum
+{
+    TLM_BITS_VERSION = 3,
+    TLM_BITS_FLAGS = 3,
+    TLM_BITS_VSYS = 10,
+    TLM_BITS_TEMP = 8,
+    TLM_BITS_PPB = 15,
+    TLM_BITS_UPTIME = 18,
+    TLM_BITS_NSENT = 14
+};
+
+/// @brief Clamps a value to the range of an unsigned field.
+static uint32_t TelemetryClamp(int64_t i64_value, int nbits)
+{
+    const int64_t i64_max = (1LL << nbits) - 1;
+
+    return (uint32_t)(i64_value < 0 ? 0 : i64_value > i64_max ? i64_max : i64_value);
+}
+
+/// @brief Writes a field MSB first. Bit 0 is the MSB of pb71[0], unused.
+static void TelemetryPut(uint8_t *pb71, int *pipos, uint32_t u32_value, int nbits)
+{
+    for(int i = nbits - 1; i >= 0; --i, ++*pipos)
+    {
+        if(u32_value >> i & 1U)
+        {
+            pb71[*pipos >> 3] |= 0x80U >> (*pipos & 7);
+        }
+    }
+}
+
+/// @brief Reads a field MSB first.
+static uint32_t TelemetryGet(const uint8_t *pb71, int *pipos, int nbits)
+{
+    uint32_t u32_value = 0;
+    for(int i = 0; i < nbits; ++i, ++*pipos)
+    {
+        u32_value = u32_value << 1 | (pb71[*pipos >> 3] >> (7 - (*pipos & 7)) & 1U);
+    }
+
+    return u32_value;
+}
+
+/// @brief Packs a record into telemetry message bits.
+/// @param prec Record.
+/// @param pb71 Ptr to TELEMETRY_BYTES to write, see ftx_message_encode_telemetry.
+void TelemetryPack(const TelemetryRecord *prec, uint8_t *pb71)
+{
+    assert_(prec);
+    assert_(pb71);
+
+    memset(pb71, 0, TELEMETRY_BYTES);
+
+    /* Temperature rounds to the nearest 0.5 C, ppb is offset to unsigned. */
+    const int64_t i64_temp = ((int64_t)prec->_i32_temp_centi - TELEMETRY_TEMP_MIN + 25) / 50;
+    const int64_t i64_ppb_half = 1LL << (TLM_BITS_PPB - 1);
+    int64_t i64_ppb = prec->_i32_ppb;
+    if(i64_ppb >= i64_ppb_half)
+    {
+        i64_ppb = i64_ppb_half - 1;
+    }
+    else if(i64_ppb < -i64_ppb_half)
+    {
+        i64_ppb = -i64_ppb_half;
+    }
+
+    int ipos = 1;
+    TelemetryPut(pb71, &ipos, TELEMETRY_VERSION, TLM_BITS_VERSION);
+    TelemetryPut(pb71, &ipos, prec->_u8_flags, TLM_BITS_FLAGS);
+    TelemetryPut(pb71, &ipos, TelemetryClamp((prec->_u32_vsys_mv + 5) / 10, TLM_BITS_VSYS), TLM_BITS_VSYS);
+    TelemetryPut(pb71, &ipos, TelemetryClamp(i64_temp, TLM_BITS_TEMP), TLM_BITS_TEMP);
+    TelemetryPut(pb71, &ipos, (uint32_t)(i64_ppb + i64_ppb_half), TLM_BITS_PPB);
+    TelemetryPut(pb71, &ipos, TelemetryClamp(prec->_u32_uptime_s / 60, TLM_BITS_UPTIME), TLM_BITS_UPTIME);
+    TelemetryPut(pb71, &ipos, prec->_u32_nsent & ((1UL << TLM_BITS_NSENT) - 1), TLM_BITS_NSENT);
+
+    assert_(8 * TELEMETRY_BYTES == ipos);
+}
+
+/// @brief Unpacks telemetry message bits into a record.
+/// @param pb71 Ptr to TELEMETRY_BYTES, see ftx_message_decode_telemetry.
+/// @param prec Ptr to write the record. Uptime has a minute resolution.
+/// @return 0 if OK, -1 if it's another schema version.
+int TelemetryUnpack(const uint8_t *pb71, TelemetryRecord *prec)
+{
+    assert_(pb71);
+    assert_(prec);
+
+    int ipos = 1;
+    if(TELEMETRY_VERSION != TelemetryGet(pb71, &ipos, TLM_BITS_VERSION))
+    {
+        return -1;
+    }
+
+    prec->_u8_flags = (uint8_t)TelemetryGet(pb71, &ipos, TLM_BITS_FLAGS);
+    prec->_u32_vsys_mv = TelemetryGet(pb71, &ipos, TLM_BITS_VSYS) * 10;
+    prec->_i32_temp_centi = (int32_t)TelemetryGet(pb71, &ipos, TLM_BITS_TEMP) * 50 + TELEMETRY_TEMP_MIN;
+    prec->_i32_ppb = (int32_t)TelemetryGet(pb71, &ipos, TLM_BITS_PPB) - (1L << (TLM_BITS_PPB - 1));
+    prec->_u32_uptime_s = TelemetryGet(pb71, &ipos, TLM_BITS_UPTIME) * 60;
+    prec->_u32_nsent = TelemetryGet(pb71, &ipos, TLM_BITS_NSENT);
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  Telemetry.h - Beacon telemetry schema.
+//
+//  DESCRIPTION
+//      Packs beacon state into the 71 bits of an FT8/FT4 telemetry message
+//      (i3.n3 = 0.5), which WSJT-X shows as 18 hex digits, and unpacks it
+//      back. Far more than a battery level hidden in the grid square fits
+//      in one slot. Fields from the most significant bit:
+//
+//          version      3   TELEMETRY_VERSION
+//          flags        3   TELEMETRY_FLAG_*
+//          VSYS        10   10 mV
+//          temperature  8   0.5 C, from -40 C
+//          correction  15   ppb, signed
+//          uptime      18   minutes
+//          frames sent 14   wraps
+//
+//      Values out of range are saturated.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+
+#ifdef TELEMETRY_HOST
+#include <assert.h>
+#define assert_ assert
+#else
+#include "../pico-hf-oscillator/lib/assert.h"
+#endif
+
+#define TELEMETRY_VERSION       1
+#define TELEMETRY_BYTES         9           /* 71 bits right-aligned, as ft8 message.h. */
+#define TELEMETRY_TEMP_MIN      (-4000)     /* 0.01 C. */
+
+enum
+{
+    TELEMETRY_FLAG_GPS = 1,                 /* GPS solution active. */
+    TELEMETRY_FLAG_ADC = 2,                 /* VSYS & temperature are valid. */
+    TELEMETRY_FLAG_FALLBACK = 4             /* Correction is predicted, not GPS one. */
+};
+
+typedef struct
+{
+    uint8_t _u8_flags;                      /* TELEMETRY_FLAG_* */
+    uint32_t _u32_vsys_mv;
+    int32_t _i32_temp_centi;
+    int32_t _i32_ppb;                       /* Crystal correction. */
+    uint32_t _u32_uptime_s;
+    uint32_t _u32_nsent;                    /* Frames sent. */
+
+} TelemetryRecord;
+
+void TelemetryPack(const TelemetryRecord *prec, uint8_t *pb71);
+int TelemetryUnpack(const uint8_t *pb71, TelemetryRecord *prec);
+
+#endif
@@ -0,0 +1,321 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  TempComp.c - Temperature compensation of DCO frequency.
+//
+//  DESCRIPTION
+//      Learns crystal frequency error (ppb) vs. on-chip temperature while
+//      GPS solution is valid: weighted least squares fit of ppb = a + b*dT
+//      + c*dT^2, dT = T - 25 C, over running sums with exponential
+//      forgetting. The sums are persisted in flash. When GPS is absent, the
+//      model predicts the correction which TxChannel applies instead of the
+//      GPS one. Pure C apart from persistence, also builds on host for
+//      tools/tempcomp_sim.c.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "TempComp.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#ifndef TEMP_COMP_HOST
+#include "util/flashmem.h"
+#endif
+
+/// @brief Solves a 4x4 (or smaller) linear system by Gauss elimination.
+/// @param m Matrix, destroyed.
+/// @param v Right side, destroyed.
+/// @param n Order, 1..TEMPCOMP_MAX_ORDER.
+/// @param px Ptr to write the solution.
+/// @return 0 if OK, -1 if the system is singular.
+static int TempCompSolve(double m[TEMPCOMP_MAX_ORDER][TEMPCOMP_MAX_ORDER],
+                         double v[TEMPCOMP_MAX_ORDER], int n, float *px)
+{
+    for(int col = 0; col < n; ++col)
+    {
+        int piv = col;
+        for(int r = col + 1; r < n; ++r)
+        {
+            if(fabs(m[r][col]) > fabs(m[piv][col]))
+            {
+                piv = r;
+            }
+        }
+        if(fabs(m[piv][col]) < 1e-9)
+        {
+            return -1;
+        }
+        if(piv != col)
+        {
+            for(int k = 0; k < n; ++k)
+            {
+                const double t = m[col][k]; m[col][k] = m[piv][k]; m[piv][k] = t;
+            }
+            const double t = v[col]; v[col] = v[piv]; v[piv] = t;
+        }
+        for(int r = col + 1; r < n; ++r)
+        {
+            const double f = m[r][col] / m[col][col];
+            for(int k = col; k < n; ++k)
+            {
+                m[r][k] -= f * m[col][k];
+            }
+            v[r] -= f * v[col];
+        }
+    }
+
+    for(int r = n - 1; r >= 0; --r)
+    {
+        double acc = v[r];
+        for(int k = r + 1; k < n; ++k)
+        {
+            acc -= m[r][k] * px[k];
+        }
+        px[r] = (float)(acc / m[r][r]);
+    }
+
+    return 0;
+}
+
+/// @brief Refits the model by the current sums. The order of the model
+/// @brief grows with the temperature spread seen, so a model learnt at a
+/// @brief constant temperature never extrapolates a slope. The cubic term
+/// @brief is what an AT-cut crystal has around its inflection point.
+/// @param pctx Context.
+static void TempCompFit(TempCompContext *pctx)
+{
+    const float *s = pctx->_rec._pf_sums;
+
+    pctx->_u8_order = 0;
+    memset(pctx->_pf_coef, 0, sizeof(pctx->_pf_coef));
+    if(s[TC_S1] < TEMPCOMP_MIN_WEIGHT)
+    {
+        return;
+    }
+
+    const double mean = s[TC_SX] / s[TC_S1];
+    const double var = s[TC_SX2] / s[TC_S1] - mean * mean;
+
+    int n = var < TEMPCOMP_LINEAR_VAR ? 1 : var < TEMPCOMP_QUAD_VAR ? 2
+          : var < TEMPCOMP_CUBIC_VAR ? 3 : 4;
+    for(; n > 0; --n)
+    {
+        double m[TEMPCOMP_MAX_ORDER][TEMPCOMP_MAX_ORDER], v[TEMPCOMP_MAX_ORDER];
+        for(int r = 0; r < n; ++r)
+        {
+            for(int k = 0; k < n; ++k)
+            {
+                m[r][k] = s[TC_S1 + r + k];
+            }
+            v[r] = s[TC_SY + r];
+        }
+        if(!TempCompSolve(m, v, n, pctx->_pf_coef))
+        {
+            pctx->_u8_order = n;
+            return;
+        }
+        memset(pctx->_pf_coef, 0, sizeof(pctx->_pf_coef));
+    }
+}
+
+/// @brief Initializes temperature compensation context.
+/// @return the Context.
+TempCompContext *TempCompInit(void)
+{
+    TempCompContext *p = calloc(1, sizeof(TempCompContext));
+    assert_(p);
+
+    p->_rec._u32_magic = TEMPCOMP_MAGIC;
+
+    return p;
+}
+
+/// @brief Checks whether it is time to learn a next sample.
+/// @param pctx Context.
+/// @param u64_now_us Current time, us.
+/// @return 1 if due.
+int TempCompIsDue(const TempCompContext *pctx, uint64_t u64_now_us)
+{
+    assert_(pctx);
+
+    return !pctx->_u64_last_sample_us
+           || u64_now_us - pctx->_u64_last_sample_us >= TEMPCOMP_SAMPLE_US;
+}
+
+/// @brief Learns a sample of crystal error. Call it only when the error
+/// @brief is measured by GPS.
+/// @param pctx Context.
+/// @param u64_now_us Current time, us.
+/// @param i32_temp_centi Temperature, 0.01 C.
+/// @param i32_ppb Crystal frequency error measured, ppb.
+void TempCompLearn(TempCompContext *pctx, uint64_t u64_now_us, int32_t i32_temp_centi,
+                   int32_t i32_ppb)
+{
+    assert_(pctx);
+
+    float *s = pctx->_rec._pf_sums;
+    const float x = (i32_temp_centi - TEMPCOMP_T0_CENTI) / 100.f;
+    const float y = (float)i32_ppb;
+
+    for(int i = 0; i < TC_NSUMS; ++i)
+    {
+        s[i] *= TEMPCOMP_FORGET;
+    }
+    s[TC_S1] += 1.f;
+    s[TC_SX] += x;
+    s[TC_SX2] += x * x;
+    s[TC_SX3] += x * x * x;
+    s[TC_SX4] += x * x * x * x;
+    s[TC_SX5] += x * x * x * x * x;
+    s[TC_SX6] += x * x * x * x * x * x;
+    s[TC_SY] += y;
+    s[TC_SXY] += x * y;
+    s[TC_SX2Y] += x * x * y;
+    s[TC_SX3Y] += x * x * x * y;
+
+    if(!pctx->_rec._u32_nlearnt++)
+    {
+        pctx->_rec._f_dt_min = pctx->_rec._f_dt_max = x;
+    }
+    else if(x < pctx->_rec._f_dt_min)
+    {
+        pctx->_rec._f_dt_min = x;
+    }
+    else if(x > pctx->_rec._f_dt_max)
+    {
+        pctx->_rec._f_dt_max = x;
+    }
+
+    pctx->_u64_last_sample_us = u64_now_us;
+    pctx->_u8_dirty = 1;
+
+    TempCompFit(pctx);
+}
+
+/// @brief Predicts crystal error at the temperature given. The temperature
+/// @brief is clamped to the range learnt, the model isn't extrapolated.
+/// @param pctx Context.
+/// @param i32_temp_centi Temperature, 0.01 C.
+/// @param pi32_ppb Ptr to write the error predicted, ppb.
+/// @return 0 if OK, -1 if there is no model yet.
+int TempCompPredict(const TempCompContext *pctx, int32_t i32_temp_centi, int32_t *pi32_ppb)
+{
+    assert_(pctx);
+    assert_(pi32_ppb);
+
+    if(!pctx->_u8_order)
+    {
+        return -1;
+    }
+
+    float x = (i32_temp_centi - TEMPCOMP_T0_CENTI) / 100.f;
+    x = x < pctx->_rec._f_dt_min ? pctx->_rec._f_dt_min
+      : x > pctx->_rec._f_dt_max ? pctx->_rec._f_dt_max : x;
+
+    const float *c = pctx->_pf_coef;
+    *pi32_ppb = (int32_t)lroundf(c[0] + x * (c[1] + x * (c[2] + x * c[3])));
+
+    return 0;
+}
+
+#ifndef TEMP_COMP_HOST
+/// @brief Calculates checksum of the persistent record.
+/// @param prec Ptr to the record.
+/// @return Checksum.
+static uint32_t TempCompChecksum(const TempCompRecord *prec)
+{
+    const uint8_t *p = (const uint8_t *)prec;
+    uint32_t u32_sum = 0x811C9DC5UL;
+    for(size_t i = 0; i < offsetof(TempCompRecord, _u32_check); ++i)
+    {
+        u32_sum = (u32_sum ^ p[i]) * 0x01000193UL;
+    }
+
+    return u32_sum;
+}
+
+/// @brief Loads the model from flash.
+/// @param pctx Context.
+/// @return 0 if OK, -1 if there is no valid record.
+int TempCompLoad(TempCompContext *pctx)
+{
+    assert_(pctx);
+
+    const TempCompRecord *prec = (const TempCompRecord *)FlashMemGet();
+    if(TEMPCOMP_MAGIC != prec->_u32_magic || TempCompChecksum(prec) != prec->_u32_check)
+    {
+        return -1;
+    }
+
+    memcpy(&pctx->_rec, prec, sizeof(TempCompRecord));
+    pctx->_u8_dirty = 0;
+    TempCompFit(pctx);
+
+    return 0;
+}
+
+/// @brief Saves the model to flash if it has been changed, but not more
+/// @brief often than once per TEMPCOMP_SAVE_US.
+/// @brief Pauses core1 for the time of flash erase, never call it on air.
+/// @param pctx Context.
+/// @param u64_now_us Current time, us.
+/// @return 0 if OK or nothing to save, error code otherwise.
+int TempCompSave(TempCompContext *pctx, uint64_t u64_now_us)
+{
+    assert_(pctx);
+
+    if(!pctx->_u8_dirty || u64_now_us - pctx->_u64_last_save_us < TEMPCOMP_SAVE_US)
+    {
+        return 0;
+    }
+    pctx->_u64_last_save_us = u64_now_us;
+
+    pctx->_rec._u32_check = TempCompChecksum(&pctx->_rec);
+    const int ret = FlashMemWrite(&pctx->_rec, sizeof(TempCompRecord));
+    if(!ret)
+    {
+        pctx->_u8_dirty = 0;
+    }
+
+    return ret;
+}
+#endif
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  TempComp.h - Temperature compensation of DCO frequency.
+//
+//  DESCRIPTION
+//      Learns crystal frequency error (ppb) vs. on-chip temperature while
+//      GPS solution is valid: weighted least squares fit of ppb = a + b*dT
+//      + c*dT^2, dT = T - 25 C, over running sums with exponential
+//      forgetting. The sums are persisted in flash. When GPS is absent, the
+//      model predicts the correction which TxChannel applies instead of the
+//      GPS one. Pure C apart from persistence, also builds on host for
+//      tools/tempcomp_sim.c.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef TEMPCOMP_H_
+#define TEMPCOMP_H_
+
+#include <stdint.h>
+
+#ifdef TEMP_COMP_HOST
+#include <assert.h>
+#define assert_ assert
+#else
+#include "../pico-hf-oscillator/lib/assert.h"
+#endif
+
+#define TEMPCOMP_MAGIC          0x54434D32UL    /* `TCM2`, with the cubic sums. */
+#define TEMPCOMP_T0_CENTI       2500            /* Expansion point, 0.01 C. */
+#define TEMPCOMP_FORGET         0.999f          /* Per sample, ~17 h at 1/min. */
+#define TEMPCOMP_MIN_WEIGHT     30.f            /* Samples before predicting. */
+#define TEMPCOMP_LINEAR_VAR     1.f             /* dT variance, C^2, for slope. */
+#define TEMPCOMP_QUAD_VAR       4.f             /* dT variance, C^2, for curvature. */
+#define TEMPCOMP_CUBIC_VAR      16.f            /* dT variance, C^2, for AT-cut cubic. */
+#define TEMPCOMP_MAX_ORDER      4
+#define TEMPCOMP_SAMPLE_US      60000000ULL     /* Learning period. */
+#define TEMPCOMP_SAVE_US        (6ULL * 3600000000ULL)  /* Flash wear. */
+
+enum
+{
+    TC_S1 = 0, TC_SX, TC_SX2, TC_SX3, TC_SX4,   /* Sums of weights * dT^k. */
+    TC_SX5, TC_SX6,
+    TC_SY, TC_SXY, TC_SX2Y, TC_SX3Y,            /* Sums of weights * dT^k * ppb. */
+    TC_NSUMS
+};
+
+typedef struct
+{
+    uint32_t _u32_magic;
+    float _pf_sums[TC_NSUMS];
+    float _f_dt_min, _f_dt_max;             /* dT range seen, C. */
+    uint32_t _u32_nlearnt;                  /* Samples ever learnt. */
+    uint32_t _u32_check;                    /* Checksum of the above. */
+
+} TempCompRecord;
+
+typedef struct
+{
+    TempCompRecord _rec;                    /* Persistent part. */
+
+    float _pf_coef[TEMPCOMP_MAX_ORDER];     /* a, b, c, d of the fit. */
+    uint8_t _u8_order;                      /* 0 - no fit, 1 - const, 2 - lin, 3 - quad, 4 - cubic. */
+    uint8_t _u8_dirty;                      /* Not saved yet. */
+    uint64_t _u64_last_sample_us;
+    uint64_t _u64_last_save_us;
+
+} TempCompContext;
+
+TempCompContext *TempCompInit(void);
+int TempCompIsDue(const TempCompContext *pctx, uint64_t u64_now_us);
+void TempCompLearn(TempCompContext *pctx, uint64_t u64_now_us, int32_t i32_temp_centi,
+                   int32_t i32_ppb);
+int TempCompPredict(const TempCompContext *pctx, int32_t i32_temp_centi, int32_t *pi32_ppb);
+
+#ifndef TEMP_COMP_HOST
+int TempCompLoad(TempCompContext *pctx);
+int TempCompSave(TempCompContext *pctx, uint64_t u64_now_us);
+#endif
+
+#endif
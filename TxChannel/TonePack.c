@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  TonePack.c - Bit-packed tone frames.
+//
+//  DESCRIPTION
+//      A frame of FSK tones stored with as many bits per tone as the mode
+//      needs: 3 for 8-FSK (FT8), 2 for 4-FSK (FT4, WSPR). An FT8 frame
+//      takes 30 bytes instead of 79, so frames can be kept in flash (see
+//      ToneBank) or queued in RAM cheaply.
+//
+//      TonePackedFrame is a descriptor only, the data is referenced, not
+//      copied. TonePackGet() unpacks one tone in a few instructions and is
+//      inlined into the symbol ISR, so nobody unpacks a whole frame.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "TonePack.h"
+#include <string.h>
+
+/// @brief Packs a frame of tones into a buffer and sets up its descriptor.
+/// @param pframe Descriptor to set up, it will refer to pdst.
+/// @param pdst Buffer, at least TONE_PACK_BYTES(n, bits) bytes.
+/// @param size Size of the buffer.
+/// @param ptones Tones, one per byte.
+/// @param n A count of tones.
+/// @param bits Bits per tone, 1..TONE_PACK_MAX_BITS.
+/// @return 0 if OK, -1 if the buffer is too small or a tone doesn't fit.
+int TonePackFrame(TonePackedFrame *pframe, uint8_t *pdst, uint32_t size,
+                  const uint8_t *ptones, int n, uint8_t bits)
+{
+    if(!bits || bits > TONE_PACK_MAX_BITS || n < 0 || n > UINT16_MAX
+       || size < TONE_PACK_BYTES((uint32_t)n, bits))
+    {
+        return -1;
+    }
+
+    memset(pdst, 0, TONE_PACK_BYTES((uint32_t)n, bits));
+
+    uint32_t u32_bit = 0;
+    for(int i = 0; i < n; ++i)
+    {
+        if(ptones[i] >> bits)
+        {
+            return -1;
+        }
+
+        /* A tone spans at most two bytes. */
+        const uint32_t u32_pair = (uint32_t)ptones[i] << (16 - bits - (u32_bit & 7));
+        pdst[u32_bit >> 3] |= (uint8_t)(u32_pair >> 8);
+        pdst[(u32_bit >> 3) + 1] |= (uint8_t)u32_pair;
+        u32_bit += bits;
+    }
+
+    pframe->_pu8_data = pdst;
+    pframe->_u16_ntones = (uint16_t)n;
+    pframe->_u8_bits = bits;
+
+    return 0;
+}
+
+/// @brief Unpacks the whole frame, one tone per byte.
+/// @param pframe Frame.
+/// @param pdst Buffer of _u16_ntones bytes.
+void TonePackUnpack(const TonePackedFrame *pframe, uint8_t *pdst)
+{
+    for(uint32_t i = 0; i < pframe->_u16_ntones; ++i)
+    {
+        pdst[i] = TonePackGet(pframe, i);
+    }
+}
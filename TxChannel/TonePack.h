@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  TonePack.h - Bit-packed tone frames.
+//
+//  DESCRIPTION
+//      A frame of FSK tones stored with as many bits per tone as the mode
+//      needs: 3 for 8-FSK (FT8), 2 for 4-FSK (FT4, WSPR). An FT8 frame
+//      takes 30 bytes instead of 79, so frames can be kept in flash (see
+//      ToneBank) or queued in RAM cheaply.
+//
+//      TonePackedFrame is a descriptor only, the data is referenced, not
+//      copied. TonePackGet() unpacks one tone in a few instructions and is
+//      inlined into the symbol ISR, so nobody unpacks a whole frame.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef TONEPACK_H_
+#define TONEPACK_H_
+
+#include <stdint.h>
+
+#define TONE_PACK_MAX_BITS      3           /* 8-FSK. */
+
+/* Bytes to hold n tones of `bits` each. One spare byte, since the accessor
+   reads tones as byte pairs. */
+#define TONE_PACK_BYTES(n, bits) ((((n) * (bits) + 7) >> 3) + 1)
+
+typedef struct
+{
+    const uint8_t *_pu8_data;               /* Tones MSB first, _u8_bits each. */
+    uint16_t _u16_ntones;
+    uint8_t _u8_bits;                       /* 2 - 4-FSK, 3 - 8-FSK. */
+
+} TonePackedFrame;
+
+/// @brief Gets one tone of a packed frame. Safe to call from ISR.
+/// @param pframe Frame.
+/// @param ix Index of the tone, must be less than _u16_ntones.
+/// @return The tone.
+static inline __attribute__((always_inline))
+uint8_t TonePackGet(const TonePackedFrame *pframe, uint32_t ix)
+{
+    const uint32_t u32_bit = ix * pframe->_u8_bits;
+    const uint8_t *p = pframe->_pu8_data + (u32_bit >> 3);
+    const uint32_t u32_pair = (uint32_t)p[0] << 8 | p[1];
+
+    return (uint8_t)(u32_pair >> (16 - pframe->_u8_bits - (u32_bit & 7)))
+           & ((1U << pframe->_u8_bits) - 1);
+}
+
+int TonePackFrame(TonePackedFrame *pframe, uint8_t *pdst, uint32_t size,
+                  const uint8_t *ptones, int n, uint8_t bits);
+void TonePackUnpack(const TonePackedFrame *pframe, uint8_t *pdst);
+
+#endif
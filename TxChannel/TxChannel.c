@@ -48,107 +48,477 @@
 //  THE SOFTWARE.
 ///////////////////////////////////////////////////////////////////////////////
 #include "TxChannel.h"
+#include <string.h>
+#ifndef TX_CHANNEL_HOST
+#include "hardware/sync.h"
+#endif
+#include <defines.h>
 
-#include "debug/logutils.h"
+#define LOG_MODULE TXCHANNEL
+#include "debug/log.h"
 
-static TxChannelContext *spTX = NULL;
-static void __not_in_flash_func (TxChannelISR)(void)
+static TxChannelContext *spTX[NUM_ALARMS] = { NULL };
+
+/// @brief Maps ISR lateness to a histogram bin: 1us bins below
+/// @brief TX_JITTER_LINEAR_US, 4 bins per octave above, so bins reach
+/// @brief past TX_JITTER_DEADLINE_US. No CLZ on M0+, a short loop instead.
+/// @param u32_late_us Lateness, us.
+/// @return Bin index.
+static uint32_t __not_in_flash_func (TxJitterBin)(uint32_t u32_late_us)
+{
+    if(u32_late_us < TX_JITTER_LINEAR_US)
+    {
+        return u32_late_us;
+    }
+
+    uint32_t u32_bin = TX_JITTER_LINEAR_US;
+    while(u32_late_us >= 2 * TX_JITTER_LINEAR_US && u32_bin < TX_JITTER_HIST_BINS - 1)
+    {
+        u32_late_us >>= 1;
+        u32_bin += 4;
+    }
+    u32_bin += (u32_late_us - TX_JITTER_LINEAR_US) / (TX_JITTER_LINEAR_US / 4);
+
+    return min(u32_bin, TX_JITTER_HIST_BINS - 1);
+}
+
+/// @brief Gets the greatest lateness which falls into a bin.
+/// @param u32_bin Bin index, but the last (open) one.
+/// @return Lateness, us.
+static uint32_t TxJitterBinTop(uint32_t u32_bin)
+{
+    if(u32_bin < TX_JITTER_LINEAR_US)
+    {
+        return u32_bin;
+    }
+
+    const uint32_t u32_octave = (u32_bin - TX_JITTER_LINEAR_US) / 4;
+    const uint32_t u32_sub = (u32_bin - TX_JITTER_LINEAR_US) % 4;
+
+    return ((TX_JITTER_LINEAR_US + (u32_sub + 1) * (TX_JITTER_LINEAR_US / 4)) << u32_octave) - 1;
+}
+
+/// @brief Accounts ISR lateness of one symbol. Runs in ISR context only.
+/// @param pstats Stats of the current transmission.
+/// @param u32_late_us How late the ISR has been invoked, us.
+static void __not_in_flash_func (TxJitterUpdate)(TxJitterStats *pstats, uint32_t u32_late_us)
+{
+    ++pstats->_u32_seq;
+    __dmb();
+
+    if(!pstats->_u32_count || u32_late_us < pstats->_u32_min_us)
+    {
+        pstats->_u32_min_us = u32_late_us;
+    }
+    if(u32_late_us > pstats->_u32_max_us)
+    {
+        pstats->_u32_max_us = u32_late_us;
+    }
+    ++pstats->_u32_count;
+    pstats->_u64_sum_us += u32_late_us;
+    if(u32_late_us >= TX_JITTER_DEADLINE_US)
+    {
+        ++pstats->_u32_missed;
+    }
+    ++pstats->_pu32_hist[TxJitterBin(u32_late_us)];
+
+    __dmb();
+    ++pstats->_u32_seq;
+}
+
+/// @brief Gets the DCO correction of crystal error at the dial frequency.
+/// @brief Uses GPS measured error if GPS solution is active, otherwise
+/// @brief the fallback one (temperature model) if it is set.
+/// @param pctx Context.
+/// @return Correction, milliHz.
+int32_t __not_in_flash_func (TxChannelGetCompensation)(const TxChannelContext *pctx)
+{
+    const GPStimeContext *pGPS = pctx->_p_oscillator->_pGPStime;
+    if((!pGPS || !pGPS->_time_data._u8_is_solution_active) && pctx->_u8_fallback_valid)
+    {
+        return (int32_t)((int64_t)pctx->_u32_dialfreqhz * pctx->_i32_fallback_ppb / 1000000LL);
+    }
+
+    return PioDCOGetFreqShiftMilliHertz(pctx->_p_oscillator,
+                                        (uint64_t)(pctx->_u32_dialfreqhz * 1000LL));
+}
+
+/// @brief Precomputes DCO control words of a frame, the ones the symbol
+/// @brief ISR would set, and a pad word repeating the last of them.
+/// @brief The words are produced by PioDCOSetFreq() on a shadow copy of
+/// @brief the DCO, so the DCO itself isn't touched. Used by DMA backend.
+/// @param pctx Context providing dial freq., tone step and DCO.
+/// @param pframe Packed tones of the frame.
+/// @param pu32_words Ptr to write the words.
+/// @param max_words Capacity of pu32_words.
+/// @return A count of words (tones + 1), or -1 if they don't fit.
+int TxChannelFrameWords(const TxChannelContext *pctx, const TonePackedFrame *pframe,
+                        uint32_t *pu32_words, int max_words)
+{
+    assert_(pctx);
+    assert_(pframe);
+    assert_(pu32_words);
+
+    const int n = pframe->_u16_ntones;
+    if(n + 1 > max_words)
+    {
+        return -1;
+    }
+
+    /* The GPS correction changes very slowly, once per frame is enough. */
+    const int32_t i32_compensation_millis = TxChannelGetCompensation(pctx);
+
+    PioDco shadow = *pctx->_p_oscillator;
+    for(int i = 0; i < n; ++i)
+    {
+        PioDCOSetFreq(&shadow, pctx->_u32_dialfreqhz,
+                      (uint32_t)TonePackGet(pframe, i) * pctx->_u32_tone_step_milhz - 2 * i32_compensation_millis);
+        pu32_words[i] = shadow._frq_cycles_per_pi;
+    }
+    /* Pad word: it's taken when the last symbol has been on air for a full
+       period, so the drain completes exactly at the end of frame. */
+    pu32_words[n] = shadow._frq_cycles_per_pi;
+
+    return n + 1;
+}
+
+/// @brief Serves one symbol of a channel. Common part of alarm ISRs.
+/// @param pTX Context of the channel which alarm has fired.
+static void __not_in_flash_func (TxChannelServe)(TxChannelContext *pTX)
 {
-    PioDco *pDCO = spTX->_p_oscillator;
+    const uint32_t u32_now = timer_hw->timerawl;
+    const uint32_t u32_late_us = u32_now - (uint32_t)pTX->_tm_future_call;
+
+    PioDco *pDCO = pTX->_p_oscillator;
 
     uint8_t byte;
-    const int n2send = TxChannelPop(spTX, &byte);
+    const int n2send = TxChannelPop(pTX, &byte);
     if(n2send)
     {
-        const int32_t i32_compensation_millis =
-            PioDCOGetFreqShiftMilliHertz(spTX->_p_oscillator,
-                                         (uint64_t)(spTX->_u32_dialfreqhz * 1000LL));
+        TxJitterUpdate(&pTX->_jitter, u32_late_us);
+        if(pTX->_u8_start_armed)
+        {
+            pTX->_i32_start_error_us = (int32_t)(u32_now - (uint32_t)pTX->_u64_start_req_us);
+            pTX->_u8_start_armed = NO;
+        }
+
+        const int32_t i32_compensation_millis = TxChannelGetCompensation(pTX);
 
-        PioDCOSetFreq(pDCO, spTX->_u32_dialfreqhz,
-                      (uint32_t)byte * WSPR_FREQ_STEP_MILHZ - 2 * i32_compensation_millis);
+        PioDCOSetFreq(pDCO, pTX->_u32_dialfreqhz,
+                      (uint32_t)byte * pTX->_u32_tone_step_milhz - 2 * i32_compensation_millis);
+    }
+    else if(!pTX->_u8_start_armed)
+    {
+        /* The frame is over. Don't re-arm, so the CPU isn't woken up
+           every symbol while idle; TxChannelPush and TxChannelQueueFrame
+           restart the alarm. */
+        hw_clear_bits(&timer_hw->intr, 1U<<pTX->_timer_alarm_num);
+        pTX->_u8_idle = YES;
+        pTX->_u8_frame_done = YES;
+        __sev();
+        return;
     }
 
-    spTX->_tm_future_call += spTX->_bit_period_us;
+    if(!pTX->_u8_frame_wait)
+    {
+        pTX->_tm_future_call += pTX->_bit_period_us;
+    }
 
 EXIT:
-    hw_clear_bits(&timer_hw->intr, 1U<<spTX->_timer_alarm_num);
-    timer_hw->alarm[spTX->_timer_alarm_num] = (uint32_t)spTX->_tm_future_call;
+    hw_clear_bits(&timer_hw->intr, 1U<<pTX->_timer_alarm_num);
+    timer_hw->alarm[pTX->_timer_alarm_num] = (uint32_t)pTX->_tm_future_call;
 
     /* LED debug signal */
-    static int tick = 0;
-    gpio_put(PICO_DEFAULT_LED_PIN, ++tick & 1);
+    if(!pTX->_timer_alarm_num)
+    {
+        static int tick = 0;
+        gpio_put(PICO_DEFAULT_LED_PIN, ++tick & 1);
+    }
 }
 
+/* One ISR per hardware alarm, each serves its own channel instance. */
+#define TX_CHANNEL_ISR(n) \
+    static void __not_in_flash_func (TxChannelISR##n)(void) { TxChannelServe(spTX[n]); }
+TX_CHANNEL_ISR(0)
+TX_CHANNEL_ISR(1)
+TX_CHANNEL_ISR(2)
+TX_CHANNEL_ISR(3)
+
+static const irq_handler_t spTxChannelISR[NUM_ALARMS] =
+{
+    TxChannelISR0, TxChannelISR1, TxChannelISR2, TxChannelISR3
+};
+
 // https://github.com/raspberrypi/pico-examples/blob/master/timer/timer_lowlevel/timer_lowlevel.c
-#define ALARM_NUM 0
-#define ALARM_IRQ timer_hardware_alarm_get_irq_num(timer_hw, ALARM_NUM)
+#define ALARM_IRQ(n) timer_hardware_alarm_get_irq_num(timer_hw, (n))
 
 /// @brief Initializes a TxChannel context. Starts ISR.
 /// @param bit_period_us Period of data bits, BPS speed = 1e6/bit_period_us.
 /// @param timer_alarm_num Pico-specific hardware timer resource id.
+/// @remark Every channel needs its own alarm; alarm 3 is used by SDK's
+/// @remark default alarm pool (sleep_ms etc.), so use 0..2.
+/// @param fifo_size FIFO capacity in bytes, must be a power of two.
 /// @param pDCO Ptr to oscillator.
 /// @return the Context.
 TxChannelContext *TxChannelInit(const uint32_t bit_period_us, uint8_t timer_alarm_num,
-                                PioDco *pDCO)
+                                uint32_t fifo_size, PioDco *pDCO)
 {
     assert_(pDCO);
     assert_(bit_period_us > 10);
+    assert_(fifo_size && !(fifo_size & (fifo_size - 1)));
+    assert_(timer_alarm_num < NUM_ALARMS);
+    assert_(!spTX[timer_alarm_num]);
 
     TxChannelContext *p = calloc(1, sizeof(TxChannelContext));
     assert_(p);
 
+    p->_pbyte_buffer = calloc(fifo_size, 1);
+    assert_(p->_pbyte_buffer);
+    p->_u32_fifo_mask = fifo_size - 1;
+
     p->_bit_period_us = bit_period_us;
     p->_timer_alarm_num = timer_alarm_num;
     p->_p_oscillator = pDCO;
+    p->_u32_tone_step_milhz = WSPR_FREQ_STEP_MILHZ;
 
-    spTX = p;
+    hardware_alarm_claim(timer_alarm_num);
+    spTX[timer_alarm_num] = p;
 
     hw_set_bits(&timer_hw->inte, 1U << p->_timer_alarm_num);
-    irq_set_exclusive_handler(ALARM_IRQ, TxChannelISR);
-    irq_set_priority(ALARM_IRQ, 0x00);
-    irq_set_enabled(ALARM_IRQ, true);
+    irq_set_exclusive_handler(ALARM_IRQ(timer_alarm_num), spTxChannelISR[timer_alarm_num]);
+    irq_set_priority(ALARM_IRQ(timer_alarm_num), 0x00);
+    irq_set_enabled(ALARM_IRQ(timer_alarm_num), true);
 
-    StampPrintf("Hi from TxChannelInit!");
+    LOG_D("Hi from TxChannelInit! alarm:%u", timer_alarm_num);
 
-    p->_tm_future_call = timer_hw->timerawl + 20000LL;
-    timer_hw->alarm[p->_timer_alarm_num] = (uint32_t)p->_tm_future_call;
+    /* The alarm is started by the first TxChannelPush, TxChannelQueueFrame
+       or TxChannelArmAt. */
+    p->_u8_idle = YES;
+    p->_i32_start_error_us = TX_START_ERROR_NA;
 
     return p;
 }
 
-/// @brief Gets a count of bytes to send.
+/// @brief Gets a count of symbols to send: the rest of the frame on air,
+/// @brief the queued frame and bytes of FIFO.
+/// @param pctx Context.
+/// @return A count of symbols.
+uint32_t TxChannelPending(const TxChannelContext *pctx)
+{
+    const uint32_t u32_irq = save_and_disable_interrupts();
+    uint32_t u32_pending = pctx->_ix_input - pctx->_ix_output;
+    if(pctx->_u8_frame_held)
+    {
+        u32_pending += pctx->_frame._tones._u16_ntones - pctx->_u32_frame_ix;
+    }
+    if(pctx->_u8_next_held)
+    {
+        u32_pending += pctx->_next._tones._u16_ntones;
+    }
+    restore_interrupts(u32_irq);
+
+    return u32_pending;
+}
+
+/// @brief Gets a count of bytes which can be pushed without overwriting.
+/// @param pctx Context.
+/// @return A count of free bytes in FIFO.
+uint32_t TxChannelFree(const TxChannelContext *pctx)
+{
+    return pctx->_u32_fifo_mask + 1 - (pctx->_ix_input - pctx->_ix_output);
+}
+
+/// @brief Restarts the symbol alarm if the channel has gone idle.
 /// @param pctx Context.
-/// @return A count of bytes.
-uint8_t TxChannelPending(TxChannelContext *pctx)
+static void TxChannelWake(TxChannelContext *pctx)
 {
-    return 256L + (int)pctx->_ix_input - (int)pctx->_ix_output;
+    if(!pctx->_u8_idle)
+    {
+        return;
+    }
+
+    const uint32_t u32_irq = save_and_disable_interrupts();
+    pctx->_u8_idle = NO;
+    pctx->_tm_future_call = time_us_64() + TX_ARM_MIN_LEAD_US;
+    timer_hw->alarm[pctx->_timer_alarm_num] = (uint32_t)pctx->_tm_future_call;
+    restore_interrupts(u32_irq);
 }
 
-/// @brief Push a number of bytes to the output FIFO.
+/// @brief Push a number of bytes to the output FIFO. Never blocks.
+/// @brief The only producer of the FIFO, ISR is the only consumer.
 /// @param pctx Context.
 /// @param psrc Ptr to buffer to send.
 /// @param n A count of bytes to send.
-/// @return A count of bytes has been sent (might be lower than n).
-int TxChannelPush(TxChannelContext *pctx, uint8_t *psrc, int n)
+/// @return A count of bytes has been pushed (might be lower than n).
+int TxChannelPush(TxChannelContext *pctx, const uint8_t *psrc, int n)
 {
-    uint8_t *pdst = pctx->_pbyte_buffer;
-    while(n-- && pctx->_ix_input != pctx->_ix_output)
+    const uint32_t ix_input = pctx->_ix_input;
+    const uint32_t u32_free = pctx->_u32_fifo_mask + 1 - (ix_input - pctx->_ix_output);
+    if(n > (int)u32_free)
+    {
+        n = (int)u32_free;
+    }
+
+    for(int i = 0; i < n; ++i)
+    {
+        pctx->_pbyte_buffer[(ix_input + i) & pctx->_u32_fifo_mask] = psrc[i];
+    }
+
+    /* Data must land before the consumer sees the new index. */
+    __dmb();
+    pctx->_ix_input = ix_input + n;
+
+    if(n)
     {
-        pdst[pctx->_ix_input++] = *psrc++;
+        TxChannelWake(pctx);
     }
 
     return n;
 }
 
-/// @brief Retrieves a next byte from FIFO.
+/// @brief Makes _frame current. With a start time ahead, re-phases the
+/// @brief symbol clock to it, else the frame follows at once (a late one
+/// @brief too). Runs in ISR context or with interrupts disabled.
+/// @param pctx Context.
+static void __not_in_flash_func (TxChannelStartFrame)(TxChannelContext *pctx)
+{
+    pctx->_u32_frame_ix = 0;
+    pctx->_u8_frame_held = YES;
+    pctx->_u8_frame_wait = NO;
+    if(pctx->_frame._u32_dialfreqhz)
+    {
+        pctx->_u32_dialfreqhz = pctx->_frame._u32_dialfreqhz;
+    }
+
+    const uint64_t u64_start_us = pctx->_frame._u64_start_us;
+    if(!u64_start_us
+       || (int32_t)((uint32_t)u64_start_us - timer_hw->timerawl) < TX_ARM_MIN_LEAD_US / 2)
+    {
+        pctx->_i32_start_error_us = TX_START_ERROR_NA;
+        return;
+    }
+
+    pctx->_u64_start_req_us = u64_start_us;
+    pctx->_i32_start_error_us = 0;
+    pctx->_u8_start_armed = YES;
+    pctx->_u8_frame_wait = YES;
+    pctx->_u8_idle = NO;
+    pctx->_tm_future_call = u64_start_us;
+    timer_hw->alarm[pctx->_timer_alarm_num] = (uint32_t)u64_start_us;
+}
+
+/// @brief Queues a packed frame. Up to two frames may be held: the one on
+/// @brief air and the next one. The next one follows without a gap, or
+/// @brief waits for its start time, e.g. the next slot; so back-to-back
+/// @brief slots need no work at the slot edge. The tones are unpacked by
+/// @brief ISR one by one straight from the frame data, nothing is copied;
+/// @brief the data must stay intact until release is called. Frames go
+/// @brief before any bytes pushed to FIFO.
+/// @param pctx Context.
+/// @param pframe Frame, the descriptor itself may be reused at once.
+/// @return 0 if OK, -1 if two frames are held already or the start time
+/// @return is too close, past or too far ahead.
+int TxChannelQueueFrame(TxChannelContext *pctx, const TxChannelFrame *pframe)
+{
+    assert_(pctx);
+    assert_(pframe);
+
+    const uint64_t u64_now = time_us_64();
+    if(pframe->_u64_start_us && (pframe->_u64_start_us < u64_now + TX_ARM_MIN_LEAD_US
+                                 || pframe->_u64_start_us - u64_now > (uint64_t)INT32_MAX))
+    {
+        return -1;
+    }
+
+    const uint32_t u32_irq = save_and_disable_interrupts();
+    if(!pctx->_u8_frame_held)
+    {
+        pctx->_frame = *pframe;
+        TxChannelStartFrame(pctx);
+    }
+    else if(!pctx->_u8_next_held)
+    {
+        pctx->_next = *pframe;
+        pctx->_u8_next_held = YES;
+    }
+    else
+    {
+        restore_interrupts(u32_irq);
+        return -1;
+    }
+    restore_interrupts(u32_irq);
+
+    if(pframe->_tones._u16_ntones)
+    {
+        TxChannelWake(pctx);
+    }
+
+    return 0;
+}
+
+/// @brief Releases the frame on air and makes the queued one current.
+/// @brief Runs in ISR context or with interrupts disabled.
+/// @param pctx Context.
+static void __not_in_flash_func (TxChannelRetireFrame)(TxChannelContext *pctx)
+{
+    const TxChannelFrame done = pctx->_frame;
+
+    pctx->_u8_frame_held = NO;
+    if(pctx->_u8_next_held)
+    {
+        pctx->_frame = pctx->_next;
+        pctx->_u8_next_held = NO;
+        TxChannelStartFrame(pctx);
+    }
+
+    pctx->_u8_frame_done = YES;
+    __sev();
+
+    if(done._release)
+    {
+        done._release(done._parg);
+    }
+}
+
+/// @brief Retrieves a next symbol: from the packed frame, then from FIFO.
+/// @brief Never blocks.
 /// @param pctx Context.
 /// @param pdst Ptr to write a byte.
 /// @return 1 if a byte has been retrived, or 0.
 int TxChannelPop(TxChannelContext *pctx, uint8_t *pdst)
 {
-    if(pctx->_ix_input != pctx->_ix_output)
+    if(pctx->_u8_frame_held && pctx->_u32_frame_ix >= pctx->_frame._tones._u16_ntones)
+    {
+        /* The last tone has been on air for its full period. */
+        TxChannelRetireFrame(pctx);
+    }
+
+    if(pctx->_u8_frame_wait)
+    {
+        if((int32_t)(timer_hw->timerawl - (uint32_t)pctx->_u64_start_req_us) < 0)
+        {
+            return 0;
+        }
+        pctx->_u8_frame_wait = NO;
+    }
+
+    const uint32_t ix_frame = pctx->_u32_frame_ix;
+    if(pctx->_u8_frame_held && ix_frame < pctx->_frame._tones._u16_ntones)
+    {
+        *pdst = TonePackGet(&pctx->_frame._tones, ix_frame);
+        pctx->_u32_frame_ix = ix_frame + 1;
+
+        return 1;
+    }
+
+    const uint32_t ix_output = pctx->_ix_output;
+    if(pctx->_ix_input != ix_output)
     {
-        *pdst = pctx->_pbyte_buffer[pctx->_ix_output++];
+        /* Read data only after the producer's index has been observed. */
+        __dmb();
+        *pdst = pctx->_pbyte_buffer[ix_output & pctx->_u32_fifo_mask];
+        __dmb();
+        pctx->_ix_output = ix_output + 1;
 
         return 1;
     }
@@ -156,9 +526,178 @@ int TxChannelPop(TxChannelContext *pctx, uint8_t *pdst)
     return 0;
 }
 
-/// @brief Clears FIFO completely. Sets write&read indexes to 0.
+/// @brief Drops frames (releasing them) and all pending bytes of FIFO.
+/// @brief Resets jitter stats, so they are accounted per transmission.
 /// @param pctx Context.
 void TxChannelClear(TxChannelContext *pctx)
 {
-    pctx->_ix_input = pctx->_ix_output = 0;
+    /* The consumer index is owned by ISR, move it with ISR masked. */
+    const uint32_t u32_irq = save_and_disable_interrupts();
+    pctx->_ix_output = pctx->_ix_input;
+    const TxChannelFrame next = pctx->_next;
+    const uint8_t u8_next_held = pctx->_u8_next_held;
+    pctx->_u8_next_held = NO;
+    if(pctx->_u8_frame_held)
+    {
+        TxChannelRetireFrame(pctx);
+    }
+    if(u8_next_held && next._release)
+    {
+        next._release(next._parg);
+    }
+    if(pctx->_u8_frame_wait)
+    {
+        /* Forget the start time of the dropped frame. */
+        pctx->_u8_frame_wait = NO;
+        pctx->_u8_start_armed = NO;
+    }
+    pctx->_u8_frame_done = NO;
+    pctx->_i32_start_error_us = TX_START_ERROR_NA;
+    memset(&pctx->_jitter, 0, sizeof(pctx->_jitter));
+    restore_interrupts(u32_irq);
+}
+
+/// @brief Re-phases symbol clock so that the next symbol starts exactly
+/// @brief at u64_start_us. Call it before pushing the frame.
+/// @param pctx Context.
+/// @param u64_start_us Start time of the first symbol, us since boot.
+/// @return 0 if OK, -1 if the time is too close, past or too far ahead.
+int TxChannelArmAt(TxChannelContext *pctx, uint64_t u64_start_us)
+{
+    assert_(pctx);
+
+    const uint64_t u64_now = time_us_64();
+    if(u64_start_us < u64_now + TX_ARM_MIN_LEAD_US
+       || u64_start_us - u64_now > (uint64_t)INT32_MAX)
+    {
+        return -1;
+    }
+
+    const uint32_t u32_irq = save_and_disable_interrupts();
+    pctx->_u64_start_req_us = u64_start_us;
+    pctx->_i32_start_error_us = 0;
+    pctx->_u8_start_armed = YES;
+    pctx->_u8_idle = NO;
+    pctx->_tm_future_call = u64_start_us;
+    timer_hw->alarm[pctx->_timer_alarm_num] = (uint32_t)u64_start_us;
+    restore_interrupts(u32_irq);
+
+    return 0;
+}
+
+/// @brief Checks and consumes the end of frame event. The event is
+/// @brief signalled by SEV too, so the caller may sleep in __wfe() between
+/// @brief the checks.
+/// @param pctx Context.
+/// @return 1 if the last symbol of a frame has been sent since the last call.
+int TxChannelFrameDone(TxChannelContext *pctx)
+{
+    assert_(pctx);
+
+    if(!pctx->_u8_frame_done)
+    {
+        return 0;
+    }
+    pctx->_u8_frame_done = NO;
+
+    return 1;
+}
+
+/// @brief Sets crystal error to be compensated while there is no GPS.
+/// @param pctx Context.
+/// @param i32_ppb Crystal error, ppb (same sign as GPS measured one).
+void TxChannelSetFallbackPpb(TxChannelContext *pctx, int32_t i32_ppb)
+{
+    assert_(pctx);
+
+    pctx->_i32_fallback_ppb = i32_ppb;
+    pctx->_u8_fallback_valid = YES;
+}
+
+/// @brief Takes a consistent copy of jitter stats being updated by ISR.
+/// @param pctx Context.
+/// @param pdst Ptr to write the copy.
+void TxChannelGetJitter(const TxChannelContext *pctx, TxJitterStats *pdst)
+{
+    assert_(pctx);
+    assert_(pdst);
+
+    uint32_t u32_seq;
+    do
+    {
+        u32_seq = pctx->_jitter._u32_seq;
+        __dmb();
+        memcpy(pdst, (const void *)&pctx->_jitter, sizeof(TxJitterStats));
+        __dmb();
+    } while((u32_seq & 1) || u32_seq != pctx->_jitter._u32_seq);
+}
+
+/// @brief Resets jitter stats, e.g. between back-to-back frames which
+/// @brief aren't separated by TxChannelClear.
+/// @param pctx Context.
+void TxChannelResetJitter(TxChannelContext *pctx)
+{
+    assert_(pctx);
+
+    const uint32_t u32_irq = save_and_disable_interrupts();
+    memset(&pctx->_jitter, 0, sizeof(pctx->_jitter));
+    restore_interrupts(u32_irq);
+}
+
+/// @brief Calculates a percentile of ISR lateness using the histogram.
+/// @param pstats Stats.
+/// @param percent Percentile, 0..100.
+/// @return Lateness in us: the top of the bin holding the percentile,
+/// @return but not above the max.
+uint32_t TxJitterPercentile(const TxJitterStats *pstats, int percent)
+{
+    assert_(pstats);
+
+    if(!pstats->_u32_count)
+    {
+        return 0;
+    }
+
+    const uint64_t u64_rank = ((uint64_t)pstats->_u32_count * percent + 99) / 100;
+    uint64_t u64_acc = 0;
+    for(uint32_t i = 0; i < TX_JITTER_HIST_BINS; ++i)
+    {
+        u64_acc += pstats->_pu32_hist[i];
+        if(u64_acc >= u64_rank)
+        {
+            return i < TX_JITTER_HIST_BINS - 1 ? min(TxJitterBinTop(i), pstats->_u32_max_us)
+                                               : pstats->_u32_max_us;
+        }
+    }
+
+    return pstats->_u32_max_us;
+}
+
+/// @brief Dumps jitter stats of the last transmission to stdio.
+/// @brief The `TXJ>` line is parsed by tools/jitter_report.py.
+/// @param pctx Context.
+void TxChannelDumpJitter(const TxChannelContext *pctx)
+{
+    assert_(pctx);
+
+    TxJitterStats stats;
+    TxChannelGetJitter(pctx, &stats);
+
+    const uint32_t u32_mean_x10 = stats._u32_count
+        ? (uint32_t)(stats._u64_sum_us * 10 / stats._u32_count) : 0;
+
+    if(TX_START_ERROR_NA == pctx->_i32_start_error_us)
+    {
+        /* Not armed to a time, e.g. manual TX without GPS. */
+        StampPrintf("TXJ> n:%lu min:%lu mean:%lu.%lu max:%lu p99:%lu miss:%lu start:-",
+                    stats._u32_count, stats._u32_min_us,
+                    u32_mean_x10 / 10, u32_mean_x10 % 10, stats._u32_max_us,
+                    TxJitterPercentile(&stats, 99), stats._u32_missed);
+        return;
+    }
+    StampPrintf("TXJ> n:%lu min:%lu mean:%lu.%lu max:%lu p99:%lu miss:%lu start:%ld",
+                stats._u32_count, stats._u32_min_us,
+                u32_mean_x10 / 10, u32_mean_x10 % 10, stats._u32_max_us,
+                TxJitterPercentile(&stats, 99), stats._u32_missed,
+                pctx->_i32_start_error_us);
 }
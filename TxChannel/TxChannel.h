@@ -52,10 +52,47 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#ifdef TX_CHANNEL_HOST
+#include "TxChannelHost.h"
+#else
 #include "hardware/clocks.h"
 #include "pico/stdlib.h"
 #include "../pico-hf-oscillator/lib/assert.h"
 #include <piodco.h>
+#endif
+#include "TonePack.h"
+
+#define TX_JITTER_LINEAR_US     32          /* 1us bins below, 4 bins per octave above. */
+#define TX_JITTER_HIST_BINS     57          /* Up to 2048us, the last one is open. */
+#define TX_JITTER_DEADLINE_US   1000        /* ISR lateness to count a miss. */
+#define TX_ARM_MIN_LEAD_US      2000        /* Min. time to arm a frame ahead. */
+#define TX_START_ERROR_NA       INT32_MIN   /* The frame has had no start time. */
+
+typedef struct
+{
+    volatile uint32_t _u32_seq;             /* Odd while ISR updates stats. */
+    uint32_t _u32_count;                    /* Symbols sampled. */
+    uint32_t _u32_min_us;
+    uint32_t _u32_max_us;
+    uint64_t _u64_sum_us;
+    uint32_t _u32_missed;                   /* Symbols over the deadline. */
+    uint32_t _pu32_hist[TX_JITTER_HIST_BINS];
+
+} TxJitterStats;
+
+/* Gives a frame buffer back to its owner. Runs in ISR context, once the
+   last symbol of the frame has been on air, or when the frame is dropped. */
+typedef void (*TxFrameRelease)(void *parg);
+
+typedef struct
+{
+    TonePackedFrame _tones;                 /* Referenced, not copied. */
+    uint64_t _u64_start_us;                 /* First symbol, uptime; 0 - at once. */
+    uint32_t _u32_dialfreqhz;               /* Dial freq. of the frame; 0 - keep. */
+    TxFrameRelease _release;                /* May be NULL. */
+    void *_parg;
+
+} TxChannelFrame;
 
 typedef struct
 {
@@ -64,21 +101,57 @@ typedef struct
 
     uint8_t _timer_alarm_num;
 
-    uint8_t _ix_input, _ix_output;
-    uint8_t _pbyte_buffer[256];
+    volatile uint32_t _ix_input;            /* Producer index, free running. */
+    volatile uint32_t _ix_output;           /* Consumer (ISR) index, free running. */
+    uint32_t _u32_fifo_mask;                /* FIFO capacity - 1, power of two. */
+    uint8_t *_pbyte_buffer;
+
+    TxChannelFrame _frame;                  /* Frame on air, served before FIFO. */
+    TxChannelFrame _next;                   /* Queued frame, follows _frame. */
+    volatile uint32_t _u32_frame_ix;        /* Next tone of _frame (ISR owned). */
+    volatile uint8_t _u8_frame_held;        /* _frame not released yet. */
+    volatile uint8_t _u8_next_held;         /* _next is queued. */
+    volatile uint8_t _u8_frame_wait;        /* _frame waits for its start time. */
 
     PioDco *_p_oscillator;
     uint32_t _u32_dialfreqhz;
+    uint32_t _u32_tone_step_milhz;          /* FSK freq. bin, see defines.h */
     int _i_tx_gpio;
 
+    TxJitterStats _jitter;                  /* ISR lateness, per transmission. */
+
+    uint64_t _u64_start_req_us;             /* Requested start of frame, uptime. */
+    int32_t _i32_start_error_us;            /* Achieved - requested start, us, or NA. */
+    volatile uint8_t _u8_start_armed;       /* Waiting for the first symbol. */
+
+    volatile int32_t _i32_fallback_ppb;     /* Crystal error w/o GPS, see TempComp. */
+    volatile uint8_t _u8_fallback_valid;
+
+    volatile uint8_t _u8_idle;              /* FIFO ran dry, alarm stopped. */
+    volatile uint8_t _u8_frame_done;        /* End of frame event, see TxChannelFrameDone. */
+
 } TxChannelContext;
 
 TxChannelContext *TxChannelInit(const uint32_t bit_period_us, 
-                                uint8_t timer_alarm_num, PioDco *pDCO);
+                                uint8_t timer_alarm_num, uint32_t fifo_size,
+                                PioDco *pDCO);
 
-uint8_t TxChannelPending(TxChannelContext *pctx);
-int TxChannelPush(TxChannelContext *pctx, uint8_t *psrc, int n);
+uint32_t TxChannelPending(const TxChannelContext *pctx);
+uint32_t TxChannelFree(const TxChannelContext *pctx);
+int TxChannelPush(TxChannelContext *pctx, const uint8_t *psrc, int n);
+int TxChannelQueueFrame(TxChannelContext *pctx, const TxChannelFrame *pframe);
 int TxChannelPop(TxChannelContext *pctx, uint8_t *pdst);
 void TxChannelClear(TxChannelContext *pctx);
+int TxChannelArmAt(TxChannelContext *pctx, uint64_t u64_start_us);
+int TxChannelFrameDone(TxChannelContext *pctx);
+void TxChannelSetFallbackPpb(TxChannelContext *pctx, int32_t i32_ppb);
+int32_t TxChannelGetCompensation(const TxChannelContext *pctx);
+int TxChannelFrameWords(const TxChannelContext *pctx, const TonePackedFrame *pframe,
+                        uint32_t *pu32_words, int max_words);
+
+void TxChannelGetJitter(const TxChannelContext *pctx, TxJitterStats *pdst);
+void TxChannelResetJitter(TxChannelContext *pctx);
+uint32_t TxJitterPercentile(const TxJitterStats *pstats, int percent);
+void TxChannelDumpJitter(const TxChannelContext *pctx);
 
 #endif
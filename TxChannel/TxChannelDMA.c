@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  TxChannelDMA.c - DMA & PIO driven TxChannel backend.
+//
+//  DESCRIPTION
+//      The whole frame of DCO control words is precomputed and streamed
+//      by DMA through a PIO pacer, so symbols change without any CPU
+//      interrupt. Core0 is free to sleep while a frame is on air.
+//
+//      The DCO worker on core1 re-reads its control word every loop, so
+//      a DMA write to it is a frequency change. The words are produced by
+//      PioDCOSetFreq() on a shadow copy of the DCO, no DCO math is duplicated.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "TxChannelDMA.h"
+#include <string.h>
+#ifndef TX_CHANNEL_HOST
+#include "hardware/clocks.h"
+#endif
+#include <defines.h>
+
+#include "txpacer.pio.h"
+#define LOG_MODULE TXCHANNEL
+#include "debug/log.h"
+
+static TxChannelDMAContext *spDMA = NULL;
+
+/// @brief Fires when the pacer has taken the pad word, i.e. the last symbol
+/// @brief of the frame has been on air for its full period.
+static void __not_in_flash_func (TxChannelDMAISR)(void)
+{
+    dma_channel_acknowledge_irq1(spDMA->_dma_drain);
+    spDMA->_pTX->_u8_frame_done = YES;
+    __sev();
+}
+
+/// @brief Initializes DMA backend on top of an existing TxChannel.
+/// @brief Disables the per-symbol alarm interrupt of the channel.
+/// @param pTX Channel providing dial freq., bit period and DCO.
+/// @param pio PIO block for the pacer (should not be the DCO's one).
+/// @return the Context.
+TxChannelDMAContext *TxChannelDMAInit(TxChannelContext *pTX, PIO pio)
+{
+    assert_(pTX);
+    assert_(pTX->_p_oscillator);
+
+    TxChannelDMAContext *p = calloc(1, sizeof(TxChannelDMAContext));
+    assert_(p);
+
+    p->_pTX = pTX;
+    p->_pio = pio;
+    p->_ism = pio_claim_unused_sm(pio, true);
+    p->_offset = pio_add_program(pio, &txpacer_program);
+    TxChannelDMASetPeriod(p);
+
+    p->_dma_feed = dma_claim_unused_channel(true);
+    p->_dma_drain = dma_claim_unused_channel(true);
+
+    /* Symbols are paced by PIO from now on, no need for the alarm ISR. */
+    hw_clear_bits(&timer_hw->inte, 1U << pTX->_timer_alarm_num);
+
+    assert_(!spDMA);
+    spDMA = p;
+    dma_channel_set_irq1_enabled(p->_dma_drain, true);
+    irq_set_exclusive_handler(DMA_IRQ_1, TxChannelDMAISR);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    LOG_D("TxChannelDMA: sm:%d dma:%d,%d cyc:%lu", p->_ism,
+          p->_dma_feed, p->_dma_drain, p->_u32_period_cycles);
+
+    return p;
+}
+
+/// @brief Sets the pacer to the symbol period of the channel in sys clock
+/// @brief cycles. Needed when the period (FT8/FT4 mode) or sys clock has
+/// @brief changed; does nothing otherwise. A change aborts the frame.
+/// @param pctx Context.
+void TxChannelDMASetPeriod(TxChannelDMAContext *pctx)
+{
+    assert_(pctx);
+
+    const uint64_t u64_cycles = (uint64_t)pctx->_pTX->_bit_period_us * clock_get_hz(clk_sys) / 1000000ULL;
+    assert_(u64_cycles > TXPACER_OVERHEAD_CYCLES && u64_cycles < UINT32_MAX);
+    if((uint32_t)u64_cycles == pctx->_u32_period_cycles)
+    {
+        return;
+    }
+
+    if(pctx->_u32_period_cycles)
+    {
+        TxChannelDMAStop(pctx);
+    }
+    txpacer_program_init(pctx->_pio, pctx->_ism, pctx->_offset, (uint32_t)u64_cycles);
+    pctx->_u32_period_cycles = (uint32_t)u64_cycles;
+}
+
+/// @brief Precomputes DCO control words of a frame and starts streaming.
+/// @brief Returns at once; the frame proceeds with no CPU involvement.
+/// @param pctx Context.
+/// @param pframe Packed tones of the frame, not needed after the call.
+/// @return 0 if OK, -1 if the frame is too long.
+int TxChannelDMASend(TxChannelDMAContext *pctx, const TonePackedFrame *pframe)
+{
+    assert_(pctx);
+    assert_(pframe);
+
+    if(pframe->_u16_ntones > TX_DMA_MAX_SYMBOLS)
+    {
+        return -1;
+    }
+
+    TxChannelDMAStop(pctx);
+    /* Sys clock may have been changed since, e.g. by PowerMgr. */
+    TxChannelDMASetPeriod(pctx);
+
+    TxChannelContext *pTX = pctx->_pTX;
+    pTX->_u8_frame_done = NO;
+    PioDco *pDCO = pTX->_p_oscillator;
+
+    const int n = TxChannelFrameWords(pTX, pframe, pctx->_pu32_words, TX_DMA_MAX_SYMBOLS + 1);
+    assert_(n > 0);
+
+    dma_channel_config cfg = dma_channel_get_default_config(pctx->_dma_feed);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(pctx->_pio, pctx->_ism, true));
+    dma_channel_configure(pctx->_dma_feed, &cfg, &pctx->_pio->txf[pctx->_ism],
+                          pctx->_pu32_words, n, false);
+
+    cfg = dma_channel_get_default_config(pctx->_dma_drain);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(pctx->_pio, pctx->_ism, false));
+    dma_channel_configure(pctx->_dma_drain, &cfg, &pDCO->_frq_cycles_per_pi,
+                          &pctx->_pio->rxf[pctx->_ism], n, false);
+
+    dma_start_channel_mask((1U << pctx->_dma_feed) | (1U << pctx->_dma_drain));
+    pio_sm_set_enabled(pctx->_pio, pctx->_ism, true);
+
+    return 0;
+}
+
+/// @brief Gets a count of symbols which haven't been completed yet.
+/// @param pctx Context.
+/// @return A count of symbols.
+uint32_t TxChannelDMAPending(const TxChannelDMAContext *pctx)
+{
+    assert_(pctx);
+
+    /* Abort leaves the count of an unfinished frame behind. */
+    if(!dma_channel_is_busy(pctx->_dma_drain))
+    {
+        return 0;
+    }
+
+    return dma_channel_hw_addr(pctx->_dma_drain)->transfer_count;
+}
+
+/// @brief Aborts the frame being sent and resets the pacer.
+/// @param pctx Context.
+void TxChannelDMAStop(TxChannelDMAContext *pctx)
+{
+    assert_(pctx);
+
+    pio_sm_set_enabled(pctx->_pio, pctx->_ism, false);
+    dma_channel_abort(pctx->_dma_feed);
+
+    /* Abort may raise a spurious completion IRQ (RP2040-E13). */
+    dma_channel_set_irq1_enabled(pctx->_dma_drain, false);
+    dma_channel_abort(pctx->_dma_drain);
+    dma_channel_acknowledge_irq1(pctx->_dma_drain);
+    dma_channel_set_irq1_enabled(pctx->_dma_drain, true);
+    pio_sm_clear_fifos(pctx->_pio, pctx->_ism);
+
+    /* Y holds the period; restart from `pull` keeping it intact. */
+    pio_sm_exec(pctx->_pio, pctx->_ism, pio_encode_jmp(pctx->_offset));
+}
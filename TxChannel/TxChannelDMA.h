@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  TxChannelDMA.h - DMA & PIO driven TxChannel backend.
+//
+//  DESCRIPTION
+//      The whole frame of DCO control words is precomputed and streamed
+//      by DMA through a PIO pacer, so symbols change without any CPU
+//      interrupt. Core0 is free to sleep while a frame is on air.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef TXCHANNELDMA_H_
+#define TXCHANNELDMA_H_
+
+#include <stdint.h>
+#include <TxChannel.h>
+#ifndef TX_CHANNEL_HOST
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#endif
+
+#define TX_DMA_MAX_SYMBOLS 256                   /* Longest frame (WSPR 162). */
+
+typedef struct
+{
+    TxChannelContext *_pTX;             /* Channel owning dial freq and DCO. */
+
+    PIO _pio;                           /* Pacer PIO. */
+    int _ism;                           /* Pacer state machine. */
+    int _offset;                        /* Pacer u-program offset. */
+
+    int _dma_feed;                      /* Control words -> pacer. */
+    int _dma_drain;                     /* Pacer -> DCO control word. */
+    uint32_t _u32_period_cycles;        /* Symbol period the pacer is set to. */
+
+    uint32_t _pu32_words[TX_DMA_MAX_SYMBOLS + 1];   /* Incl. the pad word. */
+
+} TxChannelDMAContext;
+
+TxChannelDMAContext *TxChannelDMAInit(TxChannelContext *pTX, PIO pio);
+void TxChannelDMASetPeriod(TxChannelDMAContext *pctx);
+int TxChannelDMASend(TxChannelDMAContext *pctx, const TonePackedFrame *pframe);
+uint32_t TxChannelDMAPending(const TxChannelDMAContext *pctx);
+void TxChannelDMAStop(TxChannelDMAContext *pctx);
+
+#endif
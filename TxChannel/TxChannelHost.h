@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  TxChannelHost.h - Simulated hardware for host builds.
+//
+//  DESCRIPTION
+//      With TX_CHANNEL_HOST defined TxChannel.c is built on a PC: the
+//      timer, alarm IRQs, interrupt masking and the DCO are replaced by the
+//      declarations below. Their implementation (the simulated clock and
+//      the alarm dispatcher) is up to the host program, see
+//      tools/txchannel_sim.c.
+//
+//      TxChannelDMA.c builds too, on the PIO, DMA and clock subset below;
+//      tools/txpacer_sim.c emulates them and runs txpacer.pio itself.
+//
+//  HOWTOSTART
+//      cc -DTX_CHANNEL_HOST -I. -ITxChannel ... TxChannel/TxChannel.c
+//
+//  PLATFORM
+//      Host (gcc, clang).
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef TXCHANNELHOST_H_
+#define TXCHANNELHOST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define assert_ assert
+#define __not_in_flash_func(func_name) func_name
+
+#define NUM_ALARMS              4
+#define PICO_DEFAULT_LED_PIN    25
+
+/* The subset of RP2040 timer registers used by TxChannel. A write to
+   alarm[n] arms the alarm, the host dispatcher detects it by the value. */
+typedef struct
+{
+    volatile uint32_t alarm[NUM_ALARMS];
+    volatile uint32_t timerawl;
+    volatile uint32_t intr;
+    volatile uint32_t inte;
+
+} timer_hw_t;
+
+extern timer_hw_t *timer_hw;
+
+typedef void (*irq_handler_t)(void);
+
+#define timer_hardware_alarm_get_irq_num(timer, n) (n)
+
+void irq_set_exclusive_handler(unsigned num, irq_handler_t handler);
+static inline void irq_set_priority(unsigned num, uint8_t priority) { (void)num; (void)priority; }
+static inline void irq_set_enabled(unsigned num, bool enabled) { (void)num; (void)enabled; }
+static inline void hardware_alarm_claim(unsigned num) { (void)num; }
+
+static inline void hw_set_bits(volatile uint32_t *p, uint32_t mask) { *p |= mask; }
+static inline void hw_clear_bits(volatile uint32_t *p, uint32_t mask) { *p &= ~mask; }
+
+/* Alarm handlers are called synchronously by the dispatcher, so there's
+   nothing to mask and no other core to order memory against. */
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t status) { (void)status; }
+static inline void __dmb(void) { }
+static inline void __sev(void) { }
+static inline void gpio_put(unsigned gpio, bool value) { (void)gpio; (void)value; }
+
+uint64_t time_us_64(void);
+
+typedef struct
+{
+    uint8_t _u8_is_solution_active;
+
+} GPStimeData;
+
+typedef struct
+{
+    GPStimeData _time_data;
+
+} GPStimeContext;
+
+typedef struct
+{
+    int32_t _frq_cycles_per_pi;             /* Control word of the DCO. */
+    uint32_t _clkfreq_hz;
+    GPStimeContext *_pGPStime;
+
+} PioDco;
+
+int PioDCOSetFreq(PioDco *pdco, uint32_t u32_frq_hz, int32_t u32_frq_millihz);
+int32_t PioDCOGetFreqShiftMilliHertz(const PioDco *pdco, uint64_t u64_desired_frq_millihz);
+
+/* Clocks, PIO and DMA used by TxChannelDMA.c. Names and signatures are of
+   the SDK; the PIO instruction encoders are the real ones. */
+typedef unsigned int uint;
+
+enum clock_index { clk_sys = 5 };
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#define NUM_PIO_STATE_MACHINES  4
+
+typedef struct
+{
+    volatile uint32_t txf[NUM_PIO_STATE_MACHINES];
+    volatile uint32_t rxf[NUM_PIO_STATE_MACHINES];
+
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+typedef struct
+{
+    uint32_t _u32_clkdiv_int;
+    uint8_t _u8_clkdiv_frac;
+    uint8_t _u8_wrap_target;
+    uint8_t _u8_wrap;
+
+} pio_sm_config;
+
+struct pio_program
+{
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+};
+
+enum pio_src_dest
+{
+    pio_pins = 0, pio_x = 1, pio_y = 2, pio_null = 3,
+    pio_exec_mov = 4, pio_pc = 5, pio_isr = 6, pio_osr = 7
+};
+
+int pio_claim_unused_sm(PIO pio, bool required);
+uint pio_add_program(PIO pio, const struct pio_program *program);
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+
+/* What pioasm makes of txpacer.pio besides its c-sdk block; the host
+   program assembles the .pio itself. */
+extern const struct pio_program txpacer_program;
+pio_sm_config txpacer_program_get_default_config(uint offset);
+
+static inline void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac)
+{
+    c->_u32_clkdiv_int = div_int;
+    c->_u8_clkdiv_frac = div_frac;
+}
+static inline uint pio_encode_jmp(uint addr) { return addr & 0x1Fu; }
+static inline uint pio_encode_pull(bool if_empty, bool block)
+{
+    return 0x8080u | (if_empty ? 0x40u : 0u) | (block ? 0x20u : 0u);
+}
+static inline uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src)
+{
+    return 0xA000u | ((uint)dest << 5) | (uint)src;
+}
+
+#define DMA_IRQ_1               12
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct
+{
+    uint8_t _u8_size;
+    bool _read_incr;
+    bool _write_incr;
+    uint _dreq;
+
+} dma_channel_config;
+
+typedef struct
+{
+    volatile uint32_t transfer_count;
+
+} dma_channel_hw_t;
+
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_start_channel_mask(uint32_t chan_mask);
+void dma_channel_abort(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+void dma_channel_acknowledge_irq1(uint channel);
+dma_channel_hw_t *dma_channel_hw_addr(uint channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c,
+                                                         enum dma_channel_transfer_size size)
+{
+    c->_u8_size = (uint8_t)size;
+}
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { c->_read_incr = incr; }
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { c->_write_incr = incr; }
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { c->_dreq = dreq; }
+
+#endif
@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  ToneBank.h - Flash resident precomputed tone bank.
+//
+//  DESCRIPTION
+//      Tones of a fixed set of messages (ToneBank.txt) are computed on the
+//      build host by tools/tonebank_gen.c and linked as const data, which
+//      stays in flash. A message found in the bank is handed over to
+//      TxChannel as a pointer, with no packing or LDPC encoding on device.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef TONEBANK_H_
+#define TONEBANK_H_
+
+#include <stdint.h>
+#include "TonePack.h"
+
+typedef struct
+{
+    const char *_ptext;                 /* Message as it's formatted by the beacon. */
+    uint8_t _u8_mode;                   /* WSPR_MODE_FT8 or WSPR_MODE_FT4. */
+    TonePackedFrame _frame;             /* Packed tones in flash. */
+
+} ToneBankEntry;
+
+/* Generated, see tools/tonebank_gen.c. The id of a message is its index. */
+extern const ToneBankEntry kToneBank[];
+extern const uint16_t kToneBankCount;
+
+const ToneBankEntry *ToneBankGet(uint16_t id);
+const ToneBankEntry *ToneBankFind(uint8_t mode, const char *ptext);
+
+#endif
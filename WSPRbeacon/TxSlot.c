@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  TxSlot.c - FT8/FT4 TX slot selection.
+//
+//  DESCRIPTION
+//      The slot rules of the beacon: which slots are for TX (parity, skip),
+//      the GPS time reference (PPS edge or NMEA sentence) and the search
+//      for the next TX slot from it. Pure arithmetic on uptime & unix time,
+//      no hardware access, so it's built on host too (WSPR_SLOT_HOST), see
+//      tools/sched_sim.c.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "TxSlot.h"
+#include <stddef.h>
+
+/// @brief Checks whether a slot is to be used for TX according to schedule.
+/// @param psched Schedule.
+/// @param u64_slot Slot index counted from unix epoch.
+/// @return 1 if the beacon should transmit in the slot.
+int WSPRbeaconIsTxSlot(const WSPRbeaconSchedule *psched, uint64_t u64_slot)
+{
+    assert_(psched);
+
+    if((WSPR_SLOT_EVEN == psched->_u8_tx_slot_parity && (u64_slot & 1))
+       || (WSPR_SLOT_ODD == psched->_u8_tx_slot_parity && !(u64_slot & 1)))
+    {
+        return 0;
+    }
+
+    const uint64_t u64_eligible = WSPR_SLOT_ANY == psched->_u8_tx_slot_parity
+                                  ? u64_slot : u64_slot >> 1;
+
+    return 0 == u64_eligible % (psched->_u8_tx_slot_skip + 1U);
+}
+
+/// @brief Gets the uptime of the last whole GPS second and its unix time.
+/// @param u32_utime_nmea Unix time of the last NMEA sentence, s; 0 - none yet.
+/// @param u64_nmea_us Uptime when the sentence has been received, us.
+/// @param u64_pps_us Uptime of the last PPS edge, us; 0 - no PPS.
+/// @param i32_clock_ppb Uptime clock error measured by GPS, ppb; 0 - unknown.
+/// @param pref Ptr to write the reference.
+/// @return 0 if OK, -1 if no GPS time is available.
+int TxSlotGetTimeRef(uint32_t u32_utime_nmea, uint64_t u64_nmea_us, uint64_t u64_pps_us,
+                     int32_t i32_clock_ppb, TxSlotTimeRef *pref)
+{
+    assert_(pref);
+
+    if(!u32_utime_nmea)
+    {
+        return -1;
+    }
+
+    pref->_u64_sec_ms = (uint64_t)u32_utime_nmea * 1000ULL;
+    pref->_i32_clock_ppb = i32_clock_ppb;
+
+    /* Prefer PPS edge. It precedes NMEA sentence of the same second, so
+       an edge after the sentence is of the next second, which sentence
+       isn't in yet. NMEA alone is late by the receiver's latency. */
+    if(u64_pps_us && u64_pps_us <= u64_nmea_us && u64_nmea_us - u64_pps_us < 1000000ULL)
+    {
+        pref->_u64_sec_us = u64_pps_us;
+    }
+    else if(u64_pps_us > u64_nmea_us && u64_pps_us - u64_nmea_us < 1000000ULL)
+    {
+        pref->_u64_sec_us = u64_pps_us;
+        pref->_u64_sec_ms += 1000ULL;
+    }
+    else
+    {
+        pref->_u64_sec_us = u64_nmea_us;
+    }
+
+    return 0;
+}
+
+/// @brief Converts a span of true time to the span of uptime clock.
+/// @param pref Time reference holding the clock error.
+/// @param i64_us Span of true time, us.
+/// @return Span of uptime, us.
+static int64_t TxSlotToUptime(const TxSlotTimeRef *pref, int64_t i64_us)
+{
+    return i64_us + i64_us * pref->_i32_clock_ppb / 1000000000LL;
+}
+
+/// @brief Finds the next slot to transmit in, at least u64_lead_us ahead.
+/// @param psched Schedule.
+/// @param u32_slot_ms Slot period of the mode, ms.
+/// @param pref GPS time reference.
+/// @param u64_now_us Uptime now, us.
+/// @param u64_lead_us Min. time from now to the first symbol, us.
+/// @param pu64_slot Ptr to write slot index (can be NULL).
+/// @return Start of the first symbol, us since boot (incl. tx offset), or 0.
+uint64_t TxSlotFindNext(const WSPRbeaconSchedule *psched, uint32_t u32_slot_ms,
+                        const TxSlotTimeRef *pref, uint64_t u64_now_us, uint64_t u64_lead_us,
+                        uint64_t *pu64_slot)
+{
+    assert_(psched);
+    assert_(pref);
+    assert_(u32_slot_ms);
+
+    /* A slot far ahead (large skip) drifts by the clock error otherwise. */
+    const int64_t i64_since_us = (int64_t)(u64_now_us - pref->_u64_sec_us);
+    const uint64_t u64_now_ms = pref->_u64_sec_ms
+        + (i64_since_us - i64_since_us * pref->_i32_clock_ppb / 1000000000LL) / 1000;
+
+    /* Parity halves and skip divides eligible slots, so this always ends. */
+    const int imax = 2 * (psched->_u8_tx_slot_skip + 1) + 2;
+    uint64_t u64_slot = u64_now_ms / u32_slot_ms + 1;
+    for(int i = 0; i < imax; ++i, ++u64_slot)
+    {
+        const int64_t i64_ahead_us = (int64_t)(u64_slot * u32_slot_ms - pref->_u64_sec_ms) * 1000LL
+                                     + (int64_t)psched->_i16_tx_offset_ms * 1000LL;
+        const uint64_t u64_start_us = pref->_u64_sec_us + TxSlotToUptime(pref, i64_ahead_us);
+        if(u64_start_us < u64_now_us + u64_lead_us)
+        {
+            continue;
+        }
+
+        if(WSPRbeaconIsTxSlot(psched, u64_slot))
+        {
+            if(pu64_slot)
+            {
+                *pu64_slot = u64_slot;
+            }
+
+            return u64_start_us;
+        }
+    }
+
+    return 0;
+}
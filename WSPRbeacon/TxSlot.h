@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  TxSlot.h - FT8/FT4 TX slot selection.
+//
+//  DESCRIPTION
+//      The slot rules of the beacon: which slots are for TX (parity, skip),
+//      the GPS time reference (PPS edge or NMEA sentence) and the search
+//      for the next TX slot from it. Pure arithmetic on uptime & unix time,
+//      no hardware access, so it's built on host too (WSPR_SLOT_HOST), see
+//      tools/sched_sim.c.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef TXSLOT_H_
+#define TXSLOT_H_
+
+#include <stdint.h>
+
+#ifdef WSPR_SLOT_HOST
+#include <assert.h>
+#define assert_ assert
+#else
+#include "../pico-hf-oscillator/lib/assert.h"
+#endif
+
+enum
+{
+    WSPR_MODE_FT8 = 0,                  /* 15 s slots, 79 symbols, 8-FSK. */
+    WSPR_MODE_FT4                       /* 7.5 s slots, 105 symbols, 4-FSK. */
+};
+
+enum
+{
+    WSPR_SLOT_ANY = 0,                  /* Every slot is eligible. */
+    WSPR_SLOT_EVEN,                     /* 1st, 3rd, ... slot of minute. */
+    WSPR_SLOT_ODD                       /* 2nd, 4th, ... slot of minute. */
+};
+
+typedef struct
+{
+    uint8_t _u8_tx_mode;                /* WSPR_MODE_FT8 or WSPR_MODE_FT4. */
+    uint8_t _u8_tx_slot_parity;         /* WSPR_SLOT_ANY, _EVEN or _ODD. */
+    uint8_t _u8_tx_slot_skip;           /* 0=1tx0skip, 1=1tx1skip, 2=1tx2skip, ... */
+    uint8_t _u8_tx_GPS_mandatory;       /* No tx when no active GPS solution. */
+    uint8_t _u8_tx_GPS_past_time;       /* Override _u8_tx_GPS_mandatory if there 
+                                           was solution in the past. */
+    uint8_t _u8_tx_heating_pause_min;   /* No tx during this interval from start. */
+    int16_t _i16_tx_offset_ms;          /* First symbol delay after slot boundary. */
+    uint8_t _u8_tx_naux_max;            /* Aux. channels allowed to transmit. */
+
+} WSPRbeaconSchedule;
+
+typedef struct
+{
+    uint64_t _u64_sec_us;               /* Uptime of a whole GPS second, us. */
+    uint64_t _u64_sec_ms;               /* Unix time of that second, ms. */
+    int32_t _i32_clock_ppb;             /* Uptime clock error, > 0 - runs fast. */
+
+} TxSlotTimeRef;
+
+int WSPRbeaconIsTxSlot(const WSPRbeaconSchedule *psched, uint64_t u64_slot);
+int TxSlotGetTimeRef(uint32_t u32_utime_nmea, uint64_t u64_nmea_us, uint64_t u64_pps_us,
+                     int32_t i32_clock_ppb, TxSlotTimeRef *pref);
+uint64_t TxSlotFindNext(const WSPRbeaconSchedule *psched, uint32_t u32_slot_ms,
+                        const TxSlotTimeRef *pref, uint64_t u64_now_us, uint64_t u64_lead_us,
+                        uint64_t *pu64_slot);
+
+#endif
@@ -53,7 +53,10 @@
 #include <WSPRutility.h>
 #include <maidenhead.h>
 
-#include "debug/logutils.h"
+#include <Metrics.h>
+#include "debug/stagetimer.h"
+#define LOG_MODULE BEACON
+#include "debug/log.h"
 
 // An FT8 signal starts 0.5 seconds into a cycle and lasts 12.64 seconds. It
 // consists of 79 symbols, each 0.16 seconds long. Each symbol is a single
@@ -93,16 +96,63 @@ WSPRbeaconContext *WSPRbeaconInit(const char *pcallsign, const char *pgridsquare
     p->_u8_txpower = txpow_dbm;
 
     // http://squirrelengineering.com/high-altitude-balloon/adrift-problem-solving-fs2-wspr-drift/
-    // p->_pTX = TxChannelInit(682667, 0, pdco); // WSPR_DELAY is 683
-    // p->_pTX = TxChannelInit(159000, 0, pdco); // FT8_DELAY is 159
-    p->_pTX = TxChannelInit(159000, 0, pdco); // FT8_DELAY is 159
+    // p->_pTX = TxChannelInit(682667, 0, 256, pdco); // WSPR_DELAY is 683
+    // p->_pTX = TxChannelInit(159000, 0, 256, pdco); // FT8_DELAY is 159
+    p->_pTX = TxChannelInit(159000, 0, WSPR_TX_FIFO_SIZE, pdco); // FT8_DELAY is 159
     assert_(p->_pTX);
     p->_pTX->_u32_dialfreqhz = dial_freq_hz + shift_freq_hz;
     p->_pTX->_i_tx_gpio = gpio;
+    p->_u32_dialfreqhz = p->_pTX->_u32_dialfreqhz;
+    p->_txSched._u8_tx_naux_max = WSPR_MAX_AUX_CHANNELS;
+
+#if TXCHANNEL_DMA_BACKEND
+    p->_pTXDMA = TxChannelDMAInit(p->_pTX, pio1);
+    assert_(p->_pTXDMA);
+#endif
 
     return p;
 }
 
+/// @brief Adds one more RF output which sends the same packets in the same
+/// @brief slots as the main one, e.g. on another band.
+/// @param pctx Context.
+/// @param pdco Ptr to DCO of this output.
+/// @param dial_freq_hz The begin of working passband of this output.
+/// @param shift_freq_hz The shift of tx freq. relative to dial_freq_hz.
+/// @param gpio Pico's GPIO pin of RF output.
+/// @return Index of aux. channel, or -1 if no more channels available.
+/// @remark Each DCO needs its own PIO SM and a core running PioDCOWorker2
+/// @remark on it; the caller starts & stops the aux. DCOs.
+/// @remark DMA backend streams the main channel only, it has no aux. ones.
+int WSPRbeaconAddChannel(WSPRbeaconContext *pctx, PioDco *pdco, uint32_t dial_freq_hz,
+                         uint32_t shift_freq_hz, int gpio)
+{
+    assert_(pctx);
+    assert_(pdco);
+
+#if TXCHANNEL_DMA_BACKEND
+    LOG_E("WSPR> No aux. channels with TXCHANNEL_DMA_BACKEND.");
+    assert_(!TXCHANNEL_DMA_BACKEND);
+    return -1;
+#endif
+
+    if(pctx->_u8_naux >= WSPR_MAX_AUX_CHANNELS)
+    {
+        return -1;
+    }
+
+    const int ix = pctx->_u8_naux;
+    TxChannelContext *pTX = TxChannelInit(pctx->_pTX->_bit_period_us, 1 + ix, WSPR_TX_FIFO_SIZE, pdco);
+    assert_(pTX);
+    pTX->_u32_dialfreqhz = dial_freq_hz + shift_freq_hz;
+    pTX->_i_tx_gpio = gpio;
+
+    pctx->_pTXaux[ix] = pTX;
+    ++pctx->_u8_naux;
+
+    return ix;
+}
+
 /// @brief Sets dial (baseband minima) freq.
 /// @param pctx Context.
 /// @param freq_hz the freq., Hz.
@@ -110,6 +160,59 @@ void WSPRbeaconSetDialFreq(WSPRbeaconContext *pctx, uint32_t freq_hz)
 {
     assert_(pctx);
     pctx->_pTX->_u32_dialfreqhz = freq_hz;
+    pctx->_u32_dialfreqhz = freq_hz;
+}
+
+/// @brief Sets the messages to send in turn instead of the built-in one.
+/// @brief Its default band is the dial freq. of the beacon, other bands
+/// @brief retune the main channel for a frame.
+/// @param pctx Context.
+/// @param pPL Playlist, NULL - back to the built-in message.
+void WSPRbeaconSetPlaylist(WSPRbeaconContext *pctx, PlaylistContext *pPL)
+{
+    assert_(pctx);
+    pctx->_pPL = pPL;
+    if(pPL)
+    {
+        PlaylistReset(pPL, pctx->_u64_next_slot);
+    }
+}
+
+typedef struct
+{
+    uint32_t _u32_slot_ms;              /* Slot period. */
+    uint32_t _u32_symbol_us;            /* TxChannel bit period. */
+    uint32_t _u32_tone_step_milhz;      /* FSK freq. bin. */
+    uint16_t _u16_nsymbols;             /* Channel symbols per frame. */
+
+} WSPRbeaconModeParams;
+
+static const WSPRbeaconModeParams skModeParams[] =
+{
+    [WSPR_MODE_FT8] = { 15000, 159000, WSPR_FREQ_STEP_MILHZ, 79 },     // FT8_DELAY is 159
+    [WSPR_MODE_FT4] = { 7500, 48000, FT4_FREQ_STEP_MILHZ, 105 },
+};
+
+/// @brief Switches the beacon between FT8 and FT4.
+/// @param pctx Context.
+/// @param mode WSPR_MODE_FT8 or WSPR_MODE_FT4.
+void WSPRbeaconSetMode(WSPRbeaconContext *pctx, uint8_t mode)
+{
+    assert_(pctx);
+    assert_(mode < count_of(skModeParams));
+
+    pctx->_txSched._u8_tx_mode = mode;
+
+    for(int i = -1; i < pctx->_u8_naux; ++i)
+    {
+        TxChannelContext *pTX = i < 0 ? pctx->_pTX : pctx->_pTXaux[i];
+        pTX->_bit_period_us = skModeParams[mode]._u32_symbol_us;
+        pTX->_u32_tone_step_milhz = skModeParams[mode]._u32_tone_step_milhz;
+    }
+#if TXCHANNEL_DMA_BACKEND
+    /* The pacer counts the period in clock cycles, set it again. */
+    TxChannelDMASetPeriod(pctx->_pTXDMA);
+#endif
 }
 
 #include <stdlib.h>
@@ -117,19 +220,16 @@ void WSPRbeaconSetDialFreq(WSPRbeaconContext *pctx, uint32_t freq_hz)
 #include <stdio.h>
 #include <math.h>
 #include <stdbool.h>
-#include <power_status.h>
-#include "hardware/adc.h"
 #include "pico/float.h"
 
 #include "common/common.h"
 #include "ft8/message.h"
 #include "ft8/encode.h"
 #include "ft8/constants.h"
-
-#define LOG_LEVEL LOG_INFO
-#include "ft8/debug.h"
-
-void packtext77(const char* text, uint8_t* b77);
+#include "ft8/template.h"
+#include "ft8/hash_table.h"
+#include "ToneBank.h"
+#include "Telemetry.h"
 
 //   0 -> > 80%
 //  -1 -> > 60%
@@ -143,20 +243,19 @@ const float max_battery_volts = 4.2f;
 
 bool is_init_message = true;
 
-char message_buffer[32];
+char message_buffer[PLAYLIST_TEXT_LEN + 8];
 
-void ft8_encode_top(uint8_t *tones)
-{
-    // char *message = "WQ6WW1HDK1TE"; // ATTN: You will want to customize this message!
-    // char *message_buffer = "CQ K1TE FN42";
+// Only the grid changes slot to slot, the rest of the message is encoded once.
+#define MESSAGE_PATTERN "CQ VU3CER " FTX_TEMPLATE_FIELD
+ftx_template_t message_template;
+const char *template_pattern = NULL; // pattern the template is compiled for
+int template_mode = -1; // mode the template is compiled for, -1 - none
 
-    // XXX Pico W uses a CYW43 pin to get VBUS so we need to initialise it
-    bool old_battery_status = false;
-    bool battery_status = true;
-    // Get voltage
-    float voltage = 0;
-    int voltage_return = power_voltage(&voltage);
-    voltage_return = power_voltage(&voltage);
+// Telemetry field: the grid is "subtracted" from MK68 as battery drains.
+static void battery_grid(char *grid, uint32_t vsys_mv)
+{
+    // VSYS comes from the background sampler, 0 if unknown (report full battery).
+    float voltage = vsys_mv ? vsys_mv / 1000.f : max_battery_volts;
     voltage = floorf(voltage * 100) / 100;
     int percent_val = (int) (((voltage - min_battery_volts) / (max_battery_volts - min_battery_volts)) * 100);
     if (percent_val > 80)
@@ -179,132 +278,694 @@ void ft8_encode_top(uint8_t *tones)
     }
 
     // char *message = "CQ VU3CER MK68"; // MK68 - Base grid when battery is maximum, "Subtract" for lower battery levels!
-    sprintf(message_buffer, "CQ VU3CER MK%02d", 68 + battery_level); // Base grid is MK68 for this message
+    sprintf(grid, "MK%02d", 68 + battery_level); // Base grid is MK68 for this message
+}
+
+// Sets up the frame to send: precomputed tones of the tone bank, or tones
+// encoded and packed into the buffer given. The text is sent as is, or it's
+// a pattern (NULL - the built-in one) whose field gets the battery grid, or
+// the frame is the telemetry record in binary.
+int ft8_encode_top(TonePackedFrame *frame, uint8_t *packbuf, uint32_t packbuf_size,
+                   uint8_t mode, const char *text, uint8_t kind, const TelemetryRecord *tlm)
+{
+    // char *message = "WQ6WW1HDK1TE"; // ATTN: You will want to customize this message!
+    // char *message_buffer = "CQ K1TE FN42";
+
+    const uint32_t u32_format_start = StageTimerNow();
+
+    const char *pattern = text ? text : MESSAGE_PATTERN;
+    const bool is_pattern = !text || PLAYLIST_KIND_PATTERN == kind;
+    const bool is_telemetry = text && PLAYLIST_KIND_TELEMETRY == kind;
+    char grid[8] = "";
+    if (is_pattern) {
+        battery_grid(grid, tlm->_u8_flags & TELEMETRY_FLAG_ADC ? tlm->_u32_vsys_mv : 0);
+        const char *field = strstr(pattern, FTX_TEMPLATE_FIELD);
+        if (!field) {
+            return -1;
+        }
+        snprintf(message_buffer, sizeof(message_buffer), "%.*s%s%s", (int)(field - pattern), pattern,
+                 grid, field + strlen(FTX_TEMPLATE_FIELD));
+    } else if (is_telemetry) {
+        message_buffer[0] = '\0';
+    } else {
+        snprintf(message_buffer, sizeof(message_buffer), "%s", text);
+    }
+    StageTimerAccount(STAGE_MESSAGE_FORMAT, u32_format_start);
+
+    // Precomputed on the build host? Then it's a pointer to flash, no encoding.
+    const ToneBankEntry *pbank = is_telemetry ? NULL : ToneBankFind(mode, message_buffer);
+    if (pbank) {
+        BLOG_D(1, "Tone bank id: %lu", (uint32_t)(pbank - kToneBank));
+        *frame = pbank->_frame;
+        return 0;
+    }
+
+    if (is_pattern && (template_mode != mode || template_pattern != pattern)) {
+        // Once per pattern & mode: FT4 scrambles the payload, its codewords differ.
+        template_pattern = pattern;
+        template_mode = ftx_template_compile(&message_template, pattern, &ftx_hash_table_if, WSPR_MODE_FT4 == mode)
+                        == FTX_MESSAGE_RC_OK ? mode : -1;
+    }
+    const bool use_template = is_pattern && template_mode == mode;
+    uint32_t grid_value = 0;
+
     // First, pack the text data into binary message
     ftx_message_t msg;
-    ftx_message_rc_t rc = ftx_message_encode(&msg, NULL, message_buffer);
+    ftx_message_rc_t rc = FTX_MESSAGE_RC_OK;
+    STAGE_TIMED(STAGE_MESSAGE_ENCODE) {
+        if (use_template) {
+            grid_value = ftx_template_pack_field(&message_template, grid);
+            ftx_template_payload(&message_template, grid_value, msg.payload);
+        } else if (is_telemetry) {
+            uint8_t b71[TELEMETRY_BYTES];
+            TelemetryPack(tlm, b71);
+            ftx_message_encode_telemetry(&msg, b71);
+        } else {
+            // Free text is the last resort of the encoder
+            rc = ftx_message_encode(&msg, &ftx_hash_table_if, message_buffer);
+        }
+    }
     if (rc != FTX_MESSAGE_RC_OK) {
-        // Try 'free text' encoding
-        if (strlen(message_buffer) <= 13)
-            packtext77(message_buffer, (uint8_t *)&msg.payload);
-        else {
-            printf("Cannot parse message!\n");
-            printf("RC = %d\n", (int)rc);
-       }
+        BLOG_W(1, "Cannot parse message! RC = %ld", rc);
+        return -1;
     }
 
-    printf("Packed data: ");
-    for (int j = 0; j < 10; ++j) {
-        printf("%02x ", msg.payload[j]);
-    }
-    printf("\n");
+    // Deferred logging, it's 1 s before the slot.
+    const uint8_t *pl = msg.payload;
+    BLOG_D(3, "Packed data: %08lx%08lx%04lx",
+            (uint32_t)pl[0] << 24 | pl[1] << 16 | pl[2] << 8 | pl[3],
+            (uint32_t)pl[4] << 24 | pl[5] << 16 | pl[6] << 8 | pl[7],
+            (uint32_t)pl[8] << 8 | pl[9]);
 
+    uint8_t tones[FT4_NN];
     int num_tones = FT8_NN;
 
-    ft8_encode(msg.payload, tones);
+    STAGE_TIMED(STAGE_TONE_ENCODE) {
+        if (WSPR_MODE_FT4 == mode)
+            num_tones = FT4_NN;
+        if (use_template) {
+            // Constant codeword XOR codewords of the grid bits set.
+            ftx_template_encode(&message_template, grid_value, tones);
+        } else if (WSPR_MODE_FT4 == mode) {
+            ft4_encode(msg.payload, tones);
+        } else {
+            ft8_encode(msg.payload, tones);
+        }
+    }
 
-    printf("FSK tones: ");
-    for (int j = 0; j < num_tones; ++j) {
-        printf("%d", tones[j]);
+    // 3-bit tones are packed as octal digits, 10 per arg, 30 per record.
+    for (int j = 0; j < num_tones; j += 30) {
+        uint32_t words[3] = { 0 };
+        for (int k = 0; k < 30; ++k) {
+            words[k / 10] = words[k / 10] << 3 | (j + k < num_tones ? tones[j + k] : 0);
+        }
+        BLOG_D(4, "FSK tones[%02lu]: %010lo%010lo%010lo", j, words[0], words[1], words[2]);
     }
-    printf("\n");
+
+    // 2 bits per 4-FSK tone, 3 per 8-FSK one.
+    return TonePackFrame(frame, packbuf, packbuf_size, tones, num_tones,
+                         WSPR_MODE_FT4 == mode ? 2 : 3);
+}
+
+/// @brief Collects the state of the beacon to report on air.
+/// @param pctx Context.
+/// @param prec Ptr to write the record.
+static void WSPRbeaconGetTelemetry(const WSPRbeaconContext *pctx, TelemetryRecord *prec)
+{
+    memset(prec, 0, sizeof(TelemetryRecord));
+
+    STAGE_TIMED(STAGE_VSYS_READ)
+    {
+        if(pctx->_pADC && AdcSamplerIsValid(pctx->_pADC))
+        {
+            prec->_u8_flags |= TELEMETRY_FLAG_ADC;
+            prec->_u32_vsys_mv = AdcSamplerGetVsysMv(pctx->_pADC);
+            prec->_i32_temp_centi = AdcSamplerGetTempCenti(pctx->_pADC);
+        }
+    }
+
+    const GPStimeContext *pGPS = pctx->_pTX->_p_oscillator->_pGPStime;
+    if(pGPS && pGPS->_time_data._u8_is_solution_active)
+    {
+        prec->_u8_flags |= TELEMETRY_FLAG_GPS;
+        prec->_i32_ppb = pGPS->_time_data._i32_freq_shift_ppb;
+    }
+    else if(pctx->_pTX->_u8_fallback_valid)
+    {
+        prec->_u8_flags |= TELEMETRY_FLAG_FALLBACK;
+        prec->_i32_ppb = pctx->_pTX->_i32_fallback_ppb;
+    }
+
+    prec->_u32_uptime_s = (uint32_t)(GetUptime64() / 1000000ULL);
+    prec->_u32_nsent = (uint32_t)MetricsGet(METRIC_FRAMES_SENT);
 }
 
 /// @brief Constructs a new WSPR packet using the data available.
+/// @brief It's encoded into a pack buffer no channel holds, so a frame on
+/// @brief air is never overwritten.
 /// @param pctx Context
-/// @return 0 if OK.
-int WSPRbeaconCreatePacket(WSPRbeaconContext *pctx)
+/// @param use_playlist Whether the message is the one the playlist picks
+/// @param use_playlist for _u64_next_slot (if any), or the default one.
+/// @return 0 if OK, -1 if no free buffer, no message for the slot or
+/// @return encoding error.
+static int WSPRbeaconEncodePacket(WSPRbeaconContext *pctx, int use_playlist)
 {
     assert_(pctx);
 
+    /* Not the buffer of the last frame: it may be queued but not sent yet. */
+    int ibuf = -1;
+    for(int i = 0; i < WSPR_PACK_BUFFERS; ++i)
+    {
+        if(!pctx->_pu8_packbuf_refs[i] && (ibuf < 0 || i != pctx->_i8_frame_buf))
+        {
+            ibuf = i;
+        }
+    }
+    if(ibuf < 0)
+    {
+        return -1;
+    }
+    pctx->_u8_frame_ready = NO;
+
+    const PlaylistEntry *pentry = NULL;
+    pctx->_u32_frame_dialfreqhz = pctx->_u32_dialfreqhz;
+    if(use_playlist && pctx->_pPL)
+    {
+        pentry = PlaylistNext(pctx->_pPL, pctx->_u64_next_slot);
+        if(!pentry)
+        {
+            pctx->_frame._u16_ntones = 0;
+            return -1;
+        }
+        const uint32_t u32_freq_hz = PlaylistFreqHz(pctx->_pPL, pentry);
+        if(u32_freq_hz)
+        {
+            pctx->_u32_frame_dialfreqhz = u32_freq_hz;
+        }
+    }
+
     // wspr_encode(pctx->_pu8_callsign, pctx->_pu8_locator, pctx->_u8_txpower, pctx->_pu8_outbuf);
 
     // FT8 hack
-    ft8_encode_top(pctx->_pu8_outbuf);
+    int ret;
+    STAGE_TIMED(STAGE_CREATE_PACKET)
+    {
+        TelemetryRecord tlm;
+        WSPRbeaconGetTelemetry(pctx, &tlm);
+        ret = ft8_encode_top(&pctx->_frame, pctx->_pu8_packbuf[ibuf], sizeof(pctx->_pu8_packbuf[ibuf]),
+                             pctx->_txSched._u8_tx_mode, pentry ? pentry->_pc_text : NULL,
+                             pentry ? pentry->_u8_kind : PLAYLIST_KIND_PATTERN, &tlm);
+    }
+    if(ret)
+    {
+        pctx->_frame._u16_ntones = 0;   /* Nothing to send, see SendPacketAt. */
+    }
+    pctx->_i8_frame_buf = pctx->_frame._pu8_data == pctx->_pu8_packbuf[ibuf] ? ibuf : -1;
+    MetricsObserve(METRIC_ENCODE_US, StageTimerGet(STAGE_CREATE_PACKET)->_u32_last);
 
-    return 0;
+    return ret;
 }
 
-#define FT8_SYMBOL_COUNT 79
+/// @brief Constructs the packet of the next TX slot. With a playlist, the
+/// @brief message is the one it picks for _u64_next_slot; the pick counts
+/// @brief against the playlist (turn, pass and band gap).
+/// @param pctx Context
+/// @return 0 if OK, -1 if no free buffer, no message for the slot or
+/// @return encoding error.
+int WSPRbeaconCreatePacket(WSPRbeaconContext *pctx)
+{
+    return WSPRbeaconEncodePacket(pctx, YES);
+}
+
+/// @brief Constructs a packet to send out of schedule, e.g. by the button.
+/// @brief It is the default message at the beacon's own dial freq., the
+/// @brief playlist isn't touched. Refused while the frame of the armed
+/// @brief slot is prepared (and maybe queued), not to drop it.
+/// @param pctx Context
+/// @return 0 if OK, -1 if refused, no free buffer or encoding error.
+int WSPRbeaconCreateManualPacket(WSPRbeaconContext *pctx)
+{
+    assert_(pctx);
+
+    if(pctx->_u8_frame_ready)
+    {
+        return -1;
+    }
+
+    return WSPRbeaconEncodePacket(pctx, NO);
+}
+
+/// @brief Gives a pack buffer back when a channel is done with its frame.
+/// @param parg Ptr to the reference count of the buffer.
+static void __not_in_flash_func (WSPRbeaconReleaseBuffer)(void *parg)
+{
+    /* Alarm ISRs of all channels have the same priority, no nesting. */
+    --*(volatile uint8_t *)parg;
+}
 
 /// @brief Sends a prepared WSPR packet using TxChannel.
 /// @param pctx Context.
 /// @return 0, if OK.
-int WSPRbeaconSendPacket(const WSPRbeaconContext *pctx)
+int WSPRbeaconSendPacket(WSPRbeaconContext *pctx)
+{
+    return WSPRbeaconSendPacketAt(pctx, 0);
+}
+
+/// @brief Sends a prepared packet so that its first symbol starts exactly
+/// @brief at the given time (see WSPRbeaconGetSlotStart). Drops frames
+/// @brief being sent or queued.
+/// @param pctx Context.
+/// @param u64_start_us Start of the first symbol, us since boot; 0 - ASAP.
+/// @return 0, if OK.
+int WSPRbeaconSendPacketAt(WSPRbeaconContext *pctx, uint64_t u64_start_us)
 {
     assert_(pctx);
     assert_(pctx->_pTX);
     assert_(pctx->_pTX->_u32_dialfreqhz > 500 * kHz);
 
-    TxChannelClear(pctx->_pTX);
+    if(pctx->_frame._u16_ntones != skModeParams[pctx->_txSched._u8_tx_mode]._u16_nsymbols)
+    {
+        return -1;                      /* Not created or created for another mode. */
+    }
+    pctx->_u8_frame_ready = NO;
+    pctx->_u8_frame_queued = NO;
 
-    // memcpy(pctx->_pTX->_pbyte_buffer, pctx->_pu8_outbuf, WSPR_SYMBOL_COUNT);
-    // pctx->_pTX->_ix_input = WSPR_SYMBOL_COUNT;
+#if TXCHANNEL_DMA_BACKEND
+    if(u64_start_us)
+    {
+        sleep_until(from_us_since_boot(u64_start_us));
+    }
 
-    memcpy(pctx->_pTX->_pbyte_buffer, pctx->_pu8_outbuf, FT8_SYMBOL_COUNT);
-    pctx->_pTX->_ix_input = FT8_SYMBOL_COUNT;
+    int ret;
+    STAGE_TIMED(STAGE_SEND_PACKET)
+    {
+        pctx->_pTX->_u32_dialfreqhz = pctx->_u32_frame_dialfreqhz;
+        ret = TxChannelDMASend(pctx->_pTXDMA, &pctx->_frame);
+    }
+    pctx->_u8_tx_mask = ret ? 0 : 1;
+    pctx->_u8_done_mask = 0;
 
-    return 0;
+    return ret;
+#else
+    const uint32_t u32_send_start = StageTimerNow();
+    for(int i = -1; i < pctx->_u8_naux; ++i)
+    {
+        TxChannelClear(i < 0 ? pctx->_pTX : pctx->_pTXaux[i]);
+    }
+    const int ret = WSPRbeaconQueuePacketAt(pctx, u64_start_us);
+    pctx->_u8_tx_mask = pctx->_u8_queued_mask;
+    pctx->_u8_done_mask = 0;
+    StageTimerAccount(STAGE_SEND_PACKET, u32_send_start);
+
+    return ret;
+#endif
 }
 
-/// @brief Arranges WSPR sending in accordance with pre-defined schedule.
-/// @brief It works only if GPS receiver available (for now).
-/// @param pctx Ptr to Context.
-/// @param verbose Whether stdio output is needed.
-/// @return 0 if OK, -1 if NO GPS received available
-int WSPRbeaconTxScheduler(WSPRbeaconContext *pctx, int verbose)
+/// @brief Queues a prepared packet after the frame being sent, so that it
+/// @brief starts at the given time with no work at the slot edge.
+/// @param pctx Context.
+/// @param u64_start_us Start of the first symbol, us since boot; 0 - right
+/// @param after the frame being sent.
+/// @return 0, if OK; -1 if a channel can't take it (the DMA backend never can).
+int WSPRbeaconQueuePacketAt(WSPRbeaconContext *pctx, uint64_t u64_start_us)
 {
     assert_(pctx);
 
-    const uint64_t u64tmnow = GetUptime64();
-    const uint32_t is_GPS_available = pctx->_pTX->_p_oscillator->_pGPStime->_time_data._u32_nmea_gprmc_count;
-    const uint32_t is_GPS_active = pctx->_pTX->_p_oscillator->_pGPStime->_time_data._u8_is_solution_active;
-    const uint32_t is_GPS_override = pctx->_txSched._u8_tx_GPS_past_time == YES;
+    if(pctx->_frame._u16_ntones != skModeParams[pctx->_txSched._u8_tx_mode]._u16_nsymbols)
+    {
+        return -1;
+    }
 
-    const uint64_t u64_GPS_last_age_sec
-        = (u64tmnow - pctx->_pTX->_p_oscillator->_pGPStime->_time_data._u64_sysclk_nmea_last) / 1000000ULL;
+#if TXCHANNEL_DMA_BACKEND
+    /* The whole frame is streamed at once, there is nothing to queue to. */
+    return -1;
+#else
+    /* Every channel holds the buffer until its last symbol is sent. */
+    volatile uint8_t *pu8_refs = pctx->_i8_frame_buf < 0 ? NULL
+                                 : &pctx->_pu8_packbuf_refs[pctx->_i8_frame_buf];
+    TxChannelFrame frame =
+    {
+        pctx->_frame, u64_start_us, pctx->_u32_frame_dialfreqhz,
+        pu8_refs ? WSPRbeaconReleaseBuffer : NULL, (void *)pu8_refs
+    };
+
+    int ret = 0;
+    uint8_t u8_mask = 0;
+    const int naux = min(pctx->_u8_naux, pctx->_txSched._u8_tx_naux_max);
+    for(int i = -1; i < naux; ++i)
+    {
+        TxChannelContext *pTX = i < 0 ? pctx->_pTX : pctx->_pTXaux[i];
+
+        /* Other channels may release the same buffer from their ISRs. */
+        uint32_t u32_irq = save_and_disable_interrupts();
+        if(pu8_refs)
+        {
+            ++*pu8_refs;
+        }
+        restore_interrupts(u32_irq);
+
+        if(TxChannelQueueFrame(pTX, &frame))
+        {
+            u32_irq = save_and_disable_interrupts();
+            if(pu8_refs)
+            {
+                --*pu8_refs;
+            }
+            restore_interrupts(u32_irq);
+            ret = -1;
+        }
+        else
+        {
+            u8_mask |= 1 << (i + 1);
+        }
+
+        /* Playlist bands retune the main channel only, aux. ones keep theirs. */
+        frame._u32_dialfreqhz = 0;
+    }
+    pctx->_u8_queued_mask = u8_mask;
 
-    if(!is_GPS_available)
+    return ret;
+#endif
+}
+
+/// @brief Gets a reference point which maps uptime to UTC.
+/// @brief The last PPS edge marks the second of the last NMEA time.
+/// @param pctx Context.
+/// @param pref Ptr to write the reference.
+/// @return 0 if OK, -1 if no GPS time is available.
+static int WSPRbeaconGetTimeRef(const WSPRbeaconContext *pctx, TxSlotTimeRef *pref)
+{
+    const GPStimeContext *pGPS = pctx->_pTX->_p_oscillator->_pGPStime;
+    if(!pGPS)
     {
-        if(verbose) StampPrintf("WSPR> Waiting for GPS receiver...");
         return -1;
     }
 
-    if(is_GPS_active || (pctx->_pTX->_p_oscillator->_pGPStime->_time_data._u32_utime_nmea_last &&
-                         is_GPS_override && u64_GPS_last_age_sec < WSPR_MAX_GPS_DISCONNECT_TM))
+    return TxSlotGetTimeRef(pGPS->_time_data._u32_utime_nmea_last,
+                            pGPS->_time_data._u64_sysclk_nmea_last,
+                            pGPS->_time_data._u64_sysclk_pps_last,
+                            pGPS->_time_data._i32_freq_shift_ppb, pref);
+}
+
+/// @brief Calculates the start of the next slot of current mode using GPS time.
+/// @param pctx Context.
+/// @return Start of the first symbol, us since boot (incl. tx offset),
+/// @return or 0 if no GPS time is available.
+uint64_t WSPRbeaconGetSlotStart(const WSPRbeaconContext *pctx)
+{
+    assert_(pctx);
+
+    TxSlotTimeRef ref;
+    if(WSPRbeaconGetTimeRef(pctx, &ref))
     {
-        const uint32_t u32_unixtime_now
-            = pctx->_pTX->_p_oscillator->_pGPStime->_time_data._u32_utime_nmea_last + u64_GPS_last_age_sec;
+        return 0;
+    }
+
+    /* The very next slot, whatever the schedule says. */
+    WSPRbeaconSchedule sched = pctx->_txSched;
+    sched._u8_tx_slot_parity = WSPR_SLOT_ANY;
+    sched._u8_tx_slot_skip = 0;
+
+    return TxSlotFindNext(&sched, skModeParams[pctx->_txSched._u8_tx_mode]._u32_slot_ms,
+                          &ref, GetUptime64(), TX_ARM_MIN_LEAD_US, NULL);
+}
+
+/// @brief Finds the next slot to transmit in, far enough to prepare a packet.
+/// @param pctx Context.
+/// @param pu64_slot Ptr to write slot index (can be NULL).
+/// @return Start of the first symbol, us since boot, or 0 if no GPS time.
+uint64_t WSPRbeaconGetNextTxSlot(const WSPRbeaconContext *pctx, uint64_t *pu64_slot)
+{
+    assert_(pctx);
+
+    TxSlotTimeRef ref;
+    if(WSPRbeaconGetTimeRef(pctx, &ref))
+    {
+        return 0;
+    }
+
+    return TxSlotFindNext(&pctx->_txSched, skModeParams[pctx->_txSched._u8_tx_mode]._u32_slot_ms,
+                          &ref, GetUptime64(), WSPR_PREPARE_LEAD_US, pu64_slot);
+}
+
+/// @brief Gets a count of symbols of the current packet not sent yet.
+/// @param pctx Context.
+/// @return A count of symbols, 0 when TX is over.
+uint32_t WSPRbeaconPending(const WSPRbeaconContext *pctx)
+{
+    assert_(pctx);
 
-        const int isec_of_hour = u32_unixtime_now % HOUR;
-        const int islot_number = isec_of_hour / (2 * MINUTE);
-        const int islot_modulo = islot_number % pctx->_txSched._u8_tx_slot_skip;
+#if TXCHANNEL_DMA_BACKEND
+    return TxChannelDMAPending(pctx->_pTXDMA);
+#else
+    uint32_t u32_pending = TxChannelPending(pctx->_pTX);
+    for(int i = 0; i < pctx->_u8_naux; ++i)
+    {
+        u32_pending = max(u32_pending, TxChannelPending(pctx->_pTXaux[i]));
+    }
+
+    return u32_pending;
+#endif
+}
+
+/// @brief Checks and consumes the end of frame events of every channel
+/// @brief the frame on air went to. Aux. channels may finish later than
+/// @brief the main one, e.g. their symbol ISR is delayed by the main one's.
+/// @param pctx Context.
+/// @return 1 if all of them have sent the last symbol (or nothing is on air).
+int WSPRbeaconFrameDone(WSPRbeaconContext *pctx)
+{
+    assert_(pctx);
 
-        static int itx_trigger = 0;
-        if(ZERO == islot_modulo)
+    for(int i = -1; i < pctx->_u8_naux; ++i)
+    {
+        const uint8_t u8_bit = 1 << (i + 1);
+        if((pctx->_u8_tx_mask & u8_bit)
+           && TxChannelFrameDone(i < 0 ? pctx->_pTX : pctx->_pTXaux[i]))
         {
-            if(!itx_trigger)
-            {
-                itx_trigger = 1;
-                if(verbose) StampPrintf("WSPR> Start TX.");
+            pctx->_u8_done_mask |= u8_bit;
+        }
+    }
+    if(pctx->_u8_done_mask != pctx->_u8_tx_mask)
+    {
+        return 0;
+    }
+    pctx->_u8_tx_mask = pctx->_u8_done_mask = 0;
+
+    return 1;
+}
+
+/// @brief One-shot alarm of the slot, fires WSPR_PREPARE_LEAD_US ahead of it.
+static int64_t WSPRbeaconSlotAlarm(alarm_id_t id, void *pdata)
+{
+    WSPRbeaconContext *pctx = (WSPRbeaconContext *)pdata;
+    pctx->_u8_slot_event = YES;
+    __sev();
+
+    return 0;
+}
+
+/// @brief Arms the one-shot alarm ahead of _u64_next_slot_us.
+/// @param pctx Context.
+/// @param verbose Whether stdio output is needed.
+static void WSPRbeaconArmSlotAlarm(WSPRbeaconContext *pctx, int verbose)
+{
+    pctx->_u8_slot_event = NO;
+    pctx->_slot_alarm = add_alarm_at(
+        from_us_since_boot(pctx->_u64_next_slot_us - WSPR_PREPARE_LEAD_US),
+        WSPRbeaconSlotAlarm, pctx, true);
+    pctx->_u8_sched_state = WSPR_SCHED_ARMED;
+    if(verbose) LOG_I("WSPR> Next TX slot %llu at %llu.",
+                      pctx->_u64_next_slot, pctx->_u64_next_slot_us);
+}
 
-                PioDCOStart(pctx->_pTX->_p_oscillator);
-                WSPRbeaconCreatePacket(pctx);
-                sleep_ms(100);
-                WSPRbeaconSendPacket(pctx);
+/// @brief Encodes the frame of the next TX slot while the current one is
+/// @brief on air. With the ISR backend it is queued to the channels too,
+/// @brief so it starts exactly at the slot without any CPU work then.
+/// @param pctx Context.
+static void WSPRbeaconPrepareNext(WSPRbeaconContext *pctx)
+{
+    uint64_t u64_slot;
+    const uint64_t u64_slot_us = WSPRbeaconGetNextTxSlot(pctx, &u64_slot);
+    if(!u64_slot_us)
+    {
+        return;
+    }
+
+    pctx->_u64_next_slot = u64_slot;
+    pctx->_u64_next_slot_us = u64_slot_us;
+    if(WSPRbeaconCreatePacket(pctx))
+    {
+        return;
+    }
+    pctx->_u8_frame_ready = YES;
+    pctx->_u8_frame_queued = !WSPRbeaconQueuePacketAt(pctx, u64_slot_us);
+}
+
+/// @brief Arranges FT8/FT4 sending in accordance with pre-defined schedule.
+/// @brief It is event driven: it arms a one-shot alarm ahead of the next
+/// @brief TX slot and does the work only when that alarm or TX end comes,
+/// @brief so calling it on every wake up of the main loop is cheap.
+/// @brief It works only if GPS receiver available (for now).
+/// @param pctx Ptr to Context.
+/// @param verbose Whether stdio output is needed (2 - incl. waiting for GPS).
+/// @return 1 if a packet has been armed, 0 if OK, -1 if NO GPS time available.
+int WSPRbeaconTxScheduler(WSPRbeaconContext *pctx, int verbose)
+{
+    assert_(pctx);
+
+    const GPStimeContext *pGPS = pctx->_pTX->_p_oscillator->_pGPStime;
+
+    switch(pctx->_u8_sched_state)
+    {
+        case WSPR_SCHED_TX:
+        if(!WSPRbeaconFrameDone(pctx))
+        {
+            return 0;
+        }
+        WSPRbeaconAccountTx(pctx);
+        if(verbose)
+        {
+            LOG_I("WSPR> TX done.");
+            TxChannelDumpJitter(pctx->_pTX);
+        }
+        PioDCOStop(pctx->_pTX->_p_oscillator);
+        if(pctx->_u8_frame_ready)
+        {
+            /* The next frame has been prepared while this one was on air. */
+            for(int i = -1; i < pctx->_u8_naux; ++i)
+            {
+                TxChannelResetJitter(i < 0 ? pctx->_pTX : pctx->_pTXaux[i]);
             }
+            WSPRbeaconArmSlotAlarm(pctx, verbose);
+            return 0;
+        }
+        pctx->_u8_sched_state = WSPR_SCHED_IDLE;
+        /* Fall through to arm the next slot. */
+
+        case WSPR_SCHED_IDLE:
+        {
+        const uint64_t u64tmnow = GetUptime64();
+        const uint32_t is_GPS_available = pGPS->_time_data._u32_nmea_gprmc_count;
+        const uint32_t is_GPS_active = pGPS->_time_data._u8_is_solution_active;
+        const uint32_t is_GPS_override = pctx->_txSched._u8_tx_GPS_past_time == YES;
+        const uint64_t u64_GPS_last_age_sec
+            = (u64tmnow - pGPS->_time_data._u64_sysclk_nmea_last) / 1000000ULL;
+
+        if(!is_GPS_available)
+        {
+            if(verbose > 1) LOG_D("WSPR> Waiting for GPS receiver...");
+            return -1;
+        }
+
+        if(!is_GPS_active && !(pGPS->_time_data._u32_utime_nmea_last && is_GPS_override
+                               && u64_GPS_last_age_sec < WSPR_MAX_GPS_DISCONNECT_TM))
+        {
+            return -1;
+        }
+
+        pctx->_u64_next_slot_us = WSPRbeaconGetNextTxSlot(pctx, &pctx->_u64_next_slot);
+        if(!pctx->_u64_next_slot_us)
+        {
+            return -1;
+        }
+
+        WSPRbeaconArmSlotAlarm(pctx, verbose);
+        }
+        return 0;
+
+        case WSPR_SCHED_ARMED:
+        if(!pctx->_u8_slot_event)
+        {
+            return 0;
+        }
+        pctx->_u8_slot_event = NO;
+
+        if(!pctx->_u8_frame_queued && GetUptime64() + TX_ARM_MIN_LEAD_US > pctx->_u64_next_slot_us)
+        {
+            /* The slot has been missed (e.g. manual TX was on air). */
+            MetricsAdd(METRIC_SLOTS_MISSED, 1);
+            pctx->_u8_frame_ready = NO;
+            pctx->_u8_sched_state = WSPR_SCHED_IDLE;
+            return 0;
+        }
+
+        if(!pctx->_u8_frame_ready && WSPRbeaconCreatePacket(pctx))
+        {
+            /* Nothing to send, e.g. no playlist message may go in this slot. */
+            if(verbose) BLOG_I(1, "WSPR> Skip slot %lu.", (uint32_t)pctx->_u64_next_slot);
+            pctx->_u8_sched_state = WSPR_SCHED_IDLE;
+            return 0;
+        }
+
+        if(verbose) BLOG_I(1, "WSPR> Start TX, slot %lu.", (uint32_t)pctx->_u64_next_slot);
+        PioDCOStart(pctx->_pTX->_p_oscillator);
+        if(pctx->_u8_frame_queued)
+        {
+            /* Armed in the channels already, it starts by itself. */
+            pctx->_u8_frame_ready = NO;
+            pctx->_u8_frame_queued = NO;
+            pctx->_u8_tx_mask = pctx->_u8_queued_mask;
+            pctx->_u8_done_mask = 0;
         }
         else
         {
-            itx_trigger = 0;
-            if(verbose) StampPrintf("WSPR> Passive TX slot.");
-            PioDCOStop(pctx->_pTX->_p_oscillator);
+            WSPRbeaconSendPacketAt(pctx, pctx->_u64_next_slot_us);
         }
+        pctx->_u8_sched_state = WSPR_SCHED_TX;
+        WSPRbeaconPrepareNext(pctx);
+        return 1;
+
+        default:
+        break;
     }
 
     return 0;
 }
 
+/// @brief Accounts a completed transmission in metrics.
+/// @param pctx Ptr to Context.
+void WSPRbeaconAccountTx(const WSPRbeaconContext *pctx)
+{
+    assert_(pctx);
+    assert_(pctx->_pTX);
+
+    TxJitterStats stats;
+    TxChannelGetJitter(pctx->_pTX, &stats);
+
+    MetricsAdd(METRIC_FRAMES_SENT, 1);
+    MetricsObserve(METRIC_JITTER_MAX_US, stats._u32_max_us);
+    MetricsAdd(METRIC_JITTER_MISSED, stats._u32_missed);
+    if(TX_START_ERROR_NA != pctx->_pTX->_i32_start_error_us)
+    {
+        MetricsSet(METRIC_START_ERROR_US, pctx->_pTX->_i32_start_error_us);
+    }
+}
+
+/// @brief Refreshes gauges of GPS, correction & ADC values before a snapshot.
+/// @param pctx Ptr to Context.
+void WSPRbeaconUpdateMetrics(const WSPRbeaconContext *pctx)
+{
+    assert_(pctx);
+    assert_(pctx->_pTX);
+
+    const GPStimeContext *pGPS = pctx->_pTX->_p_oscillator->_pGPStime;
+    if(pGPS)
+    {
+        MetricsSet(METRIC_GPS_ERRORS, pGPS->_i32_error_count);
+        MetricsSet(METRIC_GPS_FIX_AGE_S, pGPS->_time_data._u64_sysclk_nmea_last
+            ? (int32_t)((GetUptime64() - pGPS->_time_data._u64_sysclk_nmea_last) / 1000000ULL) : -1);
+        MetricsSet(METRIC_GPS_PPB, pGPS->_time_data._i32_freq_shift_ppb);
+    }
+    MetricsSet(METRIC_FALLBACK_PPB, pctx->_pTX->_u8_fallback_valid ? pctx->_pTX->_i32_fallback_ppb : 0);
+
+    if(pctx->_pADC && AdcSamplerIsValid(pctx->_pADC))
+    {
+        MetricsSet(METRIC_VSYS_MV, (int32_t)AdcSamplerGetVsysMv(pctx->_pADC));
+        MetricsSet(METRIC_TEMP_CENTI, AdcSamplerGetTempCenti(pctx->_pADC));
+    }
+}
+
 /// @brief Dumps the beacon context to stdio.
 /// @param pctx Ptr to Context.
 void WSPRbeaconDumpContext(const WSPRbeaconContext *pctx)
@@ -319,9 +980,15 @@ void WSPRbeaconDumpContext(const WSPRbeaconContext *pctx)
     StampPrintf("__________________");
     StampPrintf("=TxChannelContext=");
     StampPrintf("ftc:%llu", pctx->_pTX->_tm_future_call);
-    StampPrintf("ixi:%u", pctx->_pTX->_ix_input);
+    StampPrintf("pnd:%lu", TxChannelPending(pctx->_pTX));
     StampPrintf("dfq:%lu", pctx->_pTX->_u32_dialfreqhz);
     StampPrintf("gpo:%u", pctx->_pTX->_i_tx_gpio);
+    TxChannelDumpJitter(pctx->_pTX);
+    StampPrintf("ste:%ld", pctx->_pTX->_i32_start_error_us);
+    StampPrintf("sch:%u", pctx->_u8_sched_state);
+    StampPrintf("nxs:%llu", pctx->_u64_next_slot);
+    StampPrintf("nxt:%llu", pctx->_u64_next_slot_us);
+    StampPrintf("nxr:%u nxq:%u", pctx->_u8_frame_ready, pctx->_u8_frame_queued);
 
     GPStimeContext *pGPS = pctx->_pTX->_p_oscillator->_pGPStime;
     const uint32_t u32_unixtime_now
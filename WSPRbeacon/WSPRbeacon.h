@@ -55,17 +55,27 @@
 #include <stdint.h>
 #include <string.h>
 #include <TxChannel.h>
+#if TXCHANNEL_DMA_BACKEND
+#include <TxChannelDMA.h>
+#endif
+#include <AdcSampler.h>
+#include <Playlist.h>
 #include <logutils.h>
+#include "TxSlot.h"
 
-typedef struct
+enum
 {
-    uint8_t _u8_tx_slot_skip;           /* 0=1tx0skip, 1=1tx1skip, 2=1tx2skip, ... */
-    uint8_t _u8_tx_GPS_mandatory;       /* No tx when no active GPS solution. */
-    uint8_t _u8_tx_GPS_past_time;       /* Override _u8_tx_GPS_mandatory if there 
-                                           was solution in the past. */
-    uint8_t _u8_tx_heating_pause_min;   /* No tx during this interval from start. */
+    WSPR_SCHED_IDLE = 0,                /* Slot alarm isn't armed. */
+    WSPR_SCHED_ARMED,                   /* Waiting for slot alarm. */
+    WSPR_SCHED_TX                       /* Frame armed or on air. */
+};
 
-} WSPRbeaconSchedule;
+#define WSPR_PREPARE_LEAD_US 1000000ULL /* Packet preparation before slot. */
+
+#define WSPR_MAX_AUX_CHANNELS 2            /* Extra outputs, alarms 1 and 2. */
+#define WSPR_MAX_SYMBOLS      162          /* The longest frame, WSPR. */
+#define WSPR_TX_FIFO_SIZE     16           /* Frames are sent packed, not via FIFO. */
+#define WSPR_PACK_BUFFERS     2            /* One on air, one being prepared. */
 
 typedef struct
 {
@@ -73,9 +83,34 @@ typedef struct
     uint8_t _pu8_locator[7];
     uint8_t _u8_txpower;
 
-    uint8_t _pu8_outbuf[256];
+    uint8_t _pu8_packbuf[WSPR_PACK_BUFFERS][TONE_PACK_BYTES(WSPR_MAX_SYMBOLS, TONE_PACK_MAX_BITS)];
+    volatile uint8_t _pu8_packbuf_refs[WSPR_PACK_BUFFERS]; /* Channels holding a buffer. */
+    TonePackedFrame _frame;             /* Frame to send: in a pack buffer or tone bank. */
+    int8_t _i8_frame_buf;               /* Pack buffer of _frame, -1 - tone bank. */
+    uint8_t _u8_frame_ready;            /* _frame is for _u64_next_slot, not sent yet. */
+    uint8_t _u8_frame_queued;           /* ... and queued to the channels already. */
+    uint8_t _u8_queued_mask;            /* Channels the last queued frame went to. */
+    uint8_t _u8_tx_mask;                /* Channels of the frame on air, bit 0 - main. */
+    uint8_t _u8_done_mask;              /* ... which have sent it completely. */
+    uint32_t _u32_frame_dialfreqhz;     /* TX freq. of _frame incl. shift, Hz. */
+
+    PlaylistContext *_pPL;              /* Messages to send, NULL - the built-in one. */
+    uint32_t _u32_dialfreqhz;           /* TX freq. of playlist's default band. */
 
     TxChannelContext *_pTX;
+    TxChannelContext *_pTXaux[WSPR_MAX_AUX_CHANNELS];
+    uint8_t _u8_naux;                   /* Aux. channels in use. */
+#if TXCHANNEL_DMA_BACKEND
+    TxChannelDMAContext *_pTXDMA;
+#endif
+
+    volatile uint8_t _u8_slot_event;    /* Slot alarm has fired. */
+    uint8_t _u8_sched_state;            /* WSPR_SCHED_* */
+    alarm_id_t _slot_alarm;             /* One-shot alarm of the next slot. */
+    uint64_t _u64_next_slot;            /* Index of the next TX slot. */
+    uint64_t _u64_next_slot_us;         /* First symbol of the next TX slot. */
+
+    const AdcSamplerContext *_pADC;     /* VSYS for telemetry, may be NULL. */
 
     WSPRbeaconSchedule _txSched;
 
@@ -84,12 +119,25 @@ typedef struct
 WSPRbeaconContext *WSPRbeaconInit(const char *pcallsign, const char *pgridsquare, int txpow_dbm,
                                   PioDco *pdco, uint32_t dial_freq_hz, uint32_t shift_freq_hz,
                                   int gpio);
+int WSPRbeaconAddChannel(WSPRbeaconContext *pctx, PioDco *pdco, uint32_t dial_freq_hz,
+                         uint32_t shift_freq_hz, int gpio);
 void WSPRbeaconSetDialFreq(WSPRbeaconContext *pctx, uint32_t freq_hz);
+void WSPRbeaconSetMode(WSPRbeaconContext *pctx, uint8_t mode);
+void WSPRbeaconSetPlaylist(WSPRbeaconContext *pctx, PlaylistContext *pPL);
 int WSPRbeaconCreatePacket(WSPRbeaconContext *pctx);
-int WSPRbeaconSendPacket(const WSPRbeaconContext *pctx);
+int WSPRbeaconCreateManualPacket(WSPRbeaconContext *pctx);
+int WSPRbeaconSendPacket(WSPRbeaconContext *pctx);
+int WSPRbeaconSendPacketAt(WSPRbeaconContext *pctx, uint64_t u64_start_us);
+int WSPRbeaconQueuePacketAt(WSPRbeaconContext *pctx, uint64_t u64_start_us);
+uint64_t WSPRbeaconGetSlotStart(const WSPRbeaconContext *pctx);
+uint64_t WSPRbeaconGetNextTxSlot(const WSPRbeaconContext *pctx, uint64_t *pu64_slot);
+uint32_t WSPRbeaconPending(const WSPRbeaconContext *pctx);
+int WSPRbeaconFrameDone(WSPRbeaconContext *pctx);
 
 int WSPRbeaconTxScheduler(WSPRbeaconContext *pctx, int verbose);
 
+void WSPRbeaconAccountTx(const WSPRbeaconContext *pctx);
+void WSPRbeaconUpdateMetrics(const WSPRbeaconContext *pctx);
 void WSPRbeaconDumpContext(const WSPRbeaconContext *pctx);
 
 char *WSPRbeaconGetLastQTHLocator(const WSPRbeaconContext *pctx);
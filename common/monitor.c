@@ -1,7 +1,6 @@
 #include "monitor.h"
 #include <common/common.h>
 
-#define LOG_LEVEL LOG_INFO
 #include <ft8/debug.h>
 
 #include <stdlib.h>
@@ -56,6 +56,7 @@
 #include <piodco.h>
 #include <defines.h>
 #include <WSPRbeacon.h>
+#include "pico/flash.h"
 
 extern WSPRbeaconContext *pWSPR;
 
@@ -75,6 +76,19 @@ void Core1Entry()
     /* Set initial freq. */
     assert_(0 == PioDCOSetFreq(p, pWSPR->_pTX->_u32_dialfreqhz, 0U));
 
+    /* Let core0 pause this core while it writes flash. */
+    flash_safe_execute_core_init();
+
     /* Run the main DCO algorithm. It spins forever. */
     PioDCOWorker2(p);
 }
+
+/// @brief Relaunches the DCO worker after core1 has been reset for a low
+/// @brief power period. The DCO has been initialized by Core1Entry already.
+void Core1Resume()
+{
+    assert_(pWSPR);
+
+    flash_safe_execute_core_init();
+    PioDCOWorker2(pWSPR->_pTX->_p_oscillator);
+}
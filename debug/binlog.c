@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  binlog.c - Deferred binary logging ring.
+//
+//  DESCRIPTION
+//      Deferred binary log. A record of (timestamp, format string ptr, 4
+//      raw 32-bit args) is put into a RAM ring in a few dozen cycles, with
+//      no formatting at all. The ring is drained later, from the main loop
+//      while nothing is on air, as BLG> lines of hex which
+//      tools/binlog_decode.py turns back to text using the string table of
+//      the firmware ELF.
+//
+//  HOWTOSTART
+//      tools/binlog_decode.py build/pico-wspr-tx.elf minicom.log
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "binlog.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+static BinLogRecord sRing[BINLOG_RECORDS];
+static volatile uint32_t su32_ix_write = 0;     /* Free running. */
+static volatile uint32_t su32_ix_read = 0;      /* Free running. */
+static volatile uint32_t su32_dropped = 0;
+static spin_lock_t *spLock = NULL;
+
+/// @brief Claims the spin lock guarding the ring. Call it before the
+/// @brief first record is written, from core0.
+void BinLogInit(void)
+{
+    if(!spLock)
+    {
+        spLock = spin_lock_init(spin_lock_claim_unused(true));
+    }
+}
+
+/// @brief Puts a record into the ring. Never blocks, never formats.
+/// @brief Safe from ISRs and either core. Drops the record if the ring is full.
+/// @param pformat printf-like format, must be a string constant.
+/// @param a0..a3 Raw args.
+void __not_in_flash_func (BinLogWrite)(const char *pformat, uint32_t a0, uint32_t a1,
+                                       uint32_t a2, uint32_t a3)
+{
+    if(!spLock)
+    {
+        return;
+    }
+
+    const uint32_t u32_irq = spin_lock_blocking(spLock);
+
+    const uint32_t ix = su32_ix_write;
+    if(ix - su32_ix_read >= BINLOG_RECORDS)
+    {
+        ++su32_dropped;
+        spin_unlock(spLock, u32_irq);
+        return;
+    }
+
+    BinLogRecord *p = &sRing[ix & (BINLOG_RECORDS - 1)];
+    p->_u32_time_us = time_us_32();
+    p->_pformat = pformat;
+    p->_pu32_args[0] = a0;
+    p->_pu32_args[1] = a1;
+    p->_pu32_args[2] = a2;
+    p->_pu32_args[3] = a3;
+    su32_ix_write = ix + 1;
+
+    spin_unlock(spLock, u32_irq);
+}
+
+/// @brief Prints pending records as `BLG> ` hex lines: time, format ptr and
+/// @brief args, 8 hex digits each. Call it from a low priority context, e.g.
+/// @brief the main loop between transmissions.
+/// @param max Max. records to print, 0 - all.
+/// @return A count of records printed.
+int BinLogDrain(int max)
+{
+    if(su32_ix_read == su32_ix_write && !su32_dropped)
+    {
+        return 0;
+    }
+
+    /* Same as StampPrintf: the log goes to USB only. */
+    stdio_set_driver_enabled(&stdio_uart, false);
+
+    int n = 0;
+    while(su32_ix_read != su32_ix_write && (!max || n < max))
+    {
+        /* The only reader; a writer never touches a record below ix_write. */
+        const BinLogRecord *p = &sRing[su32_ix_read & (BINLOG_RECORDS - 1)];
+        printf("BLG> %08lx%08lx%08lx%08lx%08lx%08lx\n", p->_u32_time_us, (uint32_t)(uintptr_t)p->_pformat,
+               p->_pu32_args[0], p->_pu32_args[1], p->_pu32_args[2], p->_pu32_args[3]);
+        __dmb();
+        ++su32_ix_read;
+        ++n;
+    }
+
+    const uint32_t u32_irq = spin_lock_blocking(spLock);
+    const uint32_t u32_dropped = su32_dropped;
+    su32_dropped = 0;
+    spin_unlock(spLock, u32_irq);
+    if(u32_dropped)
+    {
+        printf("BLG> dropped:%lu\n", u32_dropped);
+    }
+
+    stdio_set_driver_enabled(&stdio_uart, true);
+
+    return n;
+}
+
+/// @brief Gets a count of records dropped since the last drain.
+/// @return A count of records.
+uint32_t BinLogDropped(void)
+{
+    return su32_dropped;
+}
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  binlog.h - Deferred binary logging ring.
+//
+//  DESCRIPTION
+//      Deferred binary log. A record of (timestamp, format string ptr, 4
+//      raw 32-bit args) is put into a RAM ring in a few dozen cycles, with
+//      no formatting at all. The ring is drained later, from the main loop
+//      while nothing is on air, as BLG> lines of hex which
+//      tools/binlog_decode.py turns back to text using the string table of
+//      the firmware ELF.
+//
+//  HOWTOSTART
+//      tools/binlog_decode.py build/pico-wspr-tx.elf minicom.log
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef BINLOG_H_
+#define BINLOG_H_
+
+#include <stdint.h>
+
+#define BINLOG_RECORDS          256         /* Ring capacity, power of two. */
+#define BINLOG_MAX_ARGS         4
+
+typedef struct
+{
+    uint32_t _u32_time_us;                  /* Low word of uptime. */
+    const char *_pformat;                   /* Lives in flash, resolved by host. */
+    uint32_t _pu32_args[BINLOG_MAX_ARGS];   /* Raw 32-bit args, no floats. */
+
+} BinLogRecord;
+
+/* Args are stored raw: 32-bit integers and pointers to string constants
+   only. %s isn't supported, use %c or a numeric code instead. */
+#define BINLOG0(f)              BinLogWrite((f), 0, 0, 0, 0)
+#define BINLOG1(f, a)           BinLogWrite((f), (uint32_t)(a), 0, 0, 0)
+#define BINLOG2(f, a, b)        BinLogWrite((f), (uint32_t)(a), (uint32_t)(b), 0, 0)
+#define BINLOG3(f, a, b, c)     BinLogWrite((f), (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), 0)
+#define BINLOG4(f, a, b, c, d)  BinLogWrite((f), (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d))
+
+void BinLogInit(void);
+void BinLogWrite(const char *pformat, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+int BinLogDrain(int max);
+uint32_t BinLogDropped(void);
+
+#endif
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  log.h - Unified per-module logging macros.
+//
+//  DESCRIPTION
+//      Compile-time log level filtering. Every module has its own threshold
+//      LOG_LEVEL_<MODULE> (set by CMake, see LOG_LEVEL* cache vars). Log
+//      calls below the threshold are constant-false branches: the call and
+//      its format string don't get into the image at all.
+//
+//  HOWTOSTART
+//      #define LOG_MODULE BEACON before including it, then LOG_I(...)
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef LOG_H_
+#define LOG_H_
+
+#include "logutils.h"
+#include "binlog.h"
+
+/* Severity, ascending. The same values as ft8_lib's debug.h. */
+#define LOG_DEBUG   0
+#define LOG_INFO    1
+#define LOG_WARN    2
+#define LOG_ERROR   3
+#define LOG_FATAL   4
+#define LOG_NONE    5
+
+#ifndef LOG_LEVEL_FT8
+#define LOG_LEVEL_FT8       LOG_NONE
+#endif
+#ifndef LOG_LEVEL_TXCHANNEL
+#define LOG_LEVEL_TXCHANNEL LOG_INFO
+#endif
+#ifndef LOG_LEVEL_BEACON
+#define LOG_LEVEL_BEACON    LOG_INFO
+#endif
+#ifndef LOG_LEVEL_POWER
+#define LOG_LEVEL_POWER     LOG_INFO
+#endif
+#ifndef LOG_LEVEL_MAIN
+#define LOG_LEVEL_MAIN      LOG_INFO
+#endif
+
+#define LOG_ENABLED_(module, level) ((level) >= LOG_LEVEL_##module)
+#define LOG_ENABLED__(module, level) LOG_ENABLED_(module, level)
+#define LOG_ENABLED(level) LOG_ENABLED__(LOG_MODULE, level)
+
+/* Text log: timestamped line by StampPrintf. */
+#define LOG_AT(level, ...) \
+    do { if(LOG_ENABLED(level)) StampPrintf(__VA_ARGS__); } while(0)
+
+#define LOG_D(...) LOG_AT(LOG_DEBUG, __VA_ARGS__)
+#define LOG_I(...) LOG_AT(LOG_INFO, __VA_ARGS__)
+#define LOG_W(...) LOG_AT(LOG_WARN, __VA_ARGS__)
+#define LOG_E(...) LOG_AT(LOG_ERROR, __VA_ARGS__)
+
+/* Deferred binary log, n is a count of args, see binlog.h. */
+#define BLOG_AT(level, n, ...) \
+    do { if(LOG_ENABLED(level)) BINLOG##n(__VA_ARGS__); } while(0)
+
+#define BLOG_D(n, ...) BLOG_AT(LOG_DEBUG, n, __VA_ARGS__)
+#define BLOG_I(n, ...) BLOG_AT(LOG_INFO, n, __VA_ARGS__)
+#define BLOG_W(n, ...) BLOG_AT(LOG_WARN, n, __VA_ARGS__)
+#define BLOG_E(n, ...) BLOG_AT(LOG_ERROR, n, __VA_ARGS__)
+
+#endif
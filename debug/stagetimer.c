@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  stagetimer.c - Scoped timers of packet preparation stages.
+//
+//  DESCRIPTION
+//      Min/max/last duration of every stage of packet preparation,
+//      accounted by STAGE_TIMED() probes. On target the clock is the 1 MHz
+//      system timer, in the host build (STAGE_TIMER_HOST) it's
+//      CLOCK_MONOTONIC in ns, so the same probes run in
+//      tools/encode_bench.c for comparison.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "stagetimer.h"
+#include <string.h>
+
+static const char *skStageNames[STAGE_COUNT] =
+{
+    [STAGE_CREATE_PACKET]   = "create_packet",
+    [STAGE_VSYS_READ]       = "vsys_read",
+    [STAGE_MESSAGE_FORMAT]  = "message_format",
+    [STAGE_MESSAGE_ENCODE]  = "message_encode",
+    [STAGE_TONE_ENCODE]     = "tone_encode",
+    [STAGE_SEND_PACKET]     = "send_packet",
+};
+
+/* Accounted by the main loop only, like the metrics reading them. */
+static StageTimerStats sStages[STAGE_COUNT];
+
+/// @brief Accounts a stage which started at the given time and ends now.
+/// @param id Stage.
+/// @param u32_start StageTimerNow() at the start of the stage.
+void StageTimerAccount(StageId id, uint32_t u32_start)
+{
+    const uint32_t u32_dt = StageTimerNow() - u32_start;
+
+    StageTimerStats *p = &sStages[id];
+    if(!p->_u32_count || u32_dt < p->_u32_min)
+    {
+        p->_u32_min = u32_dt;
+    }
+    if(u32_dt > p->_u32_max)
+    {
+        p->_u32_max = u32_dt;
+    }
+    p->_u32_last = u32_dt;
+    ++p->_u32_count;
+}
+
+/// @brief Gets stats of a stage.
+/// @param id Stage.
+/// @return Ptr to stats.
+const StageTimerStats *StageTimerGet(StageId id)
+{
+    return &sStages[id];
+}
+
+/// @brief Gets a name of a stage.
+/// @param id Stage.
+/// @return The name.
+const char *StageTimerName(StageId id)
+{
+    return id < STAGE_COUNT ? skStageNames[id] : "?";
+}
+
+/// @brief Resets stats of all stages.
+void StageTimerReset(void)
+{
+    memset(sStages, 0, sizeof(sStages));
+}
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  stagetimer.h - Scoped timers of packet preparation stages.
+//
+//  DESCRIPTION
+//      Min/max/last duration of every stage of packet preparation,
+//      accounted by STAGE_TIMED() probes. On target the clock is the 1 MHz
+//      system timer, in the host build (STAGE_TIMER_HOST) it's
+//      CLOCK_MONOTONIC in ns, so the same probes run in
+//      tools/encode_bench.c for comparison.
+//
+//  HOWTOSTART
+//      -
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+//      -
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef STAGETIMER_H_
+#define STAGETIMER_H_
+
+#include <stdint.h>
+
+#ifdef STAGE_TIMER_HOST
+#include <time.h>
+#define STAGE_TIMER_UNIT        "ns"
+#else
+#include "hardware/timer.h"
+#define STAGE_TIMER_UNIT        "us"
+#endif
+
+typedef enum
+{
+    STAGE_CREATE_PACKET = 0,                /* The whole WSPRbeaconCreatePacket. */
+    STAGE_VSYS_READ,
+    STAGE_MESSAGE_FORMAT,                   /* Battery level & message text. */
+    STAGE_MESSAGE_ENCODE,                   /* ftx_message_encode & fallback. */
+    STAGE_TONE_ENCODE,                      /* ft8_encode / ft4_encode. */
+    STAGE_SEND_PACKET,                      /* Frame handed over to TxChannel. */
+
+    STAGE_COUNT
+
+} StageId;
+
+typedef struct
+{
+    uint32_t _u32_count;
+    uint32_t _u32_last;
+    uint32_t _u32_min;
+    uint32_t _u32_max;
+
+} StageTimerStats;
+
+/// @brief Reads the stage clock, STAGE_TIMER_UNIT ticks; wraps.
+static inline uint32_t StageTimerNow(void)
+{
+#ifdef STAGE_TIMER_HOST
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#else
+    return time_us_32();
+#endif
+}
+
+void StageTimerAccount(StageId id, uint32_t u32_start);
+const StageTimerStats *StageTimerGet(StageId id);
+const char *StageTimerName(StageId id);
+void StageTimerReset(void);
+
+/* Times the statement or block which follows, e.g.
+       STAGE_TIMED(STAGE_TONE_ENCODE) ft8_encode(payload, tones);
+   Leaving the block by break, return or goto skips the accounting. */
+#define STAGE_TIMED(id) \
+    for(uint32_t _u32_stage_start = StageTimerNow(), _u32_stage_once = 1; _u32_stage_once; \
+        _u32_stage_once = 0, StageTimerAccount((id), _u32_stage_start))
+
+#endif
@@ -52,8 +52,7 @@
 #ifndef DEFINESWSPR_H
 #define DEFINESWSPR_H
 
-#define DEBUG
-
+/* DEBUG is defined by CMake, see WSPR_DEBUG option. */
 #ifdef DEBUG
 #define DEBUGPRINTF(x) StampPrintf(x);
 #else
@@ -102,6 +101,10 @@
 // FT8 tones are separated by 6.25 Hz
 #define WSPR_FREQ_STEP_MILHZ    12542UL         /* FSK freq.bin (*2 this time) - for FT8 */
 
+// FT4 tones are separated by 20.833 Hz
+// (2930 / 1.46) * 20.8333 => 41809.4
+#define FT4_FREQ_STEP_MILHZ     41809UL         /* FSK freq.bin (*2 this time) - for FT4 */
+
 #define WSPR_MAX_GPS_DISCONNECT_TM  \
         (6 * HOUR)                      /* How long is active without GPS. */
 
@@ -1,22 +1,19 @@
 #ifndef _DEBUG_H_INCLUDED_
 #define _DEBUG_H_INCLUDED_
 
-#define LOG_DEBUG 0
-#define LOG_INFO  1
-#define LOG_WARN  2
-#define LOG_ERROR 3
-#define LOG_FATAL 4
+/* Levels and the FT8 module threshold come from the common layer. */
+#include "debug/log.h"
 
-#ifdef LOG_LEVEL
+/* On the Pico stderr goes to the same stdio drivers (USB CDC) as stdout,
+   so ft8 text would interleave with the binary metrics frames. What keeps
+   them apart is LOG_LEVEL_FT8 defaulting to NONE; raise it for bench
+   debugging only. stderr is kept as upstream ft8_lib has it. */
 #ifndef LOG_PRINTF
 #include <stdio.h>
 #define LOG_PRINTF(...) fprintf(stderr, __VA_ARGS__)
 #endif
-#define LOG(level, ...)     \
-    if (level >= LOG_LEVEL) \
-    LOG_PRINTF(__VA_ARGS__)
-#else // ifdef LOG_LEVEL
-#define LOG(level, ...)
-#endif
 
-#endif // _DEBUG_H_INCLUDED_
\ No newline at end of file
+#define LOG(level, ...) \
+    do { if ((level) >= LOG_LEVEL_FT8) LOG_PRINTF(__VA_ARGS__); } while (0)
+
+#endif // _DEBUG_H_INCLUDED_
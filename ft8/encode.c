@@ -19,7 +19,7 @@ static uint8_t parity8(uint8_t x)
 // Arguments:
 // [IN] message   - array of 91 bits stored as 12 bytes (MSB first)
 // [OUT] codeword - array of 174 bits stored as 22 bytes (MSB first)
-static void encode174(const uint8_t* message, uint8_t* codeword)
+void ftx_encode174(const uint8_t* message, uint8_t* codeword)
 {
     // This implementation accesses the generator bits straight from the packed binary representation in kFTX_LDPC_generator
 
@@ -71,8 +71,13 @@ void ft8_encode(const uint8_t* payload, uint8_t* tones)
     ftx_add_crc(payload, a91);
 
     uint8_t codeword[FTX_LDPC_N_BYTES];
-    encode174(a91, codeword);
+    ftx_encode174(a91, codeword);
 
+    ft8_codeword_to_tones(codeword, tones);
+}
+
+void ft8_codeword_to_tones(const uint8_t* codeword, uint8_t* tones)
+{
     // Message structure: S7 D29 S7 D29 S7
     // Total symbols: 79 (FT8_NN)
 
@@ -141,8 +146,13 @@ void ft4_encode(const uint8_t* payload, uint8_t* tones)
     ftx_add_crc(payload_xor, a91);
 
     uint8_t codeword[FTX_LDPC_N_BYTES];
-    encode174(a91, codeword); // 91 bits -> 174 bits
+    ftx_encode174(a91, codeword); // 91 bits -> 174 bits
 
+    ft4_codeword_to_tones(codeword, tones);
+}
+
+void ft4_codeword_to_tones(const uint8_t* codeword, uint8_t* tones)
+{
     // Message structure: R S4_1 D29 S4_2 D29 S4_3 D29 S4_4 R
     // Total symbols: 105 (FT4_NN)
 
@@ -34,6 +34,21 @@ void ft8_encode(const uint8_t* payload, uint8_t* tones);
 /// @param[out] tones  - array of FT4_NN (105) bytes to store the generated tones (encoded as 0..3)
 void ft4_encode(const uint8_t* payload, uint8_t* tones);
 
+/// Encode via LDPC a 91-bit message (payload + CRC) into a 174-bit codeword
+/// @param[in] message   - 12 byte array of 91 bits (MSB first)
+/// @param[out] codeword - 22 byte array of 174 bits (MSB first)
+void ftx_encode174(const uint8_t* message, uint8_t* codeword);
+
+/// Map a 174-bit codeword to FT8 tones, adding Costas sync symbols
+/// @param[in] codeword - 22 byte array of 174 bits (MSB first)
+/// @param[out] tones   - array of FT8_NN (79) bytes (encoded as 0..7)
+void ft8_codeword_to_tones(const uint8_t* codeword, uint8_t* tones);
+
+/// Map a 174-bit codeword to FT4 tones, adding sync and ramp symbols
+/// @param[in] codeword - 22 byte array of 174 bits (MSB first)
+/// @param[out] tones   - array of FT4_NN (105) bytes (encoded as 0..3)
+void ft4_codeword_to_tones(const uint8_t* codeword, uint8_t* tones);
+
 #ifdef __cplusplus
 }
 #endif
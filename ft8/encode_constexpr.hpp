@@ -0,0 +1,552 @@
+#ifndef _INCLUDE_ENCODE_CONSTEXPR_HPP_
+#define _INCLUDE_ENCODE_CONSTEXPR_HPP_
+
+// Header-only constexpr FT8/FT4 encoder (C++17).
+//
+//     constexpr auto tones = ft8::encode("CQ K1TE FN42"); // std::array<uint8_t, 79>
+//
+// Packs Type 1/2 standard messages (two callsigns, standard or hashed, with
+// optional /R or /P, and a grid, report, RRR, RR73 or 73) the same way as
+// ftx_message_encode_std() of message.c, then CRC-14, LDPC (174,91) and the
+// Gray/Costas mapping of encode.c. Used in a constant expression, a message
+// this packer rejects is a compile error; nothing is left to run on target.
+//
+// It is stricter than message.c, which packs any third token that isn't a
+// grid as a report (e.g. "FN4" as +00): here it must be a 4-character grid,
+// RRR, RR73, 73 or [R]+dd/[R]-dd in -30..+99. Whatever it accepts encodes
+// to the same tones as message.c + encode.c, see tools/constexpr_check.cpp.
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace ft8
+{
+
+using payload_t = std::array<uint8_t, 10>;       ///< 77 bits, MSB first
+using tones_t = std::array<uint8_t, 79>;         ///< FT8_NN tones 0..7
+using tones_ft4_t = std::array<uint8_t, 105>;    ///< FT4_NN tones 0..3
+
+namespace detail
+{
+
+constexpr uint32_t kNTokens = 2063592ul;
+constexpr uint32_t kMax22 = 4194304ul;
+constexpr uint16_t kMaxGrid4 = 32400u;
+constexpr uint16_t kCrcPolynomial = 0x2757u;
+constexpr int kCrcWidth = 14;
+
+constexpr uint8_t kFT8_Costas_pattern[7] = { 3, 1, 4, 0, 6, 5, 2 };
+constexpr uint8_t kFT4_Costas_pattern[4][4] = { { 0, 1, 3, 2 }, { 1, 0, 2, 3 }, { 2, 3, 1, 0 }, { 3, 2, 0, 1 } };
+constexpr uint8_t kFT8_Gray_map[8] = { 0, 1, 3, 2, 5, 6, 4, 7 };
+constexpr uint8_t kFT4_Gray_map[4] = { 0, 1, 3, 2 };
+constexpr uint8_t kFT4_XOR_sequence[10] = { 0x4A, 0x5E, 0x89, 0xB4, 0xB0, 0x8A, 0x79, 0x55, 0xBE, 0x28 };
+
+// Same as kFTX_LDPC_generator of constants.c
+constexpr uint8_t kLDPC_generator[83][12] = {
+    { 0x83, 0x29, 0xce, 0x11, 0xbf, 0x31, 0xea, 0xf5, 0x09, 0xf2, 0x7f, 0xc0 },
+    { 0x76, 0x1c, 0x26, 0x4e, 0x25, 0xc2, 0x59, 0x33, 0x54, 0x93, 0x13, 0x20 },
+    { 0xdc, 0x26, 0x59, 0x02, 0xfb, 0x27, 0x7c, 0x64, 0x10, 0xa1, 0xbd, 0xc0 },
+    { 0x1b, 0x3f, 0x41, 0x78, 0x58, 0xcd, 0x2d, 0xd3, 0x3e, 0xc7, 0xf6, 0x20 },
+    { 0x09, 0xfd, 0xa4, 0xfe, 0xe0, 0x41, 0x95, 0xfd, 0x03, 0x47, 0x83, 0xa0 },
+    { 0x07, 0x7c, 0xcc, 0xc1, 0x1b, 0x88, 0x73, 0xed, 0x5c, 0x3d, 0x48, 0xa0 },
+    { 0x29, 0xb6, 0x2a, 0xfe, 0x3c, 0xa0, 0x36, 0xf4, 0xfe, 0x1a, 0x9d, 0xa0 },
+    { 0x60, 0x54, 0xfa, 0xf5, 0xf3, 0x5d, 0x96, 0xd3, 0xb0, 0xc8, 0xc3, 0xe0 },
+    { 0xe2, 0x07, 0x98, 0xe4, 0x31, 0x0e, 0xed, 0x27, 0x88, 0x4a, 0xe9, 0x00 },
+    { 0x77, 0x5c, 0x9c, 0x08, 0xe8, 0x0e, 0x26, 0xdd, 0xae, 0x56, 0x31, 0x80 },
+    { 0xb0, 0xb8, 0x11, 0x02, 0x8c, 0x2b, 0xf9, 0x97, 0x21, 0x34, 0x87, 0xc0 },
+    { 0x18, 0xa0, 0xc9, 0x23, 0x1f, 0xc6, 0x0a, 0xdf, 0x5c, 0x5e, 0xa3, 0x20 },
+    { 0x76, 0x47, 0x1e, 0x83, 0x02, 0xa0, 0x72, 0x1e, 0x01, 0xb1, 0x2b, 0x80 },
+    { 0xff, 0xbc, 0xcb, 0x80, 0xca, 0x83, 0x41, 0xfa, 0xfb, 0x47, 0xb2, 0xe0 },
+    { 0x66, 0xa7, 0x2a, 0x15, 0x8f, 0x93, 0x25, 0xa2, 0xbf, 0x67, 0x17, 0x00 },
+    { 0xc4, 0x24, 0x36, 0x89, 0xfe, 0x85, 0xb1, 0xc5, 0x13, 0x63, 0xa1, 0x80 },
+    { 0x0d, 0xff, 0x73, 0x94, 0x14, 0xd1, 0xa1, 0xb3, 0x4b, 0x1c, 0x27, 0x00 },
+    { 0x15, 0xb4, 0x88, 0x30, 0x63, 0x6c, 0x8b, 0x99, 0x89, 0x49, 0x72, 0xe0 },
+    { 0x29, 0xa8, 0x9c, 0x0d, 0x3d, 0xe8, 0x1d, 0x66, 0x54, 0x89, 0xb0, 0xe0 },
+    { 0x4f, 0x12, 0x6f, 0x37, 0xfa, 0x51, 0xcb, 0xe6, 0x1b, 0xd6, 0xb9, 0x40 },
+    { 0x99, 0xc4, 0x72, 0x39, 0xd0, 0xd9, 0x7d, 0x3c, 0x84, 0xe0, 0x94, 0x00 },
+    { 0x19, 0x19, 0xb7, 0x51, 0x19, 0x76, 0x56, 0x21, 0xbb, 0x4f, 0x1e, 0x80 },
+    { 0x09, 0xdb, 0x12, 0xd7, 0x31, 0xfa, 0xee, 0x0b, 0x86, 0xdf, 0x6b, 0x80 },
+    { 0x48, 0x8f, 0xc3, 0x3d, 0xf4, 0x3f, 0xbd, 0xee, 0xa4, 0xea, 0xfb, 0x40 },
+    { 0x82, 0x74, 0x23, 0xee, 0x40, 0xb6, 0x75, 0xf7, 0x56, 0xeb, 0x5f, 0xe0 },
+    { 0xab, 0xe1, 0x97, 0xc4, 0x84, 0xcb, 0x74, 0x75, 0x71, 0x44, 0xa9, 0xa0 },
+    { 0x2b, 0x50, 0x0e, 0x4b, 0xc0, 0xec, 0x5a, 0x6d, 0x2b, 0xdb, 0xdd, 0x00 },
+    { 0xc4, 0x74, 0xaa, 0x53, 0xd7, 0x02, 0x18, 0x76, 0x16, 0x69, 0x36, 0x00 },
+    { 0x8e, 0xba, 0x1a, 0x13, 0xdb, 0x33, 0x90, 0xbd, 0x67, 0x18, 0xce, 0xc0 },
+    { 0x75, 0x38, 0x44, 0x67, 0x3a, 0x27, 0x78, 0x2c, 0xc4, 0x20, 0x12, 0xe0 },
+    { 0x06, 0xff, 0x83, 0xa1, 0x45, 0xc3, 0x70, 0x35, 0xa5, 0xc1, 0x26, 0x80 },
+    { 0x3b, 0x37, 0x41, 0x78, 0x58, 0xcc, 0x2d, 0xd3, 0x3e, 0xc3, 0xf6, 0x20 },
+    { 0x9a, 0x4a, 0x5a, 0x28, 0xee, 0x17, 0xca, 0x9c, 0x32, 0x48, 0x42, 0xc0 },
+    { 0xbc, 0x29, 0xf4, 0x65, 0x30, 0x9c, 0x97, 0x7e, 0x89, 0x61, 0x0a, 0x40 },
+    { 0x26, 0x63, 0xae, 0x6d, 0xdf, 0x8b, 0x5c, 0xe2, 0xbb, 0x29, 0x48, 0x80 },
+    { 0x46, 0xf2, 0x31, 0xef, 0xe4, 0x57, 0x03, 0x4c, 0x18, 0x14, 0x41, 0x80 },
+    { 0x3f, 0xb2, 0xce, 0x85, 0xab, 0xe9, 0xb0, 0xc7, 0x2e, 0x06, 0xfb, 0xe0 },
+    { 0xde, 0x87, 0x48, 0x1f, 0x28, 0x2c, 0x15, 0x39, 0x71, 0xa0, 0xa2, 0xe0 },
+    { 0xfc, 0xd7, 0xcc, 0xf2, 0x3c, 0x69, 0xfa, 0x99, 0xbb, 0xa1, 0x41, 0x20 },
+    { 0xf0, 0x26, 0x14, 0x47, 0xe9, 0x49, 0x0c, 0xa8, 0xe4, 0x74, 0xce, 0xc0 },
+    { 0x44, 0x10, 0x11, 0x58, 0x18, 0x19, 0x6f, 0x95, 0xcd, 0xd7, 0x01, 0x20 },
+    { 0x08, 0x8f, 0xc3, 0x1d, 0xf4, 0xbf, 0xbd, 0xe2, 0xa4, 0xea, 0xfb, 0x40 },
+    { 0xb8, 0xfe, 0xf1, 0xb6, 0x30, 0x77, 0x29, 0xfb, 0x0a, 0x07, 0x8c, 0x00 },
+    { 0x5a, 0xfe, 0xa7, 0xac, 0xcc, 0xb7, 0x7b, 0xbc, 0x9d, 0x99, 0xa9, 0x00 },
+    { 0x49, 0xa7, 0x01, 0x6a, 0xc6, 0x53, 0xf6, 0x5e, 0xcd, 0xc9, 0x07, 0x60 },
+    { 0x19, 0x44, 0xd0, 0x85, 0xbe, 0x4e, 0x7d, 0xa8, 0xd6, 0xcc, 0x7d, 0x00 },
+    { 0x25, 0x1f, 0x62, 0xad, 0xc4, 0x03, 0x2f, 0x0e, 0xe7, 0x14, 0x00, 0x20 },
+    { 0x56, 0x47, 0x1f, 0x87, 0x02, 0xa0, 0x72, 0x1e, 0x00, 0xb1, 0x2b, 0x80 },
+    { 0x2b, 0x8e, 0x49, 0x23, 0xf2, 0xdd, 0x51, 0xe2, 0xd5, 0x37, 0xfa, 0x00 },
+    { 0x6b, 0x55, 0x0a, 0x40, 0xa6, 0x6f, 0x47, 0x55, 0xde, 0x95, 0xc2, 0x60 },
+    { 0xa1, 0x8a, 0xd2, 0x8d, 0x4e, 0x27, 0xfe, 0x92, 0xa4, 0xf6, 0xc8, 0x40 },
+    { 0x10, 0xc2, 0xe5, 0x86, 0x38, 0x8c, 0xb8, 0x2a, 0x3d, 0x80, 0x75, 0x80 },
+    { 0xef, 0x34, 0xa4, 0x18, 0x17, 0xee, 0x02, 0x13, 0x3d, 0xb2, 0xeb, 0x00 },
+    { 0x7e, 0x9c, 0x0c, 0x54, 0x32, 0x5a, 0x9c, 0x15, 0x83, 0x6e, 0x00, 0x00 },
+    { 0x36, 0x93, 0xe5, 0x72, 0xd1, 0xfd, 0xe4, 0xcd, 0xf0, 0x79, 0xe8, 0x60 },
+    { 0xbf, 0xb2, 0xce, 0xc5, 0xab, 0xe1, 0xb0, 0xc7, 0x2e, 0x07, 0xfb, 0xe0 },
+    { 0x7e, 0xe1, 0x82, 0x30, 0xc5, 0x83, 0xcc, 0xcc, 0x57, 0xd4, 0xb0, 0x80 },
+    { 0xa0, 0x66, 0xcb, 0x2f, 0xed, 0xaf, 0xc9, 0xf5, 0x26, 0x64, 0x12, 0x60 },
+    { 0xbb, 0x23, 0x72, 0x5a, 0xbc, 0x47, 0xcc, 0x5f, 0x4c, 0xc4, 0xcd, 0x20 },
+    { 0xde, 0xd9, 0xdb, 0xa3, 0xbe, 0xe4, 0x0c, 0x59, 0xb5, 0x60, 0x9b, 0x40 },
+    { 0xd9, 0xa7, 0x01, 0x6a, 0xc6, 0x53, 0xe6, 0xde, 0xcd, 0xc9, 0x03, 0x60 },
+    { 0x9a, 0xd4, 0x6a, 0xed, 0x5f, 0x70, 0x7f, 0x28, 0x0a, 0xb5, 0xfc, 0x40 },
+    { 0xe5, 0x92, 0x1c, 0x77, 0x82, 0x25, 0x87, 0x31, 0x6d, 0x7d, 0x3c, 0x20 },
+    { 0x4f, 0x14, 0xda, 0x82, 0x42, 0xa8, 0xb8, 0x6d, 0xca, 0x73, 0x35, 0x20 },
+    { 0x8b, 0x8b, 0x50, 0x7a, 0xd4, 0x67, 0xd4, 0x44, 0x1d, 0xf7, 0x70, 0xe0 },
+    { 0x22, 0x83, 0x1c, 0x9c, 0xf1, 0x16, 0x94, 0x67, 0xad, 0x04, 0xb6, 0x80 },
+    { 0x21, 0x3b, 0x83, 0x8f, 0xe2, 0xae, 0x54, 0xc3, 0x8e, 0xe7, 0x18, 0x00 },
+    { 0x5d, 0x92, 0x6b, 0x6d, 0xd7, 0x1f, 0x08, 0x51, 0x81, 0xa4, 0xe1, 0x20 },
+    { 0x66, 0xab, 0x79, 0xd4, 0xb2, 0x9e, 0xe6, 0xe6, 0x95, 0x09, 0xe5, 0x60 },
+    { 0x95, 0x81, 0x48, 0x68, 0x2d, 0x74, 0x8a, 0x38, 0xdd, 0x68, 0xba, 0xa0 },
+    { 0xb8, 0xce, 0x02, 0x0c, 0xf0, 0x69, 0xc3, 0x2a, 0x72, 0x3a, 0xb1, 0x40 },
+    { 0xf4, 0x33, 0x1d, 0x6d, 0x46, 0x16, 0x07, 0xe9, 0x57, 0x52, 0x74, 0x60 },
+    { 0x6d, 0xa2, 0x3b, 0xa4, 0x24, 0xb9, 0x59, 0x61, 0x33, 0xcf, 0x9c, 0x80 },
+    { 0xa6, 0x36, 0xbc, 0xbc, 0x7b, 0x30, 0xc5, 0xfb, 0xea, 0xe6, 0x7f, 0xe0 },
+    { 0x5c, 0xb0, 0xd8, 0x6a, 0x07, 0xdf, 0x65, 0x4a, 0x90, 0x89, 0xa2, 0x00 },
+    { 0xf1, 0x1f, 0x10, 0x68, 0x48, 0x78, 0x0f, 0xc9, 0xec, 0xdd, 0x80, 0xa0 },
+    { 0x1f, 0xbb, 0x53, 0x64, 0xfb, 0x8d, 0x2c, 0x9d, 0x73, 0x0d, 0x5b, 0xa0 },
+    { 0xfc, 0xb8, 0x6b, 0xc7, 0x0a, 0x50, 0xc9, 0xd0, 0x2a, 0x5d, 0x03, 0x40 },
+    { 0xa5, 0x34, 0x43, 0x30, 0x29, 0xea, 0xc1, 0x5f, 0x32, 0x2e, 0x34, 0xc0 },
+    { 0xc9, 0x89, 0xd9, 0xc7, 0xc3, 0xd3, 0xb8, 0xc5, 0x5d, 0x75, 0x13, 0x00 },
+    { 0x7b, 0xb3, 0x8b, 0x2f, 0x01, 0x86, 0xd4, 0x66, 0x43, 0xae, 0x96, 0x20 },
+    { 0x26, 0x44, 0xeb, 0xad, 0xeb, 0x44, 0xb9, 0x46, 0x7d, 0x1f, 0x42, 0xc0 },
+    { 0x60, 0x8c, 0xc8, 0x57, 0x59, 0x4b, 0xfb, 0xb5, 0x5d, 0x69, 0x60, 0x00 },
+};
+
+// Not constexpr: reaching it in a constant expression is a compile error
+// naming the reason. At run time the message is encoded as all zeros.
+inline void invalid_message(const char* /* reason */) {}
+
+enum class char_table
+{
+    alphanum_space_slash, // " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ/"
+    alphanum_space,       // " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    letters_space,        // " ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    alphanum,             // "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    numeric               // "0123456789"
+};
+
+constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+constexpr bool is_letter(char c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); }
+constexpr bool in_range(char c, char min, char max) { return c >= min && c <= max; }
+
+constexpr bool ends_with(std::string_view s, std::string_view suffix)
+{
+    return s.size() >= suffix.size() && s.substr(s.size() - suffix.size()) == suffix;
+}
+
+// nchar() of text.c
+constexpr int nchar(char c, char_table table)
+{
+    int n = 0;
+    if (table != char_table::alphanum && table != char_table::numeric)
+    {
+        if (c == ' ')
+            return n;
+        n += 1;
+    }
+    if (table != char_table::letters_space)
+    {
+        if (is_digit(c))
+            return n + (c - '0');
+        n += 10;
+    }
+    if (table != char_table::numeric)
+    {
+        if (c >= 'A' && c <= 'Z')
+            return n + (c - 'A');
+        n += 26;
+    }
+    if (table == char_table::alphanum_space_slash && c == '/')
+        return n;
+    return -1;
+}
+
+// dd_to_int() of text.c
+constexpr int dd_to_int(std::string_view s, int length)
+{
+    int result = 0;
+    std::size_t i = 0;
+    const bool negative = !s.empty() && s[0] == '-';
+    if (!s.empty() && (s[0] == '-' || s[0] == '+'))
+        i = 1;
+    for (; i < (std::size_t)length && i < s.size() && is_digit(s[i]); ++i)
+        result = result * 10 + (s[i] - '0');
+    return negative ? -result : result;
+}
+
+// pack_basecall() of message.c
+constexpr int32_t pack_basecall(std::string_view callsign, int length)
+{
+    if (length <= 2)
+        return -1;
+
+    char c6[6] = { ' ', ' ', ' ', ' ', ' ', ' ' };
+    auto copy = [&](int to, int from, int n) {
+        for (int i = 0; i < n; ++i)
+            c6[to + i] = callsign[from + i];
+    };
+
+    if (callsign.substr(0, 4) == "3DA0" && length > 4 && length <= 7)
+    {
+        // Swaziland prefix: 3DA0XYZ -> 3D0XYZ
+        c6[0] = '3';
+        c6[1] = 'D';
+        c6[2] = '0';
+        copy(3, 4, length - 4);
+    }
+    else if (callsign.substr(0, 2) == "3X" && is_letter(callsign[2]) && length <= 7)
+    {
+        // Guinea prefixes: 3XA0XYZ -> QA0XYZ
+        c6[0] = 'Q';
+        copy(1, 2, length - 2);
+    }
+    else if (is_digit(callsign[2]) && length <= 6)
+    {
+        copy(0, 0, length); // AB0XYZ
+    }
+    else if (is_digit(callsign[1]) && length <= 5)
+    {
+        copy(1, 0, length); // A0XYZ -> " A0XYZ"
+    }
+
+    const int i0 = nchar(c6[0], char_table::alphanum_space);
+    const int i1 = nchar(c6[1], char_table::alphanum);
+    const int i2 = nchar(c6[2], char_table::numeric);
+    const int i3 = nchar(c6[3], char_table::letters_space);
+    const int i4 = nchar(c6[4], char_table::letters_space);
+    const int i5 = nchar(c6[5], char_table::letters_space);
+    if (i0 < 0 || i1 < 0 || i2 < 0 || i3 < 0 || i4 < 0 || i5 < 0)
+        return -1;
+
+    return ((((i0 * 36 + i1) * 10 + i2) * 27 + i3) * 27 + i4) * 27 + i5;
+}
+
+// 22-bit hash of save_callsign() of message.c, -1 on a wrong character
+constexpr int32_t hash22(std::string_view callsign)
+{
+    uint64_t n58 = 0;
+    for (std::size_t i = 0; i < 11; ++i)
+    {
+        const int j = i < callsign.size() ? nchar(callsign[i], char_table::alphanum_space_slash) : 0;
+        if (j < 0)
+            return -1;
+        n58 = 38 * n58 + (uint64_t)j;
+    }
+    return (int32_t)(((47055833459ull * n58) >> (64 - 22)) & 0x3FFFFFul);
+}
+
+// pack28() of message.c
+constexpr int32_t pack28(std::string_view callsign, uint8_t& ip)
+{
+    ip = 0;
+    if (callsign == "DE")
+        return 0;
+    if (callsign == "QRZ")
+        return 1;
+    if (callsign == "CQ")
+        return 2;
+
+    const int length = (int)callsign.size();
+    if (callsign.substr(0, 3) == "CQ_" && length < 8)
+        return -1; // CQ_nnn / CQ_abcd, not implemented by message.c either
+
+    int length_base = length;
+    if (ends_with(callsign, "/P") || ends_with(callsign, "/R"))
+    {
+        ip = 1;
+        length_base = length - 2;
+    }
+
+    const int32_t n28 = pack_basecall(callsign, length_base);
+    if (n28 >= 0)
+        return hash22(callsign) < 0 ? -1 : (int32_t)(kNTokens + kMax22 + (uint32_t)n28);
+
+    if (length >= 3 && length <= 11)
+    {
+        const int32_t n22 = hash22(callsign);
+        ip = 0;
+        return n22 < 0 ? -1 : (int32_t)(kNTokens + (uint32_t)n22);
+    }
+
+    return -1;
+}
+
+// packgrid() of message.c, -1 if it is neither a grid nor a report
+constexpr int32_t packgrid(std::string_view grid4)
+{
+    if (grid4.empty())
+        return kMaxGrid4 + 1;
+    if (grid4 == "RRR")
+        return kMaxGrid4 + 2;
+    if (grid4 == "RR73")
+        return kMaxGrid4 + 3;
+    if (grid4 == "73")
+        return kMaxGrid4 + 4;
+
+    if (grid4.size() == 4 && in_range(grid4[0], 'A', 'R') && in_range(grid4[1], 'A', 'R') && is_digit(grid4[2]) && is_digit(grid4[3]))
+    {
+        return (((grid4[0] - 'A') * 18 + (grid4[1] - 'A')) * 10 + (grid4[2] - '0')) * 10 + (grid4[3] - '0');
+    }
+
+    // Report: +dd / -dd / R+dd / R-dd. Below -30 it would alias RRR..73.
+    const int32_t ir = grid4[0] == 'R' ? 0x8000 : 0;
+    const std::string_view report = ir ? grid4.substr(1) : grid4;
+    if (report.size() < 2 || report.size() > 3 || (report[0] != '+' && report[0] != '-') || !is_digit(report[1])
+        || (report.size() == 3 && !is_digit(report[2])))
+        return -1;
+    const int dd = dd_to_int(report, 3);
+    if (dd < -30)
+        return -1;
+    return (kMaxGrid4 + 35 + dd) | ir;
+}
+
+// Next space separated token, as copy_token() of text.c
+constexpr std::string_view next_token(std::string_view& s)
+{
+    const std::size_t end = s.find(' ');
+    const std::string_view token = s.substr(0, end);
+    s = end == std::string_view::npos ? std::string_view() : s.substr(end);
+    while (!s.empty() && s[0] == ' ')
+        s.remove_prefix(1);
+    return token;
+}
+
+// ftx_message_encode() restricted to ftx_message_encode_std().
+// Returns nullptr if packed, else the reason; payload is left as is then.
+constexpr const char* pack_standard(std::string_view message, payload_t& payload)
+{
+    const std::string_view call_to = next_token(message);
+    const std::string_view call_de = next_token(message);
+    const std::string_view extra = next_token(message);
+    if (call_to.size() > 11 || call_de.size() > 11 || extra.size() > 19)
+        return "token too long";
+    if (!message.empty())
+        return "not a standard message";
+
+    uint8_t ipa = 0, ipb = 0;
+    const int32_t n28a = pack28(call_to, ipa);
+    const int32_t n28b = pack28(call_de, ipb);
+    if (n28a < 0 || n28b < 0)
+        return "callsign can't be packed";
+
+    uint8_t i3 = 1;
+    if (ends_with(call_to, "/P") || ends_with(call_de, "/P"))
+    {
+        i3 = 2;
+        if (ends_with(call_to, "/R") || ends_with(call_de, "/R"))
+            return "both /P and /R suffixes";
+    }
+
+    const int32_t n16 = packgrid(extra);
+    if (n16 < 0)
+        return "neither a grid nor a report";
+    const uint16_t igrid4 = (uint16_t)n16;
+
+    uint32_t n29a = ((uint32_t)n28a << 1) | ipa;
+    const uint32_t n29b = ((uint32_t)n28b << 1) | ipb;
+    if (ends_with(call_to, "/R"))
+        n29a |= 1;
+    else if (ends_with(call_to, "/P"))
+    {
+        n29a |= 1;
+        i3 = 2;
+    }
+
+    payload[0] = (uint8_t)(n29a >> 21);
+    payload[1] = (uint8_t)(n29a >> 13);
+    payload[2] = (uint8_t)(n29a >> 5);
+    payload[3] = (uint8_t)((n29a << 3) | (n29b >> 26));
+    payload[4] = (uint8_t)(n29b >> 18);
+    payload[5] = (uint8_t)(n29b >> 10);
+    payload[6] = (uint8_t)(n29b >> 2);
+    payload[7] = (uint8_t)((n29b << 6) | (igrid4 >> 10));
+    payload[8] = (uint8_t)(igrid4 >> 2);
+    payload[9] = (uint8_t)((igrid4 << 6) | (i3 << 3));
+    return nullptr;
+}
+
+// ftx_compute_crc() of crc.c
+constexpr uint16_t compute_crc(const std::array<uint8_t, 12>& message, int num_bits)
+{
+    constexpr uint16_t topbit = 1u << (kCrcWidth - 1);
+    uint16_t remainder = 0;
+    for (int idx_bit = 0; idx_bit < num_bits; ++idx_bit)
+    {
+        if (idx_bit % 8 == 0)
+            remainder ^= (uint16_t)(message[idx_bit / 8] << (kCrcWidth - 8));
+        remainder = (remainder & topbit) ? (uint16_t)((remainder << 1) ^ kCrcPolynomial) : (uint16_t)(remainder << 1);
+    }
+    return remainder & ((topbit << 1) - 1u);
+}
+
+// ftx_add_crc() of crc.c: 77 bits of payload + 14 bits of CRC
+constexpr std::array<uint8_t, 12> add_crc(const payload_t& payload)
+{
+    std::array<uint8_t, 12> a91{};
+    for (int i = 0; i < 10; ++i)
+        a91[i] = payload[i];
+    a91[9] &= 0xF8u;
+
+    const uint16_t checksum = compute_crc(a91, 96 - 14);
+    a91[9] |= (uint8_t)(checksum >> 11);
+    a91[10] = (uint8_t)(checksum >> 3);
+    a91[11] = (uint8_t)(checksum << 5);
+    return a91;
+}
+
+// encode174() of encode.c
+constexpr std::array<uint8_t, 22> encode174(const std::array<uint8_t, 12>& message)
+{
+    std::array<uint8_t, 22> codeword{};
+    for (int j = 0; j < 12; ++j)
+        codeword[j] = message[j];
+
+    for (int i = 0; i < 83; ++i)
+    {
+        uint8_t nsum = 0;
+        for (int j = 0; j < 12; ++j)
+        {
+            uint8_t bits = message[j] & kLDPC_generator[i][j];
+            bits ^= bits >> 4;
+            bits ^= bits >> 2;
+            bits ^= bits >> 1;
+            nsum ^= bits & 1u;
+        }
+        if (nsum)
+        {
+            const int bit = 91 + i;
+            codeword[bit / 8] |= (uint8_t)(0x80u >> (bit % 8));
+        }
+    }
+    return codeword;
+}
+
+constexpr int codeword_bit(const std::array<uint8_t, 22>& codeword, int bit)
+{
+    return (codeword[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+} // namespace detail
+
+/// FT8 tones of a packed 77-bit payload, same as ft8_encode()
+constexpr tones_t encode_payload(const payload_t& payload)
+{
+    const auto codeword = detail::encode174(detail::add_crc(payload));
+
+    tones_t tones{};
+    int bit = 0;
+    for (int i = 0; i < 79; ++i)
+    {
+        if (i < 7 || (i >= 36 && i < 43) || i >= 72)
+        {
+            tones[i] = detail::kFT8_Costas_pattern[i % 36 % 7];
+            continue;
+        }
+        const int bits3 = detail::codeword_bit(codeword, bit) << 2 | detail::codeword_bit(codeword, bit + 1) << 1
+                          | detail::codeword_bit(codeword, bit + 2);
+        bit += 3;
+        tones[i] = detail::kFT8_Gray_map[bits3];
+    }
+    return tones;
+}
+
+/// FT4 tones of a packed 77-bit payload, same as ft4_encode()
+constexpr tones_ft4_t encode_payload_ft4(const payload_t& payload)
+{
+    payload_t payload_xor{};
+    for (int i = 0; i < 10; ++i)
+        payload_xor[i] = payload[i] ^ detail::kFT4_XOR_sequence[i];
+    const auto codeword = detail::encode174(detail::add_crc(payload_xor));
+
+    tones_ft4_t tones{};
+    int bit = 0;
+    for (int i = 0; i < 105; ++i)
+    {
+        if (i == 0 || i == 104)
+        {
+            tones[i] = 0; // Ramp
+            continue;
+        }
+        if (i < 5 || (i >= 34 && i < 38) || (i >= 67 && i < 71) || i >= 100)
+        {
+            const int block = i < 5 ? 0 : i < 38 ? 1 : i < 71 ? 2 : 3;
+            const int first = block == 0 ? 1 : block == 1 ? 34 : block == 2 ? 67 : 100;
+            tones[i] = detail::kFT4_Costas_pattern[block][i - first];
+            continue;
+        }
+        const int bits2 = detail::codeword_bit(codeword, bit) << 1 | detail::codeword_bit(codeword, bit + 1);
+        bit += 2;
+        tones[i] = detail::kFT4_Gray_map[bits2];
+    }
+    return tones;
+}
+
+/// Pack a standard message into 77 bits, same as ftx_message_encode() for Type 1/2
+constexpr payload_t pack(std::string_view message)
+{
+    payload_t payload{};
+    const char* error = detail::pack_standard(message, payload);
+    if (error)
+        detail::invalid_message(error); // At run time: all zeros
+    return payload;
+}
+
+/// FT8 tones of a standard message
+constexpr tones_t encode(std::string_view message) { return encode_payload(pack(message)); }
+
+/// FT4 tones of a standard message
+constexpr tones_ft4_t encode_ft4(std::string_view message) { return encode_payload_ft4(pack(message)); }
+
+namespace detail
+{
+
+template <std::size_t N>
+constexpr bool tones_equal(const std::array<uint8_t, N>& tones, std::string_view digits)
+{
+    if (digits.size() != N)
+        return false;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        if (tones[i] != digits[i] - '0')
+            return false;
+    }
+    return true;
+}
+
+// Reference tones produced by ft8_encode() / ft4_encode() of encode.c
+static_assert(tones_equal(encode("CQ K1TE FN42"),
+                  "3140652000000001005701332406021534323140652154201103152052147700627420133140652"),
+    "FT8 CQ K1TE FN42");
+static_assert(tones_equal(encode("CQ VU3CER MK68"),
+                  "3140652000000001141754447112052027503140652647265175570207753223415102003140652"),
+    "FT8 CQ VU3CER MK68");
+static_assert(tones_equal(encode("K1ABC/R W9XYZ R-12"),
+                  "3140652032247523404061147027461421443140652547121262450372762323473254653140652"),
+    "FT8 K1ABC/R W9XYZ R-12");
+static_assert(tones_equal(encode_ft4("CQ VU3CER MK68"),
+                  "0013210331123303131023322322033112102300231210301233002223201020001231001311230113311122013333310023320"
+                  "10"),
+    "FT4 CQ VU3CER MK68");
+
+} // namespace detail
+
+} // namespace ft8
+
+#endif // _INCLUDE_ENCODE_CONSTEXPR_HPP_
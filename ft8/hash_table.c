@@ -0,0 +1,146 @@
+#include "hash_table.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if FTX_HASH_TABLE_BITS > 10
+#error "FTX_HASH_TABLE_BITS over 10: n12 hashes wouldn't give the home slot"
+#endif
+
+#define CALL_WORDS 3 // 11 chars + terminator
+
+// Data words are atomics too, so a reader racing with a writer is defined
+// behaviour; relaxed accesses cost the same as plain ones.
+typedef struct
+{
+    atomic_uint_least32_t seq;             ///< Odd while the entry is written
+    atomic_uint_least32_t key;             ///< n22 + 1, 0 - empty
+    atomic_uint_least32_t age;             ///< Clock of the last save or hit
+    atomic_uint_least32_t call[CALL_WORDS]; ///< Callsign, NUL padded
+} hash_entry_t;
+
+static hash_entry_t table[FTX_HASH_TABLE_SIZE];
+static atomic_uint_least32_t clock_now;
+
+#if PICO_ON_DEVICE
+#define WRITE_LOCK()
+#define WRITE_UNLOCK()
+#else
+static atomic_flag write_lock = ATOMIC_FLAG_INIT;
+#define WRITE_LOCK()                                                             \
+    while (atomic_flag_test_and_set_explicit(&write_lock, memory_order_acquire)) \
+    {                                                                            \
+    }
+#define WRITE_UNLOCK() atomic_flag_clear_explicit(&write_lock, memory_order_release)
+#endif
+
+ftx_callsign_hash_interface_t ftx_hash_table_if = {
+    .lookup_hash = ftx_hash_table_lookup,
+    .save_hash = ftx_hash_table_save
+};
+
+static uint32_t home_slot(uint32_t n22)
+{
+    return n22 >> (22 - FTX_HASH_TABLE_BITS);
+}
+
+// Consistent copy of an entry, returns its key
+static uint32_t read_entry(hash_entry_t* e, uint32_t* call)
+{
+    for (;;)
+    {
+        uint32_t seq = atomic_load_explicit(&e->seq, memory_order_acquire);
+        if (seq & 1u)
+            continue;
+
+        uint32_t key = atomic_load_explicit(&e->key, memory_order_relaxed);
+        for (int i = 0; i < CALL_WORDS; ++i)
+            call[i] = atomic_load_explicit(&e->call[i], memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&e->seq, memory_order_relaxed) == seq)
+            return key;
+    }
+}
+
+static void write_entry(hash_entry_t* e, uint32_t key, const uint32_t* call, uint32_t age)
+{
+    uint32_t seq = atomic_load_explicit(&e->seq, memory_order_relaxed);
+    atomic_store_explicit(&e->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&e->key, key, memory_order_relaxed);
+    atomic_store_explicit(&e->age, age, memory_order_relaxed);
+    for (int i = 0; i < CALL_WORDS; ++i)
+        atomic_store_explicit(&e->call[i], call[i], memory_order_relaxed);
+
+    atomic_store_explicit(&e->seq, seq + 2, memory_order_release);
+}
+
+bool ftx_hash_table_lookup(ftx_callsign_hash_type_t hash_type, uint32_t hash, char* callsign)
+{
+    // Compare the top bits of n22 which the hash has
+    int shift = (hash_type == FTX_CALLSIGN_HASH_22_BITS) ? 0 : ((hash_type == FTX_CALLSIGN_HASH_12_BITS) ? 10 : 12);
+    uint32_t slot = home_slot(hash << shift);
+
+    for (int i = 0; i < FTX_HASH_TABLE_PROBES; ++i)
+    {
+        hash_entry_t* e = &table[(slot + i) % FTX_HASH_TABLE_SIZE];
+        uint32_t call[CALL_WORDS];
+        uint32_t key = read_entry(e, call);
+        if (key != 0 && ((key - 1) >> shift) == hash)
+        {
+            // Just a hint for eviction, a lost update doesn't matter
+            atomic_store_explicit(&e->age, atomic_load_explicit(&clock_now, memory_order_relaxed), memory_order_relaxed);
+            memcpy(callsign, call, sizeof(call));
+            callsign[sizeof(call) - 1] = '\0';
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ftx_hash_table_save(const char* callsign, uint32_t n22)
+{
+    uint32_t call[CALL_WORDS] = { 0 };
+    strncpy((char*)call, callsign, sizeof(call) - 1);
+    uint32_t slot = home_slot(n22);
+
+    WRITE_LOCK();
+    uint32_t now = atomic_load_explicit(&clock_now, memory_order_relaxed) + 1;
+    atomic_store_explicit(&clock_now, now, memory_order_relaxed);
+
+    // The same call, else an empty slot, else the oldest one
+    hash_entry_t* victim = NULL;
+    for (int i = 0; i < FTX_HASH_TABLE_PROBES; ++i)
+    {
+        hash_entry_t* e = &table[(slot + i) % FTX_HASH_TABLE_SIZE];
+        uint32_t key = atomic_load_explicit(&e->key, memory_order_relaxed);
+        if (key == n22 + 1)
+        {
+            victim = e;
+            break;
+        }
+        if (key == 0)
+        {
+            if (victim == NULL || atomic_load_explicit(&victim->key, memory_order_relaxed) != 0)
+                victim = e;
+        }
+        else if (victim == NULL || (atomic_load_explicit(&victim->key, memory_order_relaxed) != 0 && (int32_t)(atomic_load_explicit(&e->age, memory_order_relaxed) - atomic_load_explicit(&victim->age, memory_order_relaxed)) < 0))
+        {
+            victim = e;
+        }
+    }
+    write_entry(victim, n22 + 1, call, now);
+    WRITE_UNLOCK();
+}
+
+void ftx_hash_table_clear(void)
+{
+    WRITE_LOCK();
+    const uint32_t none[CALL_WORDS] = { 0 };
+    for (uint32_t i = 0; i < FTX_HASH_TABLE_SIZE; ++i)
+        write_entry(&table[i], 0, none, 0);
+    WRITE_UNLOCK();
+}
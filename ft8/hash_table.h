@@ -0,0 +1,56 @@
+#ifndef _INCLUDE_HASH_TABLE_H_
+#define _INCLUDE_HASH_TABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "message.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Callsign hash table behind ftx_callsign_hash_interface_t, so hashed calls
+// (<...>) of Type 1/2/4 messages resolve to the calls seen before.
+//
+// Fixed capacity, no heap: open addressing with linear probing, the home slot
+// of a call is given by the top bits of its n22 hash. As n12 = n22 >> 10 and
+// n10 = n22 >> 12, lookups by 12 and 10 bit hashes find the same home slot.
+// A call is never further than FTX_HASH_TABLE_PROBES slots from its home;
+// when all of them are taken, the least recently saved or found one is evicted.
+//
+// Lookups are lock-free: every entry has a sequence counter which is odd while
+// it's written, a reader retries when it sees the counter odd or changed.
+// Saves are serialized by a spinlock on host; on device only the main loop
+// encodes, so there is no lock there.
+
+#ifndef FTX_HASH_TABLE_BITS
+#define FTX_HASH_TABLE_BITS 8 ///< log2 of the capacity, 10 at most (n12 top bits)
+#endif
+#define FTX_HASH_TABLE_SIZE   (1u << FTX_HASH_TABLE_BITS)
+#define FTX_HASH_TABLE_PROBES 8 ///< Slots searched from the home one
+
+/// Interface to pass to ftx_message_encode()/ftx_message_decode() and friends
+extern ftx_callsign_hash_interface_t ftx_hash_table_if;
+
+/// Look a callsign up by its 22/12/10 bit hash, see ftx_callsign_hash_interface_t
+/// @param[in] hash_type - width of the hash
+/// @param[in] hash - hash value
+/// @param[out] callsign - 12 byte buffer for the call
+/// @return true if found
+bool ftx_hash_table_lookup(ftx_callsign_hash_type_t hash_type, uint32_t hash, char* callsign);
+
+/// Store a callsign by its 22 bit hash, see ftx_callsign_hash_interface_t
+/// @param[in] callsign - the call, 11 chars at most
+/// @param[in] n22 - its 22 bit hash
+void ftx_hash_table_save(const char* callsign, uint32_t n22);
+
+/// Forget all the calls. Not safe against concurrent lookups.
+void ftx_hash_table_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _INCLUDE_HASH_TABLE_H_
@@ -3,7 +3,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define LOG_LEVEL LOG_WARN
 #include "debug.h"
 
 #define MAX22    ((uint32_t)4194304ul)
@@ -124,35 +123,48 @@ ftx_message_rc_t ftx_message_encode(ftx_message_t* msg, ftx_callsign_hash_interf
     parse_position = copy_token(call_de, 12, parse_position);
     parse_position = copy_token(extra, 20, parse_position);
 
+    // A lone token of hex digits is telemetry, as WSJT-X treats it
+    if (call_de[0] == '\0' && ftx_message_encode_telemetry_hex(msg, message_text) == FTX_MESSAGE_RC_OK)
+        return FTX_MESSAGE_RC_OK;
+
+    ftx_message_rc_t rc;
     if (call_to[11] != '\0')
     {
         // token too long
-        return FTX_MESSAGE_RC_ERROR_CALLSIGN1;
+        rc = FTX_MESSAGE_RC_ERROR_CALLSIGN1;
     }
-    if (call_de[11] != '\0')
+    else if (call_de[11] != '\0')
     {
         // token too long
-        return FTX_MESSAGE_RC_ERROR_CALLSIGN2;
+        rc = FTX_MESSAGE_RC_ERROR_CALLSIGN2;
     }
-    if (extra[19] != '\0')
+    else if (extra[19] != '\0')
     {
         // token too long
-        return FTX_MESSAGE_RC_ERROR_GRID;
+        rc = FTX_MESSAGE_RC_ERROR_GRID;
+    }
+    else
+    {
+        rc = ftx_message_encode_std(msg, hash_if, call_to, call_de, extra);
+        if (rc == FTX_MESSAGE_RC_OK)
+            return rc;
+        rc = ftx_message_encode_nonstd(msg, hash_if, call_to, call_de, extra);
+        if (rc == FTX_MESSAGE_RC_OK)
+            return rc;
     }
 
-    ftx_message_rc_t rc;
-    rc = ftx_message_encode_std(msg, hash_if, call_to, call_de, extra);
-    if (rc == FTX_MESSAGE_RC_OK)
-        return rc;
-    rc = ftx_message_encode_nonstd(msg, hash_if, call_to, call_de, extra);
-    if (rc == FTX_MESSAGE_RC_OK)
-        return rc;
-
-    // rc = ftx_message_encode_telemetry_hex(msg, hash_if, call_to, call_de, extra);
+    // Free text is the last resort, the error of a structured message is more telling
+    if (ftx_message_encode_free(msg, message_text) == FTX_MESSAGE_RC_OK)
+        return FTX_MESSAGE_RC_OK;
 
     return rc;
 }
 
+uint16_t ftx_message_pack_grid(const char* extra)
+{
+    return packgrid(extra);
+}
+
 ftx_message_rc_t ftx_message_encode_std(ftx_message_t* msg, ftx_callsign_hash_interface_t* hash_if, const char* call_to, const char* call_de, const char* extra)
 {
     uint8_t ipa, ipb;
@@ -457,6 +469,97 @@ ftx_message_rc_t ftx_message_decode_nonstd(const ftx_message_t* msg, ftx_callsig
     return FTX_MESSAGE_RC_OK;
 }
 
+ftx_message_rc_t ftx_message_encode_free(ftx_message_t* msg, const char* text)
+{
+    // Skip leading and trailing spaces
+    while (*text == ' ')
+        ++text;
+    int length = strlen(text);
+    while (length > 0 && text[length - 1] == ' ')
+        --length;
+    if (length > 13)
+        return FTX_MESSAGE_RC_ERROR_TYPE;
+
+    // Base-42 number of 13 chars (< 2^71) in two words, hi holds bits 64..70.
+    // Multiplying lo in 32-bit halves keeps every product within 64 bits.
+    uint64_t hi = 0, lo = 0;
+    for (int j = 0; j < 13; ++j)
+    {
+        int q = 0;
+        if (j < length)
+        {
+            q = nchar(text[j], FT8_CHAR_TABLE_FULL);
+            if (q < 0)
+                return FTX_MESSAGE_RC_ERROR_TYPE;
+        }
+        uint64_t t0 = (lo & 0xFFFFFFFFu) * 42 + (uint64_t)q;
+        uint64_t t1 = (lo >> 32) * 42 + (t0 >> 32);
+        lo = (t1 << 32) | (t0 & 0xFFFFFFFFu);
+        hi = hi * 42 + (t1 >> 32);
+    }
+
+    uint8_t b71[9];
+    b71[0] = (uint8_t)hi;
+    for (int i = 8; i > 0; --i)
+    {
+        b71[i] = (uint8_t)lo;
+        lo >>= 8;
+    }
+
+    // Same layout as telemetry, then n3 = 0 (bits 71..73) and i3 = 0 (bits 74..76)
+    ftx_message_encode_telemetry(msg, b71);
+    msg->payload[8] &= 0xFEu;
+    msg->payload[9] = 0;
+    return FTX_MESSAGE_RC_OK;
+}
+
+ftx_message_rc_t ftx_message_encode_telemetry_hex(ftx_message_t* msg, const char* telemetry_hex)
+{
+    while (*telemetry_hex == ' ')
+        ++telemetry_hex;
+
+    int len = 0;
+    while (is_digit(telemetry_hex[len]) || (telemetry_hex[len] >= 'A' && telemetry_hex[len] <= 'F') || (telemetry_hex[len] >= 'a' && telemetry_hex[len] <= 'f'))
+        ++len;
+    for (int i = len; telemetry_hex[i] != '\0'; ++i)
+    {
+        if (telemetry_hex[i] != ' ')
+            return FTX_MESSAGE_RC_ERROR_TYPE;
+    }
+    if (len == 0 || len > 18)
+        return FTX_MESSAGE_RC_ERROR_TYPE;
+
+    // Right-align the digits in 72 bits
+    uint8_t b71[9] = { 0 };
+    for (int i = 0; i < len; ++i)
+    {
+        char c = telemetry_hex[len - 1 - i];
+        uint8_t nibble = is_digit(c) ? (c - '0') : ((c & ~0x20) - 'A' + 10);
+        b71[8 - i / 2] |= (i & 1) ? (nibble << 4) : nibble;
+    }
+    if (b71[0] & 0x80u)
+    {
+        // Doesn't fit in 71 bits
+        return FTX_MESSAGE_RC_ERROR_TYPE;
+    }
+
+    ftx_message_encode_telemetry(msg, b71);
+    return FTX_MESSAGE_RC_OK;
+}
+
+void ftx_message_encode_telemetry(ftx_message_t* msg, const uint8_t* telemetry)
+{
+    // Shift bits in telemetry left by 1 bit to left-align the data
+    for (int i = 0; i < 8; ++i)
+    {
+        msg->payload[i] = (telemetry[i] << 1) | (telemetry[i + 1] >> 7);
+    }
+
+    // Pack into 71 + 3 (n3 = 5) + 3 (i3 = 0) bits
+    msg->payload[8] = (telemetry[8] << 1) | 0x01u;
+    msg->payload[9] = 0x40u;
+}
+
 void ftx_message_decode_free(const ftx_message_t* msg, char* text)
 {
     uint8_t b71[9];
@@ -992,67 +1095,3 @@ static int unpackgrid(uint16_t igrid4, uint8_t ir, char* extra)
 
     return 0;
 }
-
-void packtext77(const char* text, uint8_t* b77)
-{
-    int length = strlen(text);
-
-    // Skip leading and trailing spaces
-    while (*text == ' ' && *text != 0)
-    {
-        ++text;
-        --length;
-    }
-    while (length > 0 && text[length - 1] == ' ')
-    {
-        --length;
-    }
-
-    // Clear the first 72 bits representing a long number
-    for (int i = 0; i < 9; ++i)
-    {
-        b77[i] = 0;
-    }
-
-    // Now express the text as base-42 number stored
-    // in the first 72 bits of b77
-    for (int j = 0; j < 13; ++j)
-    {
-        // Multiply the long integer in b77 by 42
-        uint16_t x = 0;
-        for (int i = 8; i >= 0; --i)
-        {
-            x += b77[i] * (uint16_t)42;
-            b77[i] = (x & 0xFF);
-            x >>= 8;
-        }
-
-        // Get the index of the current char
-        if (j < length)
-        {
-            int q = nchar(text[j], FT8_CHAR_TABLE_FULL);
-            x = (q > 0) ? q : 0;
-        }
-        else
-        {
-            x = 0;
-        }
-        // Here we double each added number in order to have the result multiplied
-        // by two as well, so that it's a 71 bit number left-aligned in 72 bits (9 bytes)
-        x <<= 1;
-
-        // Now add the number to our long number
-        for (int i = 8; i >= 0; --i)
-        {
-            if (x == 0)
-                break;
-            x += b77[i];
-            b77[i] = (x & 0xFF);
-            x >>= 8;
-        }
-    }
-
-    // Set n3=0 (bits 71..73) and i3=0 (bits 74..76)
-    b77[8] &= 0xFE;
-    b77[9] &= 0x00;
-}
@@ -102,12 +102,21 @@ ftx_message_rc_t ftx_message_encode(ftx_message_t* msg, ftx_callsign_hash_interf
 /// - nonstandard calls within <> brackets are allowed, if they don't contain '/'
 ftx_message_rc_t ftx_message_encode_std(ftx_message_t* msg, ftx_callsign_hash_interface_t* hash_if, const char* call_to, const char* call_de, const char* extra);
 
+/// Pack the grid/report field of Type 1/2 message: 15 bits of igrid4, ir flag in bit 15
+/// - extra can be a 4 letter grid, '', 'RRR', 'RR73', '73', '+dd', '-dd', 'R+dd' or 'R-dd'
+uint16_t ftx_message_pack_grid(const char* extra);
+
 /// Pack Type 4 (One nonstandard call and one hashed call) message
 ftx_message_rc_t ftx_message_encode_nonstd(ftx_message_t* msg, ftx_callsign_hash_interface_t* hash_if, const char* call_to, const char* call_de, const char* extra);
 
-void ftx_message_encode_free(const char* text);
-void ftx_message_encode_telemetry_hex(const char* telemetry_hex);
-void ftx_message_encode_telemetry(const uint8_t* telemetry);
+/// Pack Type 0.0 (free text) message: up to 13 chars of " 0-9A-Z+-./?", outer spaces are dropped
+ftx_message_rc_t ftx_message_encode_free(ftx_message_t* msg, const char* text);
+
+/// Pack Type 0.5 (telemetry) message from up to 18 hex digits, the value must fit in 71 bits
+ftx_message_rc_t ftx_message_encode_telemetry_hex(ftx_message_t* msg, const char* telemetry_hex);
+
+/// Pack Type 0.5 (telemetry) message from 9 bytes, 71 bits right-aligned (the top bit is ignored)
+void ftx_message_encode_telemetry(ftx_message_t* msg, const uint8_t* telemetry);
 
 ftx_message_rc_t ftx_message_decode(const ftx_message_t* msg, ftx_callsign_hash_interface_t* hash_if, char* message);
 ftx_message_rc_t ftx_message_decode_std(const ftx_message_t* msg, ftx_callsign_hash_interface_t* hash_if, char* call_to, char* call_de, char* extra);
@@ -0,0 +1,114 @@
+#include "template.h"
+#include "encode.h"
+#include "crc.h"
+
+#include <string.h>
+
+// Type 1/2 message: (28 + 1) + (28 + 1) + (1 + 15) + 3 bits, ir + igrid4 starts at bit 58
+#define GRID_FIELD_OFFSET 58
+#define GRID_FIELD_BITS   16
+
+// Dummy field value of the pattern which packs into all zero bits
+#define GRID_FIELD_ZERO "AA00"
+
+static void set_payload_bit(uint8_t* payload, int bit)
+{
+    payload[bit / 8] |= (uint8_t)(0x80u >> (bit % 8));
+}
+
+// Codeword of a payload without FT4 scrambling: CRC + LDPC only
+static void payload_to_codeword(const uint8_t* payload, uint8_t* codeword)
+{
+    uint8_t a91[FTX_LDPC_K_BYTES];
+    ftx_add_crc(payload, a91);
+    ftx_encode174(a91, codeword);
+}
+
+ftx_message_rc_t ftx_template_compile(ftx_template_t* tpl, const char* pattern, ftx_callsign_hash_interface_t* hash_if, bool is_ft4)
+{
+    const char* field = strstr(pattern, FTX_TEMPLATE_FIELD);
+    const size_t prefix_len = field ? (size_t)(field - pattern) : 0;
+    if (!field || field[strlen(FTX_TEMPLATE_FIELD)] != '\0' || prefix_len + sizeof(GRID_FIELD_ZERO) > FTX_MAX_MESSAGE_LENGTH)
+    {
+        return FTX_MESSAGE_RC_ERROR_GRID;
+    }
+
+    char text[FTX_MAX_MESSAGE_LENGTH];
+    memcpy(text, pattern, prefix_len);
+    strcpy(text + prefix_len, GRID_FIELD_ZERO);
+
+    ftx_message_t msg;
+    ftx_message_rc_t rc = ftx_message_encode(&msg, hash_if, text);
+    if (rc != FTX_MESSAGE_RC_OK)
+    {
+        return rc;
+    }
+    if (ftx_message_get_type(&msg) != FTX_MESSAGE_TYPE_STANDARD)
+    {
+        // Only Type 1/2 messages carry the grid field at a fixed position
+        return FTX_MESSAGE_RC_ERROR_TYPE;
+    }
+
+    tpl->is_ft4 = is_ft4;
+    tpl->field_type = FTX_TEMPLATE_FIELD_GRID;
+    tpl->field_offset = GRID_FIELD_OFFSET;
+    tpl->field_bits = GRID_FIELD_BITS;
+    memcpy(tpl->payload, msg.payload, sizeof(tpl->payload));
+
+    uint8_t constant[FTX_PAYLOAD_LENGTH_BYTES];
+    for (int i = 0; i < FTX_PAYLOAD_LENGTH_BYTES; ++i)
+    {
+        constant[i] = msg.payload[i] ^ (is_ft4 ? kFT4_XOR_sequence[i] : 0);
+    }
+    payload_to_codeword(constant, tpl->codeword);
+
+    for (int i = 0; i < tpl->field_bits; ++i)
+    {
+        uint8_t single[FTX_PAYLOAD_LENGTH_BYTES] = { 0 };
+        set_payload_bit(single, tpl->field_offset + i);
+        payload_to_codeword(single, tpl->basis[i]);
+    }
+
+    return FTX_MESSAGE_RC_OK;
+}
+
+uint32_t ftx_template_pack_field(const ftx_template_t* tpl, const char* field)
+{
+    (void)tpl;
+    return ftx_message_pack_grid(field);
+}
+
+void ftx_template_payload(const ftx_template_t* tpl, uint32_t value, uint8_t* payload)
+{
+    memcpy(payload, tpl->payload, FTX_PAYLOAD_LENGTH_BYTES);
+    for (int i = 0; i < tpl->field_bits; ++i)
+    {
+        if (value & (1u << (tpl->field_bits - 1 - i)))
+        {
+            set_payload_bit(payload, tpl->field_offset + i);
+        }
+    }
+}
+
+void ftx_template_encode(const ftx_template_t* tpl, uint32_t value, uint8_t* tones)
+{
+    uint8_t codeword[FTX_LDPC_N_BYTES];
+    memcpy(codeword, tpl->codeword, sizeof(codeword));
+
+    for (int i = 0; i < tpl->field_bits; ++i)
+    {
+        if (value & (1u << (tpl->field_bits - 1 - i)))
+        {
+            const uint8_t* basis = tpl->basis[i];
+            for (int j = 0; j < FTX_LDPC_N_BYTES; ++j)
+            {
+                codeword[j] ^= basis[j];
+            }
+        }
+    }
+
+    if (tpl->is_ft4)
+        ft4_codeword_to_tones(codeword, tones);
+    else
+        ft8_codeword_to_tones(codeword, tones);
+}
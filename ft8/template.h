@@ -0,0 +1,72 @@
+#ifndef _INCLUDE_TEMPLATE_H_
+#define _INCLUDE_TEMPLATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "constants.h"
+#include "message.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Message templates: a message with one variable field is parsed and encoded
+// once, then every new field value costs only a few XORs of codewords.
+//
+// CRC (zero initial value) and LDPC parity are both linear over GF(2), so the
+// codeword of a payload is the XOR of the codeword of its constant part and of
+// the codewords of the single bits set in the variable field. The FT4 scrambling
+// sequence is a constant too and goes into the constant part.
+
+#define FTX_TEMPLATE_FIELD         "{}" ///< Placeholder of the variable field in a pattern
+#define FTX_TEMPLATE_MAX_FIELD_BITS 16  ///< Widest supported field
+
+typedef enum
+{
+    FTX_TEMPLATE_FIELD_GRID ///< Grid/report of Type 1/2 message, see ftx_message_pack_grid()
+} ftx_template_field_t;
+
+typedef struct
+{
+    bool is_ft4;
+    uint8_t field_type;                                             ///< ftx_template_field_t
+    uint8_t field_offset;                                           ///< Payload bit index of the field MSB
+    uint8_t field_bits;                                             ///< Width of the field
+    uint8_t payload[FTX_PAYLOAD_LENGTH_BYTES];                      ///< Payload with the field zeroed
+    uint8_t codeword[FTX_LDPC_N_BYTES];                             ///< Codeword of the constant part
+    uint8_t basis[FTX_TEMPLATE_MAX_FIELD_BITS][FTX_LDPC_N_BYTES];   ///< Codeword of every field bit, MSB first
+} ftx_template_t;
+
+/// Parse a pattern and precompute its constant part and field basis
+/// @param[out] tpl - the template
+/// @param[in] pattern - message text where the last token is FTX_TEMPLATE_FIELD, e.g. "CQ K1ABC {}"
+/// @param[in] hash_if - callsign hash interface, may be NULL
+/// @param[in] is_ft4 - true for FT4, false for FT8
+/// @return FTX_MESSAGE_RC_OK, or the error of parsing the pattern
+ftx_message_rc_t ftx_template_compile(ftx_template_t* tpl, const char* pattern, ftx_callsign_hash_interface_t* hash_if, bool is_ft4);
+
+/// Pack text of the variable field into its value
+/// @param[in] tpl - the template
+/// @param[in] field - text of the field, e.g. "FN42" or "R-07"
+/// @return the value of the field
+uint32_t ftx_template_pack_field(const ftx_template_t* tpl, const char* field);
+
+/// Produce the payload of the message with the given field value
+/// @param[in] tpl - the template
+/// @param[in] value - the value of the field
+/// @param[out] payload - 10 byte array of 77 bits
+void ftx_template_payload(const ftx_template_t* tpl, uint32_t value, uint8_t* payload);
+
+/// Produce tones of the message with the given field value, same as ft8_encode()/ft4_encode()
+/// @param[in] tpl - the template
+/// @param[in] value - the value of the field
+/// @param[out] tones - array of FT8_NN or FT4_NN bytes
+void ftx_template_encode(const ftx_template_t* tpl, uint32_t value, uint8_t* tones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _INCLUDE_TEMPLATE_H_
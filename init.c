@@ -56,6 +56,7 @@
 #include "pico/stdlib.h"
 #include "hardware/clocks.h"
 #include <defines.h>
+#include <protos.h>
 
 /// @brief Initializes Pi pico low level hardware.
 void InitPicoHW(void)
@@ -63,6 +64,13 @@ void InitPicoHW(void)
     gpio_init(PICO_DEFAULT_LED_PIN);
     gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
 
+    InitPicoClocks();
+}
+
+/// @brief Sets sys & peri clocks to the DCO working frequency.
+/// @brief Also used to restore clocks after a low power period.
+void InitPicoClocks(void)
+{
     const uint32_t clkhz = PLL_SYS_MHZ * 1000000L;
     set_sys_clock_khz(clkhz / kHz, true);
 
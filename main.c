@@ -65,12 +65,17 @@
 #include <defines.h>
 #include <piodco.h>
 #include <WSPRbeacon.h>
-#include <logutils.h>
+#include <PowerMgr.h>
+#include <EnergyBudget.h>
+#include <AdcSampler.h>
+#include <TempComp.h>
+#include <Metrics.h>
+#define LOG_MODULE MAIN
+#include "debug/log.h"
 #include <protos.h>
 
 #include "pico.h"
 #include "pico/util/datetime.h"
-#include "hardware/adc.h"
 // #include "hardware/rtc.h"  // https://www.raspberrypi.com/documentation/pico-sdk/hardware.html#group_hardware_rtc
 
 #define CONFIG_GPS_SOLUTION_IS_MANDATORY NO
@@ -84,26 +89,51 @@
 #define BTN_PIN 16                             // Pin 21 on pico board
 // #define REPEAT_TX_EVERY_MINUTE 4 // 4 is the minimum, for longer intervals choose 6,8,10,12, ...
 #define REPEAT_TX_EVERY_MINUTE 1  // 4 is the minimum, for longer intervals choose 6,8,10,12, ...
+#define CONFIG_FT8_TX_OFFSET_MS 500               // FT8 signal starts 0.5 s into the slot
+#define CONFIG_TX_MODE WSPR_MODE_FT8              // WSPR_MODE_FT8 or WSPR_MODE_FT4
+#define CONFIG_TX_SLOT_PARITY WSPR_SLOT_EVEN      // WSPR_SLOT_ANY, WSPR_SLOT_EVEN or WSPR_SLOT_ODD
+#define CONFIG_SCHEDULE_ENABLED YES               // Transmit by GPS schedule, not only by button
+#define CONFIG_POWER_SAVE YES                     // Lower clocks & stop core1 between slots
+#define CONFIG_ENERGY_BUDGET YES                  // Stretch the schedule when battery is low
+#define CONFIG_TEMP_COMP YES                      // Learn crystal drift vs temp, use it w/o GPS
+#define CONFIG_GPS_UART_BAUD 9600
+#define CONFIG_PLAYLIST YES                       // Send kPlaylist messages in turn, not the built-in one
+
+// Playlist rules, see Playlist/Playlist.h; try them with tools/playlist_sim.c.
+// Every 4th frame is telemetry, decode it with tools/telemetry_decode.c.
+static const char *const kPlaylist[] = {
+  "msg 0 3 any - 0 text CQ VU3CER MK68",
+  "msg 0 1 any - 0 tlm",
+};
 
 WSPRbeaconContext *pWSPR;
 
+static volatile bool sButtonPressed = false;
+
+/// @brief Button GPIO IRQ callback. Wakes up the main loop.
+static void ButtonCallback(uint gpio, uint32_t events) {
+  if (BTN_PIN == gpio) {
+    sButtonPressed = true;
+    __sev();
+  }
+}
+
 int main() {
-  StampPrintf("\n");
+  LOG_I("\n");
   // sleep_ms(5000);
-  StampPrintf("R2BDY and VU3CER Pico-FT8-TX start.");
-
-  adc_init();
-  adc_set_temp_sensor_enabled(true);
+  LOG_I("R2BDY and VU3CER Pico-FT8-TX start.");
+  BinLogInit();
 
   gpio_init(BTN_PIN);
   gpio_set_dir(BTN_PIN, GPIO_IN);
   gpio_pull_up(BTN_PIN);
+  gpio_set_irq_enabled_with_callback(BTN_PIN, GPIO_IRQ_EDGE_FALL, true, &ButtonCallback);
 
   InitPicoHW();
 
   PioDco DCO = { 0 };
 
-  StampPrintf("FT8 beacon init...");
+  LOG_I("FT8 beacon init...");
 
   WSPRbeaconContext *pWB = WSPRbeaconInit(
     CONFIG_CALLSIGN, /* the Callsign. */
@@ -116,38 +146,135 @@ int main() {
   );
   assert_(pWB);
   pWSPR = pWB;
+  MetricsInit(CONFIG_CALLSIGN);
+  pWB->_pADC = AdcSamplerInit();
 
   pWB->_txSched._u8_tx_GPS_mandatory = CONFIG_GPS_SOLUTION_IS_MANDATORY;
   pWB->_txSched._u8_tx_GPS_past_time = CONFIG_GPS_RELY_ON_PAST_SOLUTION;
   pWB->_txSched._u8_tx_slot_skip = CONFIG_SCHEDULE_SKIP_SLOT_COUNT;
+  pWB->_txSched._i16_tx_offset_ms = CONFIG_FT8_TX_OFFSET_MS;
+  pWB->_txSched._u8_tx_slot_parity = CONFIG_TX_SLOT_PARITY;
+  WSPRbeaconSetMode(pWB, CONFIG_TX_MODE);
+  if (CONFIG_PLAYLIST) {
+    PlaylistContext *pPL = PlaylistInit();
+    for (unsigned i = 0; i < count_of(kPlaylist); ++i) {
+      if (PlaylistParseLine(pPL, kPlaylist[i])) {
+        LOG_W("Playlist: bad line %u: %s", i, kPlaylist[i]);
+      }
+    }
+    WSPRbeaconSetPlaylist(pWB, pPL);
+  }
 
   multicore_launch_core1(Core1Entry);
-  StampPrintf("RF oscillator started.");
+  LOG_I("RF oscillator started.");
 
-  DCO._pGPStime = GPStimeInit(0, 9600, GPS_PPS_PIN);
+  DCO._pGPStime = GPStimeInit(0, CONFIG_GPS_UART_BAUD, GPS_PPS_PIN);
   assert_(DCO._pGPStime);
-  StampPrintf("When button pressed, I start transmitting.");
-  int tick = 0;
 
+  PowerMgrContext *pPM = PowerMgrInit(&DCO, Core1Resume, uart0, CONFIG_GPS_UART_BAUD);
+  assert_(pPM);
+
+  EnergyBudgetContext *pEB = EnergyBudgetInit(CONFIG_SCHEDULE_SKIP_SLOT_COUNT,
+                                              WSPR_SLOT_ANY == CONFIG_TX_SLOT_PARITY ? 1 : 2,
+                                              pWB->_u8_naux);
+  assert_(pEB);
+
+  TempCompContext *pTC = TempCompInit();
+  assert_(pTC);
+  if (!TempCompLoad(pTC)) {
+    LOG_I("Temperature drift model loaded, %lu samples.", pTC->_rec._u32_nlearnt);
+  }
+  LOG_I("When button pressed, I start transmitting.");
+  if (CONFIG_SCHEDULE_ENABLED) {
+    LOG_I("When GPS time is known, I transmit by schedule.");
+  }
   while (1) {
-    bool txStarted = 0;
-    while ((!gpio_get(BTN_PIN))) {
-      StampPrintf("Start fsk'ing!");
-      StampPrintf("Not supporting GPS solution, start tx now.");
-      PioDCOStart(pWB->_pTX->_p_oscillator);
-      WSPRbeaconCreatePacket(pWB);
-      sleep_ms(100);
-      WSPRbeaconSendPacket(pWB);
-      StampPrintf("The system will wait for next trigger when tx is completed.");
-      bool wait4endTX = 0;
-      while (!wait4endTX) {
-        if (!TxChannelPending(pWB->_pTX)) {
+    // VSYS sags while on air, sample it between transmissions only.
+    if (CONFIG_ENERGY_BUDGET && WSPR_SCHED_TX != pWB->_u8_sched_state
+        && EnergyBudgetIsDue(pEB, time_us_64())) {
+      if (AdcSamplerIsValid(pWB->_pADC)) {
+        const uint8_t u8_level = pEB->_u8_level;
+        EnergyBudgetUpdate(pEB, time_us_64(), AdcSamplerGetVsysMv(pWB->_pADC));
+        pWB->_txSched._u8_tx_slot_skip = EnergyBudgetSlotSkip(pEB);
+        pWB->_txSched._u8_tx_naux_max = EnergyBudgetMaxAux(pEB);
+        if (u8_level != pEB->_u8_level) {
+          LOG_I("NRG> soc:%u%% rate:%ldmV/h level:%u skip:%u aux:%u", pEB->_u8_soc_pct,
+                pEB->_i32_rate_mv_h, pEB->_u8_level, pWB->_txSched._u8_tx_slot_skip,
+                pWB->_txSched._u8_tx_naux_max);
+        }
+      }
+    }
+    // Learn crystal drift vs temperature from GPS, or apply it if GPS is lost.
+    if (CONFIG_TEMP_COMP && WSPR_SCHED_TX != pWB->_u8_sched_state
+        && AdcSamplerIsValid(pWB->_pADC) && TempCompIsDue(pTC, time_us_64())) {
+      const uint64_t u64_now = time_us_64();
+      const int32_t i32_temp = AdcSamplerGetTempCenti(pWB->_pADC);
+      if (DCO._pGPStime->_time_data._u8_is_solution_active) {
+        TempCompLearn(pTC, u64_now, i32_temp, DCO._pGPStime->_time_data._i32_freq_shift_ppb);
+        TempCompSave(pTC, u64_now);
+      } else {
+        pTC->_u64_last_sample_us = u64_now;
+      }
+      int32_t i32_ppb;
+      if (!TempCompPredict(pTC, i32_temp, &i32_ppb)) {
+        TxChannelSetFallbackPpb(pWB->_pTX, i32_ppb);
+        for (int i = 0; i < pWB->_u8_naux; ++i) {
+          TxChannelSetFallbackPpb(pWB->_pTXaux[i], i32_ppb);
+        }
+      }
+    }
+    if (CONFIG_SCHEDULE_ENABLED) {
+      const uint8_t u8_state = pWB->_u8_sched_state;
+      WSPRbeaconTxScheduler(pWB, YES);
+      if (WSPR_SCHED_TX == u8_state && WSPR_SCHED_TX != pWB->_u8_sched_state) {
+        PowerMgrDumpStats(pPM);
+      }
+    }
+    if (CONFIG_POWER_SAVE && WSPR_SCHED_ARMED == pWB->_u8_sched_state && !sButtonPressed) {
+      // Wake up ahead of the slot alarm which prepares the frame.
+      PowerMgrSleepUntil(pPM, pWB->_u64_next_slot_us - WSPR_PREPARE_LEAD_US - POWER_WAKE_MARGIN_US,
+                         &sButtonPressed);
+    }
+    if (sButtonPressed && WSPR_SCHED_TX != pWB->_u8_sched_state) {
+      sButtonPressed = false;
+      // Off-schedule frame: the playlist and a frame prepared for the armed slot are left alone.
+      if (WSPRbeaconCreateManualPacket(pWB)) {
+        LOG_W("No manual tx: the scheduled frame is ready or can't encode.");
+      } else {
+        LOG_I("Start fsk'ing!");
+        PioDCOStart(pWB->_pTX->_p_oscillator);
+        const uint64_t u64_start_us = WSPRbeaconGetSlotStart(pWB);
+        if (u64_start_us) {
+          LOG_I("GPS time is known, tx at the next slot.");
+        } else {
+          LOG_I("No GPS time, start tx now.");
+          sleep_ms(100);
+        }
+        if (WSPRbeaconSendPacketAt(pWB, u64_start_us)) {
           PioDCOStop(pWB->_pTX->_p_oscillator);
-          StampPrintf("System halted.");
-          wait4endTX = 1;
+          LOG_E("Manual tx failed to start.");
+        } else {
+          LOG_I("The system will wait for next trigger when tx is completed.");
+          while (!WSPRbeaconFrameDone(pWB)) {
+            PowerMgrWaitForEvent(pPM);
+          }
+          PioDCOStop(pWB->_pTX->_p_oscillator);
+          WSPRbeaconAccountTx(pWB);
+          TxChannelDumpJitter(pWB->_pTX);
+          PowerMgrDumpStats(pPM);
         }
+        LOG_I("System halted.");
       }
     }
+    // Metrics requests from USB CDC, e.g. by tools/metrics_poll.py.
+    const int metrics_cmd = MetricsPollCommand();
+    if (metrics_cmd >= 0) {
+      WSPRbeaconUpdateMetrics(pWB);
+      MetricsReply(metrics_cmd);
+    }
+    if (WSPR_SCHED_TX != pWB->_u8_sched_state) {
+      BinLogDrain(0);
+    }
+    PowerMgrWaitForEvent(pPM);
   }
-  sleep_ms(10);
 }
@@ -2,6 +2,8 @@
 #define PROTOS_H_
 
 void InitPicoHW(void);
+void InitPicoClocks(void);
 void Core1Entry(void);
+void Core1Resume(void);
 
 #endif
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+#
+# binlog_decode.py - Turns BinLog records back to text.
+#
+# Reads the beacon console log (a file or stdin), finds `BLG>` lines
+# printed by BinLogDrain() and formats them using the format strings
+# found at their addresses in the firmware ELF. Other lines are passed
+# through untouched, so the output is the complete log.
+#
+# Usage:
+#     ./tools/binlog_decode.py build/pico-wspr-tx.elf minicom.log
+#     cat /dev/ttyACM0 | ./tools/binlog_decode.py build/pico-wspr-tx.elf
+#
+# The ELF must be exactly the one flashed, format pointers are addresses.
+#
+import re
+import struct
+import sys
+
+BLG_RE = re.compile(r"BLG> ([0-9a-fA-F]{48})\s*$")
+SPEC_RE = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcp%])")
+
+
+class Elf32:
+    """Minimal ELF32 little endian reader: maps addresses of PT_LOAD
+    segments to file contents."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("%s: not an ELF32 little endian file" % path)
+        phoff, = struct.unpack_from("<I", self.data, 0x1C)
+        phentsize, phnum = struct.unpack_from("<HH", self.data, 0x2A)
+        self.segments = []
+        for i in range(phnum):
+            p_type, p_offset, p_vaddr, p_paddr, p_filesz = struct.unpack_from(
+                "<IIIII", self.data, phoff + i * phentsize)
+            if p_type == 1 and p_filesz:
+                # Flash resident data is addressed by VMA of XIP segments.
+                self.segments.append((p_vaddr, p_offset, p_filesz))
+
+    def cstring(self, addr):
+        for vaddr, offset, size in self.segments:
+            if vaddr <= addr < vaddr + size:
+                start = offset + addr - vaddr
+                end = self.data.index(b"\0", start, offset + size)
+                return self.data[start:end].decode("latin-1")
+        return None
+
+
+def format_record(fmt, args):
+    args = list(args)
+
+    def take():
+        return args.pop(0) if args else 0
+
+    def repl(m):
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        value = take()
+        if length == "ll":
+            value |= take() << 32
+        bits = 64 if length == "ll" else 32
+        if conv in "di" and value >= 1 << (bits - 1):
+            value -= 1 << bits
+        if conv == "c":
+            return chr(value & 0xFF)
+        if conv == "p":
+            return "0x%08x" % value
+        spec = "%" + flags + width + ("." + prec if prec else "") + ("d" if conv in "diu" else conv)
+        return spec % value
+
+    return SPEC_RE.sub(repl, fmt)
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__ or "Usage: binlog_decode.py firmware.elf [log]", file=sys.stderr)
+        return 1
+
+    elf = Elf32(sys.argv[1])
+    src = open(sys.argv[2], errors="replace") if len(sys.argv) > 2 else sys.stdin
+
+    for line in src:
+        m = BLG_RE.search(line)
+        if not m:
+            sys.stdout.write(line)
+            continue
+        words = [int(m.group(1)[i:i + 8], 16) for i in range(0, 48, 8)]
+        tm_us, pfmt, args = words[0], words[1], words[2:]
+        fmt = elf.cstring(pfmt)
+        if fmt is None:
+            text = "<unknown format 0x%08x> %s" % (pfmt, " ".join("%08x" % a for a in args))
+        else:
+            text = format_record(fmt, args)
+        print("%s[%11.6f] %s" % (line[:m.start()], tm_us / 1e6, text))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
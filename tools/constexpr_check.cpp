@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  constexpr_check.cpp - Host check of the constexpr FT8/FT4 encoder.
+//
+//  DESCRIPTION
+//      Builds ft8/encode_constexpr.hpp, so its reference static_asserts
+//      are compiled, and compares it against the C library of the
+//      firmware: every combination of the callsigns and third tokens
+//      below is packed by both, ftx_message_encode() + ft8_encode() /
+//      ft4_encode() and ft8::pack() + ft8::encode_payload*().
+//
+//      A message the constexpr packer accepts must encode to the same
+//      payload and tones, and must be a standard one (i3 1 or 2) for the
+//      C library too. Third tokens which are neither a grid nor a report
+//      must be rejected, though message.c packs them as some report;
+//      other rejected messages are counted only.
+//
+//  HOWTOSTART
+//      cc -O2 -I. -c ft8/message.c ft8/text.c ft8/encode.c ft8/crc.c
+//         ft8/constants.c
+//      g++ -std=c++17 -O2 -I. -o constexpr_check tools/constexpr_check.cpp
+//         message.o text.o encode.o crc.o constants.o
+//      ./constexpr_check
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <ft8/encode_constexpr.hpp>
+#include <ft8/message.h>
+#include <ft8/encode.h>
+#include <ft8/constants.h>
+
+static const char* kCallsTo[] = {
+    "CQ", "QRZ", "DE", "K1ABC", "W9XYZ", "VU3CER", "K1ABC/R", "W9XYZ/P", "3DA0XYZ",
+    "3XA0XY", "G4ABC", "A0XYZ", "PJ4/K1ABC", "KH1/KH7Z"
+};
+static const char* kCallsDe[] = {
+    "K1TE", "W9XYZ", "VU3CER", "R2BDY", "K1ABC/R", "G4ABC/P", "3DA0XYZ", "3XA0XY",
+    "A0XYZ", "ZL/K1ABC", "KH1/KH7Z", "CQ"
+};
+static const char* kExtras[] = {
+    "", "FN42", "MK68", "AA00", "RR99", "JO22", "KO85", "RRR", "RR73", "73",
+    "-30", "-12", "-1", "+0", "+05", "+10", "+99", "R-30", "R-12", "R+05", "R+99"
+};
+// message.c packs these as reports, the constexpr packer rejects them
+static const char* kBadExtras[] = { "FN4", "FN42AB", "SR00", "-31", "R-45", "12", "+123", "ABC", "R" };
+
+static_assert(ft8::detail::packgrid("FN4") < 0, "not a grid");
+static_assert(ft8::detail::packgrid("-31") < 0, "would alias RRR..73");
+static_assert(ft8::detail::packgrid("R+05") == ((32400 + 35 + 5) | 0x8000), "R+05");
+
+static int nchecked = 0, nfailed = 0;
+
+static void Fail(const std::string& message, const char* what)
+{
+    ++nfailed;
+    if (nfailed <= 20)
+        printf("FAIL \"%s\": %s\n", message.c_str(), what);
+}
+
+/// Checks a message which is expected to be packed, or rejected if bad.
+/// Returns 1 if the constexpr packer accepted it.
+static int CheckMessage(const std::string& message, bool bad)
+{
+    ++nchecked;
+
+    ft8::payload_t payload{};
+    const char* error = ft8::detail::pack_standard(message, payload);
+    if (bad)
+    {
+        if (!error)
+            Fail(message, "bad third token accepted");
+        return 0;
+    }
+    if (error)
+        return 0;
+
+    ftx_message_t msg;
+    ftx_message_init(&msg);
+    if (ftx_message_encode(&msg, NULL, message.c_str()) != FTX_MESSAGE_RC_OK)
+    {
+        Fail(message, "message.c can't encode it");
+        return 1;
+    }
+    const uint8_t i3 = ftx_message_get_i3(&msg);
+    if (i3 != 1 && i3 != 2)
+    {
+        Fail(message, "not a standard message for message.c");
+        return 1;
+    }
+    if (memcmp(msg.payload, payload.data(), FTX_PAYLOAD_LENGTH_BYTES))
+    {
+        Fail(message, "payload differs");
+        return 1;
+    }
+
+    uint8_t tones[FT4_NN];
+    ft8_encode(msg.payload, tones);
+    const ft8::tones_t tones_ft8 = ft8::encode_payload(payload);
+    if (memcmp(tones, tones_ft8.data(), FT8_NN))
+        Fail(message, "FT8 tones differ");
+
+    ft4_encode(msg.payload, tones);
+    const ft8::tones_ft4_t tones_ft4 = ft8::encode_payload_ft4(payload);
+    if (memcmp(tones, tones_ft4.data(), FT4_NN))
+        Fail(message, "FT4 tones differ");
+
+    return 1;
+}
+
+int main()
+{
+    int naccepted = 0, nrejected = 0;
+    for (const char* call_to : kCallsTo)
+    {
+        for (const char* call_de : kCallsDe)
+        {
+            const std::string calls = std::string(call_to) + " " + call_de;
+            for (const char* extra : kExtras)
+            {
+                if (CheckMessage(*extra ? calls + " " + extra : calls, false))
+                    ++naccepted;
+                else
+                    ++nrejected;
+            }
+            for (const char* extra : kBadExtras)
+                CheckMessage(calls + " " + extra, true);
+        }
+    }
+
+    printf("accepted: %d, rejected: %d (e.g. both /P and /R)\n", naccepted, nrejected);
+    printf("checked: %d, failed: %d\n", nchecked, nfailed);
+    printf("verdict: %s\n", nfailed ? "FAIL" : "PASS");
+
+    return nfailed ? 2 : 0;
+}
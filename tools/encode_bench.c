@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  encode_bench.c - Host run of the packet preparation stage timers.
+//
+//  DESCRIPTION
+//      Runs the FT8/FT4 encode path of the beacon with the same STAGE_TIMED()
+//      probes as the firmware, for comparison with the stage timers taken
+//      on target (metrics snapshot, see tools/metrics_poll.py). Durations
+//      are printed in ns.
+//
+//  HOWTOSTART
+//      cc -O2 -DSTAGE_TIMER_HOST -I. -o encode_bench tools/encode_bench.c
+//         debug/stagetimer.c ft8/message.c ft8/text.c ft8/encode.c
+//         ft8/constants.c ft8/crc.c
+//      ./encode_bench [iterations [message]]
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "debug/stagetimer.h"
+#include "ft8/message.h"
+#include "ft8/encode.h"
+#include "ft8/constants.h"
+
+int main(int argc, char **argv)
+{
+    const int n = argc > 1 ? atoi(argv[1]) : 10000;
+    const char *pmessage = argc > 2 ? argv[2] : NULL;
+
+    uint8_t tones[FT8_NN];
+    char message[32];
+    unsigned checksum = 0;
+
+    for(int i = 0; i < n; ++i)
+    {
+        /* Same as the beacon: the grid follows the battery level. */
+        STAGE_TIMED(STAGE_CREATE_PACKET)
+        {
+            STAGE_TIMED(STAGE_MESSAGE_FORMAT)
+            {
+                if(pmessage)
+                {
+                    snprintf(message, sizeof(message), "%s", pmessage);
+                }
+                else
+                {
+                    snprintf(message, sizeof(message), "CQ VU3CER MK%02d", 68 - i % 6);
+                }
+            }
+
+            ftx_message_t msg;
+            STAGE_TIMED(STAGE_MESSAGE_ENCODE)
+            {
+                ftx_message_encode(&msg, NULL, message);
+            }
+
+            STAGE_TIMED(STAGE_TONE_ENCODE)
+            {
+                ft8_encode(msg.payload, tones);
+            }
+        }
+        checksum += tones[i % FT8_NN];
+    }
+
+    printf("%d iterations, checksum %u\n", n, checksum);
+    printf("%-16s %10s %10s %10s\n", "stage", "min", "max", "last");
+    for(int i = 0; i < STAGE_COUNT; ++i)
+    {
+        const StageTimerStats *ps = StageTimerGet(i);
+        if(ps->_u32_count)
+        {
+            printf("%-16s %10u %10u %10u " STAGE_TIMER_UNIT "\n", StageTimerName(i),
+                   ps->_u32_min, ps->_u32_max, ps->_u32_last);
+        }
+    }
+
+    return 0;
+}
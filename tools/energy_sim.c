@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  energy_sim.c - Host simulation of EnergyBudget policy.
+//
+//  DESCRIPTION
+//      Replays a recorded VSYS trace through EnergyBudget module exactly
+//      as the firmware does and reports power levels, time spent in each
+//      of them and a count of transmissions the schedule would allow.
+//      Use it to tune EB_* thresholds against real days of solar charge.
+//
+//  HOWTOSTART
+//      cc -O2 -DENERGY_BUDGET_HOST -IEnergyBudget -o energy_sim
+//         tools/energy_sim.c EnergyBudget/EnergyBudget.c
+//      ./energy_sim trace.csv [base_skip] [slot_s] [slot_step]
+//
+//      Thresholds are overridden the same way, e.g. -DEB_SOC_LOW_PCT=60.
+//      Trace is CSV of `seconds,volts` lines, `#` starts a comment.
+//      slot_step is 2 for an even or odd slot parity, else 1.
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <EnergyBudget.h>
+
+static const char *skLevelName[] = { "CRITICAL", "LOW", "NORMAL" };
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "Usage: %s trace.csv [base_skip] [slot_s] [slot_step]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[1], "r");
+    if(!f)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    const int base_skip = argc > 2 ? atoi(argv[2]) : 5;
+    const int slot_step = argc > 4 ? atoi(argv[4]) : 1;
+    /* Eligible slots only, the skip counts them. */
+    const double slot_s = (argc > 3 ? atof(argv[3]) : 15.) * slot_step;
+
+    EnergyBudgetContext *pEB = EnergyBudgetInit((uint8_t)base_skip, (uint8_t)slot_step, 1);
+
+    double level_s[3] = { 0 };
+    double tx_count = 0., last_t = -1.;
+    int min_soc = 100, level = -1;
+
+    char line[128];
+    while(fgets(line, sizeof(line), f))
+    {
+        double t, v;
+        if('#' == line[0] || 2 != sscanf(line, "%lf,%lf", &t, &v))
+        {
+            continue;
+        }
+
+        const uint64_t u64_t_us = (uint64_t)(t * 1e6);
+        if(!EnergyBudgetIsDue(pEB, u64_t_us))
+        {
+            continue;
+        }
+
+        /* The level chosen at the previous sample rules till this one. */
+        if(last_t >= 0.)
+        {
+            const double dt = t - last_t;
+            level_s[pEB->_u8_level] += dt;
+            tx_count += dt / (slot_s * (EnergyBudgetSlotSkip(pEB) + 1));
+        }
+        last_t = t;
+
+        EnergyBudgetUpdate(pEB, u64_t_us, (uint32_t)(v * 1000. + .5));
+        if(pEB->_u8_soc_pct < min_soc)
+        {
+            min_soc = pEB->_u8_soc_pct;
+        }
+
+        if(level != pEB->_u8_level)
+        {
+            level = pEB->_u8_level;
+            printf("%9.0f s  %5.3f V  soc:%3u%%  rate:%5ld mV/h  -> %-8s skip:%u aux:%u\n",
+                   t, v, pEB->_u8_soc_pct, (long)pEB->_i32_rate_mv_h, skLevelName[level],
+                   EnergyBudgetSlotSkip(pEB), EnergyBudgetMaxAux(pEB));
+        }
+    }
+    fclose(f);
+
+    const double total_s = level_s[0] + level_s[1] + level_s[2];
+    if(total_s <= 0.)
+    {
+        printf("Not enough samples.\n");
+        return 1;
+    }
+
+    printf("\n");
+    for(int i = 2; i >= 0; --i)
+    {
+        printf("%-8s %10.0f s  %5.1f%%\n", skLevelName[i], level_s[i], 100. * level_s[i] / total_s);
+    }
+    printf("transmissions: %.0f (%.0f at fixed schedule), min soc: %d%%\n",
+           tx_count, total_s / (slot_s * (base_skip + 1)), min_soc);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  freetext_check.c - Checks & times FT8/FT4 free text packing on host.
+//
+//  DESCRIPTION
+//      Packs random texts of every length 0..13 over the whole 42 chars
+//      alphabet, plus the all-zero and the all-`?` extremes, with
+//      ftx_message_encode_free(). Checks that ftx_message_decode_free()
+//      gives the text back and that the bits are the same as of the former
+//      byte-wise base-42 packer, kept here as a reference. Then times both
+//      packers per message.
+//
+//  HOWTOSTART
+//      cc -O2 -I. -o freetext_check tools/freetext_check.c ft8/message.c
+//         ft8/text.c
+//      ./freetext_check [iterations]
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ft8/message.h"
+#include "ft8/text.h"
+
+static const char skAlphabet[] = " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ+-./?";
+
+/// @brief The byte-wise packer, one multiply & carry loop per char.
+static void PackBytewise(const char *text, uint8_t *b77)
+{
+    int length = strlen(text);
+    while(*text == ' ')
+    {
+        ++text;
+        --length;
+    }
+    while(length > 0 && text[length - 1] == ' ')
+    {
+        --length;
+    }
+
+    memset(b77, 0, 10);
+    for(int j = 0; j < 13; ++j)
+    {
+        uint16_t x = 0;
+        for(int i = 8; i >= 0; --i)
+        {
+            x += b77[i] * (uint16_t)42;
+            b77[i] = x & 0xFF;
+            x >>= 8;
+        }
+
+        const int q = j < length ? nchar(text[j], FT8_CHAR_TABLE_FULL) : 0;
+        x = (q > 0 ? q : 0) << 1;
+        for(int i = 8; i >= 0 && x; --i)
+        {
+            x += b77[i];
+            b77[i] = x & 0xFF;
+            x >>= 8;
+        }
+    }
+    b77[8] &= 0xFE;
+}
+
+/// @brief Trims outer spaces as the packers do.
+static const char *Trimmed(const char *text, char *pbuf)
+{
+    while(' ' == *text)
+    {
+        ++text;
+    }
+    strcpy(pbuf, text);
+    for(int n = strlen(pbuf); n > 0 && ' ' == pbuf[n - 1]; --n)
+    {
+        pbuf[n - 1] = '\0';
+    }
+
+    return pbuf;
+}
+
+static double NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    const int n = argc > 1 ? atoi(argv[1]) : 200000;
+
+    static char texts[4096][14];
+    const int ntexts = sizeof(texts) / sizeof(texts[0]);
+    srand(1);
+    for(int i = 0; i < ntexts; ++i)
+    {
+        const int len = i % 14;
+        for(int j = 0; j < len; ++j)
+        {
+            texts[i][j] = skAlphabet[rand() % 42];
+        }
+        texts[i][len] = '\0';
+    }
+    strcpy(texts[0], "0000000000000");
+    strcpy(texts[1], "?????????????");
+
+    int nchecked = 0, nfailed = 0;
+    for(int i = 0; i < ntexts; ++i)
+    {
+        ftx_message_t msg;
+        uint8_t ref[10];
+        char decoded[16], expect[16];
+        ftx_message_init(&msg);
+        const int rc = ftx_message_encode_free(&msg, texts[i]);
+        PackBytewise(texts[i], ref);
+        ftx_message_decode_free(&msg, decoded);
+        Trimmed(texts[i], expect);
+
+        ++nchecked;
+        if(rc || memcmp(msg.payload, ref, sizeof(ref)) || strcmp(decoded, expect)
+           || FTX_MESSAGE_TYPE_FREE_TEXT != ftx_message_get_type(&msg))
+        {
+            if(++nfailed <= 10)
+            {
+                printf("'%s': rc %d, decoded '%s'\n", texts[i], rc, decoded);
+            }
+        }
+    }
+
+    /* Too long or not in the alphabet. */
+    const char *skBad[] = { "ABCDEFGHIJKLMN", "HELLO, WORLD", "lower" };
+    for(size_t i = 0; i < sizeof(skBad) / sizeof(skBad[0]); ++i)
+    {
+        ftx_message_t msg;
+        ++nchecked;
+        if(FTX_MESSAGE_RC_OK == ftx_message_encode_free(&msg, skBad[i]))
+        {
+            printf("'%s': accepted\n", skBad[i]);
+            ++nfailed;
+        }
+    }
+
+    unsigned checksum = 0;
+    double t = NowNs();
+    for(int i = 0; i < n; ++i)
+    {
+        ftx_message_t msg;
+        ftx_message_encode_free(&msg, texts[i % ntexts]);
+        checksum += msg.payload[i % 9];
+    }
+    const double ns_words = (NowNs() - t) / n;
+
+    t = NowNs();
+    for(int i = 0; i < n; ++i)
+    {
+        uint8_t b77[10];
+        PackBytewise(texts[i % ntexts], b77);
+        checksum += b77[i % 9];
+    }
+    const double ns_bytes = (NowNs() - t) / n;
+
+    printf("checked: %d, failed: %d\n", nchecked, nfailed);
+    printf("per message: 64-bit words %.1f ns, byte-wise %.1f ns (checksum %u)\n",
+           ns_words, ns_bytes, checksum);
+    printf("verdict: %s\n", nfailed ? "FAIL" : "PASS");
+
+    return nfailed ? 2 : 0;
+}
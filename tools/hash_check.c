@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  hash_check.c - Checks the FT8/FT4 callsign hash table on host.
+//
+//  DESCRIPTION
+//      Resolves hashed calls of Type 1 and Type 4 messages through
+//      ftx_hash_table_if, checks eviction of the least recently used call
+//      of a full probe window, then runs writer threads saving calls while
+//      reader threads look them up, and checks that no reader ever gets a
+//      call which doesn't belong to the hash it asked for.
+//
+//  HOWTOSTART
+//      cc -O2 -pthread -I. -o hash_check tools/hash_check.c ft8/hash_table.c
+//         ft8/message.c ft8/text.c
+//      ./hash_check [seconds]
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "ft8/message.h"
+#include "ft8/hash_table.h"
+
+#define NWRITERS 2
+#define NREADERS 4
+
+static int snChecked, snFailed;
+static atomic_int sStop;
+static atomic_long sLookups, sHits, sTorn;
+
+static void Expect(int ok, const char *pwhat)
+{
+    ++snChecked;
+    if(!ok)
+    {
+        printf("FAILED: %s\n", pwhat);
+        ++snFailed;
+    }
+}
+
+/// @brief Decodes a message with or without the table.
+static void Decode(const ftx_message_t *pmsg, ftx_callsign_hash_interface_t *phash_if, char *pdecoded)
+{
+    pdecoded[0] = '\0';
+    ftx_message_decode(pmsg, phash_if, pdecoded);
+}
+
+/// @brief One of 2048 hashes spread over the table, so that readers hit
+/// @brief entries being overwritten all the time.
+static uint32_t HashOf(uint32_t x)
+{
+    return ((x >> 21) * 2053u) & 0x3FFFFFu;
+}
+
+/// @brief A call spelling out its own hash, so a torn read is evident.
+static void CallOf(uint32_t n22, char *pcall)
+{
+    snprintf(pcall, 12, "N%06X", (unsigned)n22);
+}
+
+static void *Writer(void *parg)
+{
+    uint32_t x = (uint32_t)(uintptr_t)parg * 2654435761u + 1;
+    char call[12];
+    while(!atomic_load(&sStop))
+    {
+        x = x * 1664525u + 1013904223u;
+        const uint32_t n22 = HashOf(x);
+        CallOf(n22, call);
+        ftx_hash_table_save(call, n22);
+    }
+
+    return NULL;
+}
+
+static void *Reader(void *parg)
+{
+    uint32_t x = (uint32_t)(uintptr_t)parg * 40503u + 7;
+    char call[12], expect[12];
+    long nlookups = 0, nhits = 0, ntorn = 0;
+    while(!atomic_load(&sStop))
+    {
+        x = x * 1664525u + 1013904223u;
+        const uint32_t n22 = HashOf(x);
+        ++nlookups;
+        if(ftx_hash_table_lookup(FTX_CALLSIGN_HASH_22_BITS, n22, call))
+        {
+            ++nhits;
+            CallOf(n22, expect);
+            ntorn += !!strcmp(call, expect);
+        }
+        /* 12-bit lookups may find any call with the same top bits. */
+        if(ftx_hash_table_lookup(FTX_CALLSIGN_HASH_12_BITS, n22 >> 10, call))
+        {
+            const uint32_t found = (uint32_t)strtoul(call + 1, NULL, 16);
+            CallOf(found, expect);
+            ntorn += (found >> 10 != n22 >> 10) || strcmp(call, expect);
+        }
+    }
+    atomic_fetch_add(&sLookups, nlookups);
+    atomic_fetch_add(&sHits, nhits);
+    atomic_fetch_add(&sTorn, ntorn);
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    const int seconds = argc > 1 ? atoi(argv[1]) : 2;
+    char decoded[40], call[12];
+
+    /* Hashed calls are resolved once the call has been seen. */
+    ftx_message_t msg;
+    ftx_message_encode(&msg, &ftx_hash_table_if, "CQ PJ4/K1ABC");
+    Decode(&msg, NULL, decoded);
+    Expect(!strcmp(decoded, "CQ <...> "), "Type 1 without table");
+    Decode(&msg, &ftx_hash_table_if, decoded);
+    Expect(!strcmp(decoded, "CQ <PJ4/K1ABC> "), "Type 1, 22-bit hash");
+
+    ftx_message_encode_nonstd(&msg, NULL, "W9XYZ", "PJ4/K1ABC", "RR73");
+    Decode(&msg, &ftx_hash_table_if, decoded);
+    Expect(!strcmp(decoded, "<...> PJ4/K1ABC RR73"), "Type 4, call not seen");
+    ftx_message_encode_nonstd(&msg, &ftx_hash_table_if, "W9XYZ", "PJ4/K1ABC", "RR73");
+    Decode(&msg, &ftx_hash_table_if, decoded);
+    Expect(!strcmp(decoded, "<W9XYZ> PJ4/K1ABC RR73"), "Type 4, 12-bit hash");
+
+    /* A full window evicts the least recently saved or found call. */
+    ftx_hash_table_clear();
+    const uint32_t home = 5u << (22 - FTX_HASH_TABLE_BITS);
+    for(uint32_t i = 0; i < FTX_HASH_TABLE_PROBES; ++i)
+    {
+        CallOf(home + i, call);
+        ftx_hash_table_save(call, home + i);
+    }
+    Expect(ftx_hash_table_lookup(FTX_CALLSIGN_HASH_22_BITS, home, call), "full window lookup");
+    CallOf(home + 100, call);
+    ftx_hash_table_save(call, home + 100);
+    Expect(ftx_hash_table_lookup(FTX_CALLSIGN_HASH_22_BITS, home, call), "recently found call kept");
+    Expect(!ftx_hash_table_lookup(FTX_CALLSIGN_HASH_22_BITS, home + 1, call), "oldest call evicted");
+    char expect[12];
+    CallOf(home + 100, expect);
+    Expect(ftx_hash_table_lookup(FTX_CALLSIGN_HASH_22_BITS, home + 100, call) && !strcmp(call, expect),
+           "new call stored");
+
+    /* Lock-free reads against concurrent saves. */
+    ftx_hash_table_clear();
+    pthread_t threads[NWRITERS + NREADERS];
+    for(int i = 0; i < NWRITERS + NREADERS; ++i)
+    {
+        pthread_create(&threads[i], NULL, i < NWRITERS ? Writer : Reader, (void *)(uintptr_t)(i + 1));
+    }
+    sleep(seconds);
+    atomic_store(&sStop, 1);
+    for(int i = 0; i < NWRITERS + NREADERS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    Expect(!atomic_load(&sTorn), "no torn reads");
+
+    printf("concurrent: %ld lookups, %ld hits, %ld torn\n", atomic_load(&sLookups),
+           atomic_load(&sHits), atomic_load(&sTorn));
+    printf("checked: %d, failed: %d\n", snChecked, snFailed);
+    printf("verdict: %s\n", snFailed ? "FAIL" : "PASS");
+
+    return snFailed ? 2 : 0;
+}
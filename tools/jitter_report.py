@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+#
+# jitter_report.py - Summarizes TxChannel symbol timing jitter.
+#
+# Reads the beacon console log (a file or stdin) and collects the
+# `TXJ>` lines printed by TxChannelDumpJitter() after each transmission.
+# Prints a per-frame table and the worst case over the whole log, and
+# checks it against the FT8 decoder timing tolerance.
+#
+# Usage:
+#     ./tools/jitter_report.py minicom.log
+#     cat /dev/ttyACM0 | ./tools/jitter_report.py
+#
+import re
+import sys
+
+# WSJT-X tolerates a few tens of ms of frame DT, symbol-to-symbol jitter
+# must stay much lower than that. 1 ms is a conservative budget.
+FT8_JITTER_BUDGET_US = 1000
+
+TXJ_RE = re.compile(
+    r"TXJ> n:(\d+) min:(\d+) mean:([\d.]+) max:(\d+) p99:(\d+) miss:(\d+)"
+    r"(?: start:(-?\d+|-))?")
+
+
+def main():
+    src = open(sys.argv[1], errors="replace") if len(sys.argv) > 1 else sys.stdin
+
+    frames = []
+    for line in src:
+        m = TXJ_RE.search(line)
+        if m:
+            n, lo, mean, hi, p99, miss, start = m.groups()
+            # No start error when the frame wasn't armed to a time.
+            frames.append((int(n), int(lo), float(mean), int(hi), int(p99), int(miss),
+                           None if start in (None, "-") else int(start)))
+
+    if not frames:
+        print("No TXJ> records found.")
+        return 1
+
+    print("frame  symbols  min,us  mean,us  max,us  p99,us  missed  start,us")
+    for i, (n, lo, mean, hi, p99, miss, start) in enumerate(frames):
+        print("%5d  %7d  %6d  %7.1f  %6d  %6d  %6d  %8s" % (i, n, lo, mean, hi, p99, miss,
+                                                             "-" if start is None else start))
+
+    total = sum(f[0] for f in frames)
+    worst = max(f[3] for f in frames)
+    worst_p99 = max(f[4] for f in frames)
+    missed = sum(f[5] for f in frames)
+    mean = sum(f[0] * f[2] for f in frames) / total if total else 0.0
+    worst_start = max((abs(f[6]) for f in frames if f[6] is not None), default=0)
+
+    print("")
+    print("frames: %d, symbols: %d" % (len(frames), total))
+    print("mean: %.1f us, worst p99: %d us, worst max: %d us, missed: %d"
+          % (mean, worst_p99, worst, missed))
+    print("worst slot start error: %d us" % worst_start)
+
+    ok = worst < FT8_JITTER_BUDGET_US and missed == 0 and worst_start < FT8_JITTER_BUDGET_US
+    print("verdict: %s (budget %d us)" % ("PASS" if ok else "FAIL", FT8_JITTER_BUDGET_US))
+    return 0 if ok else 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
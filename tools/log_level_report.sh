@@ -0,0 +1,48 @@
+#!/bin/bash
+#
+# log_level_report.sh - Image size at every compile-time log level.
+#
+# Builds the firmware once per LOG_LEVEL in scratch build directories and
+# prints flash (text + data) and RAM (data + bss) usage, the savings against
+# LOG_LEVEL=DEBUG and the code size of the FT8 encode path functions, which
+# shrinks as the log calls in it get compiled out. Cycles of the encode path
+# are measured on target, the beacon prints them itself.
+#
+# Usage:
+#     ./tools/log_level_report.sh [extra cmake args...]
+#     ./tools/log_level_report.sh -DTXCHANNEL_DMA_BACKEND=ON
+#
+# Needs PICO_SDK_PATH and arm-none-eabi toolchain, as the normal build.
+#
+set -e
+
+SRC=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${LOG_REPORT_DIR:-$SRC/_log_report}
+ELF=pico-wspr-tx.elf
+LEVELS="DEBUG INFO WARN ERROR NONE"
+ENCODE_PATH="ft8_encode_top WSPRbeaconCreatePacket WSPRbeaconTxScheduler ftx_message_encode ft8_encode"
+
+for level in $LEVELS; do
+    cmake -S "$SRC" -B "$OUT/$level" -DLOG_LEVEL=$level -DLOG_LEVEL_FT8=$level "$@" > /dev/null
+    cmake --build "$OUT/$level" -j"$(nproc)" > /dev/null
+done
+
+base_flash=
+base_ram=
+printf "%-6s %9s %9s %9s %9s %12s\n" level flash "d.flash" ram "d.ram" "encode path"
+for level in $LEVELS; do
+    read -r text data bss <<< "$(arm-none-eabi-size -B "$OUT/$level/$ELF" | awk 'NR == 2 { print $1, $2, $3 }')"
+    flash=$((text + data))
+    ram=$((data + bss))
+    : ${base_flash:=$flash}
+    : ${base_ram:=$ram}
+
+    encode=0
+    for sym in $ENCODE_PATH; do
+        size=$(arm-none-eabi-nm -S "$OUT/$level/$ELF" | awk -v s=$sym '$4 == s { print strtonum("0x" $2) }')
+        encode=$((encode + ${size:-0}))
+    done
+
+    printf "%-6s %9d %9d %9d %9d %12d\n" $level $flash $((flash - base_flash)) \
+           $ram $((ram - base_ram)) $encode
+done
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+#
+# metrics_poll.py - Polls runtime metrics of a fleet of beacons.
+#
+# Opens every given USB CDC port, fetches the metrics schema once and then
+# a binary snapshot (see Metrics/Metrics.c) every interval. Prints the
+# values per beacon and the fleet aggregate: counters are summed, gauges
+# shown as min/mean/max, histograms merged. Console text which the beacon
+# prints in between is skipped. Beacons are told apart by port, shown as
+# node@port, since the node name is the callsign.
+#
+# Usage:
+#     ./tools/metrics_poll.py [-i seconds] [-n count] [--json] PORT...
+#     ./tools/metrics_poll.py -n 1 /dev/ttyACM0 /dev/ttyACM1
+#
+# Needs pyserial.
+#
+import argparse
+import json
+import struct
+import sys
+import time
+
+import serial
+
+SYNC = 0xA5
+VERSION = 1
+CMD_SNAPSHOT = b"m"
+CMD_SCHEMA = b"M"
+HIST_BINS = 12
+KIND_COUNTER, KIND_GAUGE, KIND_HISTOGRAM, KIND_TIMER = 0, 1, 2, 3
+REPLY_TIMEOUT_S = 2.0
+
+
+def fletcher16(data):
+    a = b = 0
+    for c in data:
+        a = (a + c) % 255
+        b = (b + a) % 255
+    return b << 8 | a
+
+
+class Beacon:
+    def __init__(self, port):
+        self.port = port
+        self.ser = serial.Serial(port, 115200, timeout=0.1)
+        self.node = port
+        self.schema = None
+
+    def request(self, cmd):
+        """Sends a request byte and returns the payload of the reply."""
+        self.ser.reset_input_buffer()
+        self.ser.write(cmd)
+        deadline = time.monotonic() + REPLY_TIMEOUT_S
+        buf = b""
+        while time.monotonic() < deadline:
+            buf += self.ser.read(256)
+            while True:
+                i = buf.find(bytes([SYNC, VERSION, cmd[0]]))
+                if i < 0:
+                    buf = buf[-2:]
+                    break
+                if len(buf) < i + 5:
+                    break
+                length, = struct.unpack_from("<H", buf, i + 3)
+                if len(buf) < i + 5 + length + 2:
+                    break
+                payload = buf[i + 5:i + 5 + length]
+                check, = struct.unpack_from("<H", buf, i + 5 + length)
+                if check == fletcher16(payload):
+                    return payload
+                # A sync pattern inside console text, look further.
+                buf = buf[i + 1:]
+        raise TimeoutError("%s: no reply to %r" % (self.port, cmd))
+
+    def fetch_schema(self):
+        p = self.request(CMD_SCHEMA)
+        n = p[0]
+        self.node = p[1:1 + n].decode("ascii", "replace") or self.port
+        pos = 1 + n
+        count = p[pos]
+        pos += 1
+        self.schema = []
+        for _ in range(count):
+            kind, shift, n = p[pos], p[pos + 1], p[pos + 2]
+            name = p[pos + 3:pos + 3 + n].decode("ascii", "replace")
+            pos += 3 + n
+            self.schema.append((name, kind, shift))
+
+    def fetch_snapshot(self):
+        if self.schema is None:
+            self.fetch_schema()
+        p = self.request(CMD_SNAPSHOT)
+        uptime, count = struct.unpack_from("<IB", p, 0)
+        if count != len(self.schema):
+            # Reflashed with a different set of metrics.
+            self.fetch_schema()
+            return self.fetch_snapshot()
+        pos = 5
+        values = {"uptime_s": uptime}
+        for name, kind, shift in self.schema:
+            if kind == KIND_TIMER:
+                tcount, last, tmin, tmax = struct.unpack_from("<IIII", p, pos)
+                pos += 16
+                values[name] = {"count": tcount, "last": last, "min": tmin, "max": tmax}
+            elif kind == KIND_HISTOGRAM:
+                hcount, hsum, hmax = struct.unpack_from("<III", p, pos)
+                bins = list(struct.unpack_from("<%dI" % HIST_BINS, p, pos + 12))
+                pos += 12 + 4 * HIST_BINS
+                values[name] = {"count": hcount, "sum": hsum, "max": hmax,
+                                "shift": shift, "bins": bins}
+            else:
+                v, = struct.unpack_from("<i" if kind == KIND_GAUGE else "<I", p, pos)
+                pos += 4
+                values[name] = v
+        return values
+
+
+def percentile(hist, percent):
+    """Upper bound of the bin holding the percentile."""
+    total = sum(hist["bins"])
+    if not total:
+        return 0
+    acc = 0
+    for i, n in enumerate(hist["bins"]):
+        acc += n
+        if acc * 100 >= total * percent:
+            return min(1 << (hist["shift"] + i), hist["max"])
+    return hist["max"]
+
+
+def describe(value):
+    if isinstance(value, dict) and "last" in value:
+        return "n:%d last:%d min:%d max:%d us" % (
+            value["count"], value["last"], value["min"], value["max"])
+    if isinstance(value, dict):
+        mean = value["sum"] / value["count"] if value["count"] else 0
+        return "n:%d mean:%.0f p90:<=%d max:%d" % (
+            value["count"], mean, percentile(value, 90), value["max"])
+    return str(value)
+
+
+def aggregate(snapshots, schema):
+    fleet = {}
+    for name, kind, shift in schema:
+        vals = [s[name] for s in snapshots.values() if name in s]
+        if not vals:
+            continue
+        if kind == KIND_COUNTER:
+            fleet[name] = str(sum(vals))
+        elif kind == KIND_GAUGE:
+            fleet[name] = "min:%d mean:%.1f max:%d" % (min(vals), sum(vals) / len(vals), max(vals))
+        elif kind == KIND_TIMER:
+            seen = [v for v in vals if v["count"]]
+            fleet[name] = "min:%d max:%d us" % (
+                min((v["min"] for v in seen), default=0), max((v["max"] for v in seen), default=0))
+        else:
+            merged = {"count": sum(v["count"] for v in vals),
+                      "sum": sum(v["sum"] for v in vals),
+                      "max": max(v["max"] for v in vals),
+                      "shift": shift,
+                      "bins": [sum(b) for b in zip(*(v["bins"] for v in vals))]}
+            fleet[name] = describe(merged)
+    return fleet
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Polls beacon metrics over USB CDC.")
+    ap.add_argument("ports", nargs="+")
+    ap.add_argument("-i", "--interval", type=float, default=60.)
+    ap.add_argument("-n", "--count", type=int, default=0, help="polls, 0 - forever")
+    ap.add_argument("--json", action="store_true", help="print raw snapshots as JSON lines")
+    args = ap.parse_args()
+
+    beacons = []
+    for port in args.ports:
+        try:
+            beacons.append(Beacon(port))
+        except serial.SerialException as e:
+            print("%s: %s" % (port, e), file=sys.stderr)
+    if not beacons:
+        return 1
+
+    npoll = 0
+    while True:
+        snapshots = {}
+        for b in beacons:
+            try:
+                values = b.fetch_snapshot()
+                # The node name is the callsign, shared by a fleet of one owner.
+                snapshots["%s@%s" % (b.node, b.port)] = values
+            except (TimeoutError, serial.SerialException) as e:
+                print(e, file=sys.stderr)
+
+        stamp = time.strftime("%Y-%m-%d %H:%M:%S")
+        if args.json:
+            print(json.dumps({"time": stamp, "beacons": snapshots}), flush=True)
+        elif snapshots:
+            schema = next(b.schema for b in beacons if b.schema)
+            print("=== %s, %d of %d beacons" % (stamp, len(snapshots), len(beacons)))
+            for node, values in snapshots.items():
+                print("%s (up %d s)" % (node, values["uptime_s"]))
+                for name, value in values.items():
+                    if name != "uptime_s":
+                        print("    %-16s %s" % (name, describe(value)))
+            if len(snapshots) > 1:
+                print("fleet")
+                for name, text in aggregate(snapshots, schema).items():
+                    print("    %-16s %s" % (name, text))
+            sys.stdout.flush()
+
+        npoll += 1
+        if args.count and npoll >= args.count:
+            return 0
+        time.sleep(args.interval)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
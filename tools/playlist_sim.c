@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  playlist_sim.c - Host simulation of a day of Playlist scheduling.
+//
+//  DESCRIPTION
+//      Loads a playlist config (see Playlist/Playlist.h) and runs it over
+//      the TX slots of one UTC day, with the same slot selection as
+//      WSPRbeaconIsTxSlot(). Prints the timeline, then per message a count
+//      of sends and its share of TX slots, and how many TX slots had no
+//      eligible message.
+//
+//  HOWTOSTART
+//      cc -O2 -DPLAYLIST_HOST -IPlaylist -o playlist_sim
+//         tools/playlist_sim.c Playlist/Playlist.c
+//      ./playlist_sim config.txt [slot_s [skip [any|even|odd]]]
+//
+//      slot_s is 15 for FT8, 7 for FT4 (7.5 s rounded down); skip and
+//      parity are the beacon's own TX slot rules, defaults 0 and `any`.
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Playlist.h>
+
+#define DAY_S   86400UL
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s config [slot_s [skip [any|even|odd]]]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[1], "r");
+    if(!f)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    const unsigned long slot_s = argc > 2 ? strtoul(argv[2], NULL, 10) : 15;
+    const unsigned long skip = argc > 3 ? strtoul(argv[3], NULL, 10) : 0;
+    const int parity = argc < 5 || !strcmp(argv[4], "any") ? PLAYLIST_PARITY_ANY
+                       : !strcmp(argv[4], "even") ? PLAYLIST_PARITY_EVEN : PLAYLIST_PARITY_ODD;
+    if(!slot_s)
+    {
+        fprintf(stderr, "bad slot length\n");
+        return 1;
+    }
+
+    PlaylistContext *pPL = PlaylistInit();
+    char line[128];
+    for(int n = 1; fgets(line, sizeof(line), f); ++n)
+    {
+        if(PlaylistParseLine(pPL, line))
+        {
+            fprintf(stderr, "%s:%d: bad line: %s", argv[1], n, line);
+            return 1;
+        }
+    }
+    fclose(f);
+    if(!pPL->_u8_nentries)
+    {
+        fprintf(stderr, "no messages\n");
+        return 1;
+    }
+
+    /* A day from midnight UTC of some date, as slots from unix epoch. */
+    const uint64_t u64_first = 1700006400ULL / slot_s;
+    const uint64_t u64_nslots = DAY_S / slot_s;
+    PlaylistReset(pPL, u64_first);
+
+    unsigned long ntx = 0, nidle = 0;
+    for(uint64_t s = u64_first; s < u64_first + u64_nslots; ++s)
+    {
+        /* WSPRbeaconIsTxSlot(). */
+        if((PLAYLIST_PARITY_EVEN == parity && (s & 1)) || (PLAYLIST_PARITY_ODD == parity && !(s & 1)))
+        {
+            continue;
+        }
+        if((PLAYLIST_PARITY_ANY == parity ? s : s >> 1) % (skip + 1))
+        {
+            continue;
+        }
+
+        ++ntx;
+        const unsigned long t = (unsigned long)(s - u64_first) * slot_s;
+        const PlaylistEntry *pe = PlaylistNext(pPL, s);
+        if(!pe)
+        {
+            ++nidle;
+            printf("%02lu:%02lu:%02lu %6llu %10s -\n", t / 3600, t / 60 % 60, t % 60,
+                   (unsigned long long)s, "");
+            continue;
+        }
+
+        const uint32_t freq = PlaylistFreqHz(pPL, pe);
+        char fbuf[16] = "default";
+        if(freq)
+        {
+            snprintf(fbuf, sizeof(fbuf), "%lu", (unsigned long)freq);
+        }
+        printf("%02lu:%02lu:%02lu %6llu %10s %s\n", t / 3600, t / 60 % 60, t % 60,
+               (unsigned long long)s, fbuf, pe->_pc_text);
+    }
+
+    printf("\n%lu TX slots of %lu s, %lu idle\n", ntx, slot_s, nidle);
+    for(uint8_t i = 0; i < pPL->_u8_nentries; ++i)
+    {
+        const PlaylistEntry *pe = &pPL->_pEntries[i];
+        printf("%2u p%-3u w%-3u %6lu %5.1f%%  %s\n", i, pe->_u8_priority, pe->_u8_weight,
+               (unsigned long)pe->_u32_nsent, ntx ? 100. * pe->_u32_nsent / ntx : 0., pe->_pc_text);
+    }
+
+    return 0;
+}
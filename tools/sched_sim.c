@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  sched_sim.c - Host simulation of a week of FT8/FT4 TX slot scheduling.
+//
+//  DESCRIPTION
+//      Runs the slot rules of the beacon (WSPRbeacon/TxSlot.c) against a
+//      simulated GPS receiver and Pico clock: PPS edges on every UTC
+//      second, an NMEA sentence of that second some 300..600 ms later,
+//      uptime running off a crystal with a constant error.
+//
+//      As the beacon does, the next TX slot is searched for when a frame
+//      starts, using the GPS time reference of that moment. A TX is a
+//      hit when it goes in the next eligible slot (by true UTC) and its
+//      first symbol starts within the budget of the slot edge, else it is
+//      a miss. Reported per mode, parity and skip, with the start error.
+//
+//      Both PPS+NMEA and NMEA-only receivers are simulated; the verdict
+//      is of the PPS one, NMEA-only timing is as good as its latency.
+//
+//  HOWTOSTART
+//      cc -O2 -DWSPR_SLOT_HOST -IWSPRbeacon -o sched_sim
+//         tools/sched_sim.c WSPRbeacon/TxSlot.c
+//      ./sched_sim [crystal_ppm [budget_ms]]
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <TxSlot.h>
+
+#define WEEK_US             (7ULL * 86400ULL * 1000000ULL)
+#define EPOCH_S             1760000000ULL       /* Start of the simulation, unix. */
+#define BOOT_S              (EPOCH_S - 3600)    /* Uptime 0 of the Pico. */
+#define LEAD_US             1000000ULL          /* WSPR_PREPARE_LEAD_US */
+#define TX_OFFSET_MS        0
+#define PPS_JITTER_US       1
+#define NMEA_DELAY_MIN_MS   300
+#define NMEA_DELAY_SPAN_MS  300
+
+static const uint8_t kSkips[] = { 0, 1, 2, 3, 4, 7, 15, 59, 239 };
+static const char *kParityName[] = { "any", "even", "odd" };
+
+typedef struct
+{
+    int64_t _i64_ppb;                   /* Crystal error, uptime runs fast if > 0. */
+    int _pps;                           /* Receiver has PPS output. */
+
+} SimClock;
+
+/// @brief Uptime of a true time, us.
+static uint64_t Uptime(const SimClock *pclk, uint64_t u64_true_us)
+{
+    const int64_t d = (int64_t)(u64_true_us - BOOT_S * 1000000ULL);
+    return (uint64_t)(d + d * pclk->_i64_ppb / 1000000000LL);
+}
+
+/// @brief True time of an uptime, us (inverse of Uptime, to 1 us).
+static uint64_t TrueTime(const SimClock *pclk, uint64_t u64_uptime_us)
+{
+    const int64_t u = (int64_t)u64_uptime_us;
+    return BOOT_S * 1000000ULL + (uint64_t)(u - u * pclk->_i64_ppb / (1000000000LL + pclk->_i64_ppb));
+}
+
+/// @brief NMEA latency after the PPS of a second, us; fixed per second.
+static uint64_t NmeaDelay(uint64_t u64_sec)
+{
+    return (NMEA_DELAY_MIN_MS + (u64_sec * 2654435761ULL >> 7) % NMEA_DELAY_SPAN_MS) * 1000ULL;
+}
+
+/// @brief What GPStime module holds at a true time: the last PPS edge and
+/// @brief the last NMEA sentence received.
+static int GetTimeRef(const SimClock *pclk, uint64_t u64_true_us, TxSlotTimeRef *pref)
+{
+    uint64_t u64_sec = u64_true_us / 1000000ULL;
+    const uint64_t u64_pps_us = pclk->_pps
+        ? Uptime(pclk, u64_sec * 1000000ULL) + (u64_sec & 1 ? PPS_JITTER_US : 0) : 0;
+
+    uint64_t u64_nmea_sec = u64_sec;
+    if(u64_true_us < u64_sec * 1000000ULL + NmeaDelay(u64_sec))
+    {
+        --u64_nmea_sec;                 /* This second's sentence isn't in yet. */
+    }
+    const uint64_t u64_nmea_us = Uptime(pclk, u64_nmea_sec * 1000000ULL + NmeaDelay(u64_nmea_sec));
+
+    /* GPS measures the clock error to some tens of ppb. */
+    const int32_t i32_ppb = pclk->_pps ? (int32_t)pclk->_i64_ppb + (u64_sec & 1 ? 30 : -30) : 0;
+
+    return TxSlotGetTimeRef((uint32_t)u64_nmea_sec, u64_nmea_us, u64_pps_us, i32_ppb, pref);
+}
+
+typedef struct
+{
+    uint32_t _u32_ntx;
+    uint32_t _u32_hit;
+    uint32_t _u32_miss;
+    int64_t _i64_err_sum_us;
+    int64_t _i64_err_max_us;            /* Max by absolute value. */
+
+} SimResult;
+
+/// @brief Runs a week of scheduling.
+static SimResult Run(const SimClock *pclk, uint32_t u32_slot_ms, const WSPRbeaconSchedule *psched,
+                     int64_t i64_budget_us)
+{
+    SimResult r = { 0 };
+    const uint64_t u64_slot_us = u32_slot_ms * 1000ULL;
+
+    /* Power on at some moment within a slot. */
+    uint64_t u64_true_us = EPOCH_S * 1000000ULL + 4321987ULL;
+    const uint64_t u64_end_us = u64_true_us + WEEK_US;
+    while(u64_true_us < u64_end_us)
+    {
+        TxSlotTimeRef ref;
+        if(GetTimeRef(pclk, u64_true_us, &ref))
+        {
+            u64_true_us += 1000000ULL;
+            continue;
+        }
+
+        uint64_t u64_slot;
+        const uint64_t u64_start = TxSlotFindNext(psched, u32_slot_ms, &ref,
+                                                  Uptime(pclk, u64_true_us), LEAD_US, &u64_slot);
+        if(!u64_start)
+        {
+            ++r._u32_miss;
+            u64_true_us += u64_slot_us;
+            continue;
+        }
+
+        /* The slot the beacon should have taken, by true time. */
+        uint64_t u64_expected = (u64_true_us + LEAD_US) / u64_slot_us;
+        while(u64_expected * u64_slot_us + TX_OFFSET_MS * 1000LL < u64_true_us + LEAD_US
+              || !WSPRbeaconIsTxSlot(psched, u64_expected))
+        {
+            ++u64_expected;
+        }
+
+        const uint64_t u64_start_true = TrueTime(pclk, u64_start);
+        const int64_t i64_err = (int64_t)(u64_start_true - u64_slot * u64_slot_us) - TX_OFFSET_MS * 1000LL;
+        const int64_t i64_abs = i64_err < 0 ? -i64_err : i64_err;
+
+        ++r._u32_ntx;
+        if(u64_slot == u64_expected && i64_abs <= i64_budget_us)
+        {
+            ++r._u32_hit;
+        }
+        else
+        {
+            ++r._u32_miss;
+        }
+        r._i64_err_sum_us += i64_err;
+        if(i64_abs > (r._i64_err_max_us < 0 ? -r._i64_err_max_us : r._i64_err_max_us))
+        {
+            r._i64_err_max_us = i64_err;
+        }
+
+        /* The next slot is searched for when this frame starts. */
+        u64_true_us = u64_start_true + 1000;
+    }
+
+    return r;
+}
+
+/// @brief Runs every mode, parity and skip with a clock; prints a table.
+/// @return A count of misses.
+static uint32_t RunAll(const SimClock *pclk, int64_t i64_budget_us)
+{
+    printf("%s receiver, crystal %+.1f ppm\n", pclk->_pps ? "PPS+NMEA" : "NMEA-only",
+           pclk->_i64_ppb / 1000.);
+    printf("mode parity skip     tx    hit   miss  err mean,us  err max,us\n");
+
+    uint32_t u32_misses = 0;
+    for(int mode = WSPR_MODE_FT8; mode <= WSPR_MODE_FT4; ++mode)
+    {
+        for(int parity = WSPR_SLOT_ANY; parity <= WSPR_SLOT_ODD; ++parity)
+        {
+            for(size_t i = 0; i < sizeof(kSkips); ++i)
+            {
+                WSPRbeaconSchedule sched = { 0 };
+                sched._u8_tx_mode = mode;
+                sched._u8_tx_slot_parity = parity;
+                sched._u8_tx_slot_skip = kSkips[i];
+                sched._i16_tx_offset_ms = TX_OFFSET_MS;
+
+                const SimResult r = Run(pclk, WSPR_MODE_FT8 == mode ? 15000 : 7500, &sched,
+                                        i64_budget_us);
+                printf("%-4s %-6s %4u %6u %6u %6u  %11lld  %10lld\n",
+                       WSPR_MODE_FT8 == mode ? "FT8" : "FT4", kParityName[parity], kSkips[i],
+                       r._u32_ntx, r._u32_hit, r._u32_miss,
+                       r._u32_ntx ? (long long)(r._i64_err_sum_us / r._u32_ntx) : 0LL,
+                       (long long)r._i64_err_max_us);
+                u32_misses += r._u32_miss;
+            }
+        }
+    }
+    printf("\n");
+
+    return u32_misses;
+}
+
+int main(int argc, char **argv)
+{
+    const double ppm = argc > 1 ? atof(argv[1]) : 20.;
+    const int64_t i64_budget_us = (int64_t)((argc > 2 ? atof(argv[2]) : 20.) * 1000.);
+
+    SimClock clk = { (int64_t)(ppm * 1000.), 1 };
+    const uint32_t u32_misses = RunAll(&clk, i64_budget_us);
+
+    clk._pps = 0;
+    RunAll(&clk, i64_budget_us);
+
+    printf("PPS+NMEA misses: %u (budget %lld ms)\n", u32_misses, (long long)(i64_budget_us / 1000));
+    printf("verdict: %s\n", u32_misses ? "FAIL" : "PASS");
+
+    return u32_misses ? 2 : 0;
+}
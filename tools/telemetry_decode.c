@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  telemetry_decode.c - Decodes beacon telemetry received by WSJT-X.
+//
+//  DESCRIPTION
+//      WSJT-X shows an FT8/FT4 telemetry message (i3.n3 = 0.5) as up to 18
+//      hex digits. Packs each of them back as the beacon did, with the ft8
+//      library, and prints the fields of the schema of Telemetry module.
+//
+//  HOWTOSTART
+//      cc -O2 -DTELEMETRY_HOST -I. -ITelemetry -o telemetry_decode
+//         tools/telemetry_decode.c Telemetry/Telemetry.c ft8/message.c
+//         ft8/text.c
+//      ./telemetry_decode 16C1BFB6FA0484C4D2 [...]
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include "ft8/message.h"
+#include <Telemetry.h>
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s hex...\n", argv[0]);
+        return 1;
+    }
+
+    int ret = 0;
+    for(int i = 1; i < argc; ++i)
+    {
+        ftx_message_t msg;
+        ftx_message_init(&msg);
+        uint8_t b71[TELEMETRY_BYTES];
+        TelemetryRecord rec;
+        if(FTX_MESSAGE_RC_OK != ftx_message_encode_telemetry_hex(&msg, argv[i]))
+        {
+            printf("%s: not a telemetry message\n", argv[i]);
+            ret = 2;
+            continue;
+        }
+        ftx_message_decode_telemetry(&msg, b71);
+        if(TelemetryUnpack(b71, &rec))
+        {
+            printf("%s: unknown schema version\n", argv[i]);
+            ret = 2;
+            continue;
+        }
+
+        printf("%s: vsys %.2f V%s, temp %.1f C, corr %ld ppb%s, up %lud%02luh%02lum, sent %lu%s\n",
+               argv[i], rec._u32_vsys_mv / 1000., rec._u8_flags & TELEMETRY_FLAG_ADC ? "" : " (n/a)",
+               rec._i32_temp_centi / 100., (long)rec._i32_ppb,
+               rec._u8_flags & TELEMETRY_FLAG_FALLBACK ? " (predicted)" : "",
+               (unsigned long)rec._u32_uptime_s / 86400, (unsigned long)rec._u32_uptime_s / 3600 % 24,
+               (unsigned long)rec._u32_uptime_s / 60 % 60, (unsigned long)rec._u32_nsent,
+               rec._u8_flags & TELEMETRY_FLAG_GPS ? ", GPS" : ", no GPS");
+    }
+
+    return ret;
+}
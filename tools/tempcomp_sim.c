@@ -0,0 +1,266 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  tempcomp_sim.c - Host simulation of TempComp drift model.
+//
+//  DESCRIPTION
+//      Feeds TempComp module with a temperature/ppb trace while `GPS` is
+//      present, then drops GPS and compares the predicted correction with
+//      the true crystal error. Reports the worst residual in Hz at the
+//      dial frequency against a 1 Hz budget.
+//
+//      Without a trace file synthetic ones are used, 3 days each, sensor
+//      & GPS measurement noise, GPS lost for the 3rd day:
+//      - daily: a daily 15..35 C swing, mostly linear crystal with small
+//        quadratic & cubic terms;
+//      - at-cut: a daily 15..35 C swing, an AT-cut cubic with inflection
+//        at 25 C (a quadratic fit is 1.7 Hz off on it at 28 MHz);
+//      - ramp: a day at 22 C, a day of ramp to 38 C, a day back, with a
+//        noisier sensor. The fit goes through all its orders (const, lin,
+//        quad, cubic), which is checked, then predicts the way back.
+//      Each one reports its margin to the budget. The model in use within
+//      SWITCH_SAMPLES of a fit order change is checked against the budget
+//      too, as if GPS had been lost then.
+//
+//  HOWTOSTART
+//      cc -O2 -DTEMP_COMP_HOST -ITempComp -o tempcomp_sim
+//         tools/tempcomp_sim.c TempComp/TempComp.c -lm
+//      ./tempcomp_sim [trace.csv [dial_hz]]
+//
+//      Trace is CSV of `seconds,temp_c,ppb,gps` lines (gps is 0 or 1),
+//      `#` starts a comment.
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <TempComp.h>
+
+#define DIAL_HZ_DEFAULT     28075500.
+#define BUDGET_HZ           1.
+#define DAY_S               86400.
+#define SWITCH_SAMPLES      60              /* Samples checked after a fit order change. */
+
+typedef int (*TraceFn)(int i, double *pt, double *ptemp, double *pppb, int *pgps);
+
+typedef struct
+{
+    double _worst_hz, _sum2;
+    int _npredicted, _nmissed;
+    uint8_t _u8_orders;                     /* Bit per fit order seen learning. */
+    double _switch_worst_hz;                /* Within SWITCH_SAMPLES of an order change. */
+
+} TraceStats;
+
+/// @brief Uniform noise in [-a, a].
+static double Noise(double a)
+{
+    return a * (2. * rand() / RAND_MAX - 1.);
+}
+
+/// @brief Daily swing, mostly linear crystal.
+static int Daily(int i, double *pt, double *ptemp, double *pppb, int *pgps)
+{
+    const double t = i * 60.;
+    if(t >= 3 * DAY_S)
+    {
+        return 0;
+    }
+
+    const double temp = 25. + 10. * sin(2. * M_PI * t / DAY_S) + 1.5 * sin(2. * M_PI * t / 7000.);
+    *pt = t;
+    *ptemp = temp + Noise(.05);
+    const double dt = temp - 25.;
+    *pppb = 2300. - 45. * dt - 1.2 * dt * dt + .05 * dt * dt * dt;
+    *pgps = t < 2 * DAY_S;
+
+    return 1;
+}
+
+/// @brief Daily swing, AT-cut crystal: linear & cubic, inflection at 25 C.
+static int ATCut(int i, double *pt, double *ptemp, double *pppb, int *pgps)
+{
+    const double t = i * 60.;
+    if(t >= 3 * DAY_S)
+    {
+        return 0;
+    }
+
+    const double temp = 25. + 10. * sin(2. * M_PI * t / DAY_S) + 1.5 * sin(2. * M_PI * t / 7000.);
+    *pt = t;
+    *ptemp = temp + Noise(.05);
+    const double dt = temp - 25.;
+    *pppb = -1800. - 30. * dt + .1 * dt * dt * dt;
+    *pgps = t < 2 * DAY_S;
+
+    return 1;
+}
+
+/// @brief Constant temperature, then a ramp up and (no GPS) back down.
+static int Ramp(int i, double *pt, double *ptemp, double *pppb, int *pgps)
+{
+    const double t = i * 60.;
+    if(t >= 3 * DAY_S)
+    {
+        return 0;
+    }
+
+    const double temp = t < DAY_S ? 22. : t < 2 * DAY_S ? 22. + 16. * (t - DAY_S) / DAY_S
+                                                        : 38. - 16. * (t - 2 * DAY_S) / DAY_S;
+    *pt = t;
+    *ptemp = temp + Noise(.1);
+    const double dt = temp - 25.;
+    *pppb = 900. - 45. * dt - 1.2 * dt * dt + .05 * dt * dt * dt;
+    *pgps = t < 2 * DAY_S;
+
+    return 1;
+}
+
+/// @brief Runs a trace, from the file or a function, learning while GPS
+/// @brief is present and checking predictions while it isn't.
+static void RunTrace(FILE *f, TraceFn trace, double dial_hz, TempCompContext *pTC, TraceStats *pst)
+{
+    memset(pst, 0, sizeof(TraceStats));
+
+    char line[128];
+    int nsince_switch = SWITCH_SAMPLES;
+    for(int i = 0;; ++i)
+    {
+        double t, temp, ppb;
+        int gps;
+        if(f)
+        {
+            if(!fgets(line, sizeof(line), f))
+            {
+                break;
+            }
+            if('#' == line[0] || 4 != sscanf(line, "%lf,%lf,%lf,%d", &t, &temp, &ppb, &gps))
+            {
+                continue;
+            }
+        }
+        else if(!trace(i, &t, &temp, &ppb, &gps))
+        {
+            break;
+        }
+
+        const uint64_t u64_t_us = (uint64_t)(t * 1e6);
+        const int32_t i32_temp_centi = (int32_t)lround(temp * 100.);
+        if(gps)
+        {
+            if(TempCompIsDue(pTC, u64_t_us))
+            {
+                /* The model in use right after its order has changed. */
+                int32_t i32_pred_ppb;
+                if(nsince_switch < SWITCH_SAMPLES && !TempCompPredict(pTC, i32_temp_centi, &i32_pred_ppb))
+                {
+                    const double err_hz = fabs(i32_pred_ppb - ppb) * dial_hz * 1e-9;
+                    pst->_switch_worst_hz = err_hz > pst->_switch_worst_hz ? err_hz : pst->_switch_worst_hz;
+                }
+                const uint8_t u8_order = pTC->_u8_order;
+
+                /* GPS derived error is noisy too. */
+                TempCompLearn(pTC, u64_t_us, i32_temp_centi, (int32_t)lround(ppb + Noise(10.)));
+                pst->_u8_orders |= 1U << pTC->_u8_order;
+                nsince_switch = u8_order && u8_order != pTC->_u8_order ? 0 : nsince_switch + 1;
+            }
+            continue;
+        }
+
+        int32_t i32_pred_ppb;
+        if(TempCompPredict(pTC, i32_temp_centi, &i32_pred_ppb))
+        {
+            ++pst->_nmissed;
+            continue;
+        }
+
+        const double err_hz = (i32_pred_ppb - ppb) * dial_hz * 1e-9;
+        pst->_sum2 += err_hz * err_hz;
+        ++pst->_npredicted;
+        if(fabs(err_hz) > pst->_worst_hz)
+        {
+            pst->_worst_hz = fabs(err_hz);
+        }
+    }
+}
+
+/// @brief Prints the model and the results of a trace.
+/// @return 1 if within the budget.
+static int Report(const char *name, double dial_hz, const TempCompContext *pTC, const TraceStats *pst)
+{
+    printf("%s: model order: %u, learnt: %u, dT range: %.1f..%.1f C\n", name,
+           pTC->_u8_order, pTC->_rec._u32_nlearnt,
+           pTC->_rec._f_dt_min, pTC->_rec._f_dt_max);
+    printf("%s: coefs: a=%.1f ppb b=%.2f ppb/C c=%.3f ppb/C^2 d=%.4f ppb/C^3\n", name,
+           pTC->_pf_coef[0], pTC->_pf_coef[1], pTC->_pf_coef[2], pTC->_pf_coef[3]);
+
+    if(!pst->_npredicted)
+    {
+        printf("%s: no GPS-less samples to predict.\n", name);
+        return 0;
+    }
+
+    printf("%s: predicted: %d (no model: %d), rms: %.3f Hz, worst: %.3f Hz at %.0f Hz, "
+           "margin: %.3f Hz\n", name, pst->_npredicted, pst->_nmissed,
+           sqrt(pst->_sum2 / pst->_npredicted), pst->_worst_hz, dial_hz, BUDGET_HZ - pst->_worst_hz);
+    printf("%s: worst after a fit order change: %.3f Hz\n", name, pst->_switch_worst_hz);
+
+    return pst->_worst_hz < BUDGET_HZ && pst->_switch_worst_hz < BUDGET_HZ && !pst->_nmissed;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *f = argc > 1 ? fopen(argv[1], "r") : NULL;
+    if(argc > 1 && !f)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    const double dial_hz = argc > 2 ? atof(argv[2]) : DIAL_HZ_DEFAULT;
+
+    static const struct
+    {
+        const char *_name;
+        TraceFn _trace;
+        uint8_t _u8_orders;                 /* Fit orders which must be seen. */
+
+    } kTraces[] =
+    {
+        { "daily", Daily, 0 },
+        { "at-cut", ATCut, 0 },
+        { "ramp", Ramp, (1U << 1) | (1U << 2) | (1U << 3) | (1U << 4) },
+    };
+
+    int nchecked = 0, nfailed = 0;
+    const int ntraces = f ? 1 : (int)(sizeof(kTraces) / sizeof(kTraces[0]));
+    for(int i = 0; i < ntraces; ++i)
+    {
+        const char *name = f ? argv[1] : kTraces[i]._name;
+        TempCompContext *pTC = TempCompInit();
+        TraceStats st;
+        RunTrace(f, f ? NULL : kTraces[i]._trace, dial_hz, pTC, &st);
+
+        ++nchecked;
+        nfailed += !Report(name, dial_hz, pTC, &st);
+        if(!f && kTraces[i]._u8_orders)
+        {
+            ++nchecked;
+            if((st._u8_orders & kTraces[i]._u8_orders) != kTraces[i]._u8_orders)
+            {
+                ++nfailed;
+                printf("%s: fit orders seen 0x%x, expected 0x%x\n", name, st._u8_orders,
+                       kTraces[i]._u8_orders);
+            }
+        }
+        free(pTC);
+    }
+    if(f)
+    {
+        fclose(f);
+    }
+
+    printf("checked: %d, failed: %d\n", nchecked, nfailed);
+    printf("verdict: %s (budget %.1f Hz)\n", nfailed ? "FAIL" : "PASS", BUDGET_HZ);
+
+    return nfailed ? 2 : 0;
+}
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  template_check.c - Checks FT8/FT4 message templates on host.
+//
+//  DESCRIPTION
+//      For FT8 and FT4 and a few message patterns, encodes every value of
+//      the variable field (all 32400 grids, RRR/RR73/73 and all reports)
+//      both by ft8/template.c and by the full ftx_message_encode() +
+//      ft8_encode()/ft4_encode() path, and compares payloads and tones.
+//
+//  HOWTOSTART
+//      cc -O2 -I. -o template_check tools/template_check.c ft8/template.c
+//         ft8/message.c ft8/text.c ft8/encode.c ft8/constants.c ft8/crc.c
+//      ./template_check
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include "ft8/template.h"
+#include "ft8/encode.h"
+
+static const char *skPatterns[] =
+{
+    "CQ VU3CER {}",
+    "CQ K1ABC/R {}",
+    "VU3CER R2BDY {}",
+    "K1ABC/P W9XYZ {}",
+};
+
+static int snChecked, snFailed;
+
+/// @brief Compares template encoding of a field with the full one.
+static void Check(const ftx_template_t *ptpl, const char *ppattern, const char *pfield)
+{
+    char text[FTX_MAX_MESSAGE_LENGTH];
+    snprintf(text, sizeof(text), "%.*s%s", (int)(strlen(ppattern) - 2), ppattern, pfield);
+
+    ftx_message_t msg;
+    if(FTX_MESSAGE_RC_OK != ftx_message_encode(&msg, NULL, text))
+    {
+        printf("%s: full encoding failed\n", text);
+        ++snFailed;
+        return;
+    }
+
+    uint8_t tones_full[FT4_NN], tones_tpl[FT4_NN], payload[FTX_PAYLOAD_LENGTH_BYTES];
+    const int n = ptpl->is_ft4 ? FT4_NN : FT8_NN;
+    if(ptpl->is_ft4)
+    {
+        ft4_encode(msg.payload, tones_full);
+    }
+    else
+    {
+        ft8_encode(msg.payload, tones_full);
+    }
+
+    const uint32_t value = ftx_template_pack_field(ptpl, pfield);
+    ftx_template_payload(ptpl, value, payload);
+    ftx_template_encode(ptpl, value, tones_tpl);
+
+    ++snChecked;
+    if(memcmp(payload, msg.payload, sizeof(payload)) || memcmp(tones_tpl, tones_full, n))
+    {
+        if(++snFailed <= 10)
+        {
+            printf("%s %s: MISMATCH\n", ptpl->is_ft4 ? "FT4" : "FT8", text);
+        }
+    }
+}
+
+int main(void)
+{
+    for(int ft4 = 0; ft4 < 2; ++ft4)
+    {
+        for(size_t p = 0; p < sizeof(skPatterns) / sizeof(skPatterns[0]); ++p)
+        {
+            ftx_template_t tpl;
+            if(FTX_MESSAGE_RC_OK != ftx_template_compile(&tpl, skPatterns[p], NULL, ft4))
+            {
+                printf("%s: compile failed\n", skPatterns[p]);
+                ++snFailed;
+                continue;
+            }
+
+            char field[8];
+            for(int i = 0; i < 18 * 18 * 100; ++i)
+            {
+                snprintf(field, sizeof(field), "%c%c%02d", 'A' + i / 1800, 'A' + i / 100 % 18, i % 100);
+                Check(&tpl, skPatterns[p], field);
+            }
+            Check(&tpl, skPatterns[p], "RRR");
+            Check(&tpl, skPatterns[p], "RR73");
+            Check(&tpl, skPatterns[p], "73");
+            for(int dd = -30; dd <= 30; ++dd)
+            {
+                snprintf(field, sizeof(field), "%+03d", dd);
+                Check(&tpl, skPatterns[p], field);
+                snprintf(field, sizeof(field), "R%+03d", dd);
+                Check(&tpl, skPatterns[p], field);
+            }
+        }
+    }
+
+    printf("checked: %d, failed: %d\n", snChecked, snFailed);
+    printf("verdict: %s\n", snFailed ? "FAIL" : "PASS");
+
+    return snFailed ? 2 : 0;
+}
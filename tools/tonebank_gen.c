@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  tonebank_gen.c - Generates the flash tone bank of fixed messages.
+//
+//  DESCRIPTION
+//      Reads a message list (WSPRbeacon/ToneBank.txt), encodes every
+//      message by ft8_lib the same way the beacon does (standard message,
+//      free text fallback) and writes a C file with the tones packed as
+//      const arrays (3 bits per FT8 tone, 2 per FT4 one, see TonePack.h)
+//      and the kToneBank table, see WSPRbeacon/ToneBank.h.
+//      Runs on the build host, CMake builds and runs it before the firmware.
+//
+//  HOWTOSTART
+//      cc -O2 -I. -ITxChannel -o tonebank_gen tools/tonebank_gen.c
+//         TxChannel/TonePack.c ft8/message.c ft8/text.c ft8/encode.c
+//         ft8/constants.c ft8/crc.c
+//      ./tonebank_gen WSPRbeacon/ToneBank.txt tonebank_data.c
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "ft8/message.h"
+#include "ft8/encode.h"
+#include "ft8/constants.h"
+#include "TonePack.h"
+
+#define MAX_MESSAGES 256
+
+typedef struct
+{
+    char text[FTX_MAX_MESSAGE_LENGTH];
+    int mode;                                   /* 0 - FT8, 1 - FT4. */
+    int ntones;
+    uint8_t tones[FT4_NN];
+    uint8_t packed[TONE_PACK_BYTES(FT4_NN, TONE_PACK_MAX_BITS)];
+    TonePackedFrame frame;
+
+} Message;
+
+static Message sMessages[MAX_MESSAGES];
+
+/// @brief Encodes a message as ft8_encode_top() does.
+/// @return 0 if OK.
+static int Encode(Message *pm)
+{
+    ftx_message_t msg;
+    if(FTX_MESSAGE_RC_OK != ftx_message_encode(&msg, NULL, pm->text))
+    {
+        return -1;
+    }
+
+    if(pm->mode)
+    {
+        pm->ntones = FT4_NN;
+        ft4_encode(msg.payload, pm->tones);
+    }
+    else
+    {
+        pm->ntones = FT8_NN;
+        ft8_encode(msg.payload, pm->tones);
+    }
+
+    return TonePackFrame(&pm->frame, pm->packed, sizeof(pm->packed), pm->tones,
+                         pm->ntones, pm->mode ? 2 : 3);
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 3)
+    {
+        fprintf(stderr, "Usage: %s list.txt out.c\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fin = fopen(argv[1], "r");
+    if(!fin)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    int n = 0, nline = 0;
+    char line[128];
+    while(fgets(line, sizeof(line), fin))
+    {
+        ++nline;
+        line[strcspn(line, "\r\n")] = '\0';
+        if('#' == line[0] || !line[0])
+        {
+            continue;
+        }
+
+        char mode[4];
+        int pos;
+        if(1 != sscanf(line, "%3s %n", mode, &pos) || (strcmp(mode, "FT8") && strcmp(mode, "FT4")))
+        {
+            fprintf(stderr, "%s:%d: expected FT8 or FT4\n", argv[1], nline);
+            return 1;
+        }
+        if(n == MAX_MESSAGES || strlen(line + pos) >= FTX_MAX_MESSAGE_LENGTH)
+        {
+            fprintf(stderr, "%s:%d: too many or too long messages\n", argv[1], nline);
+            return 1;
+        }
+
+        Message *pm = &sMessages[n];
+        strcpy(pm->text, line + pos);
+        pm->mode = !strcmp(mode, "FT4");
+        if(Encode(pm))
+        {
+            fprintf(stderr, "%s:%d: can't encode '%s'\n", argv[1], nline, pm->text);
+            return 1;
+        }
+        ++n;
+    }
+    fclose(fin);
+
+    FILE *fout = fopen(argv[2], "w");
+    if(!fout)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    fprintf(fout, "// Generated by tools/tonebank_gen.c from %s, do not edit.\n", argv[1]);
+    fprintf(fout, "#include \"ToneBank.h\"\n\n");
+    for(int i = 0; i < n; ++i)
+    {
+        const TonePackedFrame *pf = &sMessages[i].frame;
+        const int nbytes = TONE_PACK_BYTES(pf->_u16_ntones, pf->_u8_bits);
+        fprintf(fout, "static const uint8_t kTones%d[%d] =\n{", i, nbytes);
+        for(int j = 0; j < nbytes; ++j)
+        {
+            fprintf(fout, "%s0x%02X,", j % 12 ? " " : "\n    ", pf->_pu8_data[j]);
+        }
+        fprintf(fout, "\n};\n\n");
+    }
+
+    fprintf(fout, "const ToneBankEntry kToneBank[%d] =\n{\n", n ? n : 1);
+    for(int i = 0; i < n; ++i)
+    {
+        fprintf(fout, "    { \"%s\", %d, { kTones%d, %d, %d } },\n", sMessages[i].text,
+                sMessages[i].mode, i, sMessages[i].frame._u16_ntones, sMessages[i].frame._u8_bits);
+    }
+    fprintf(fout, "%s};\n\nconst uint16_t kToneBankCount = %d;\n", n ? "" : "    { 0 }\n", n);
+    fclose(fout);
+
+    printf("tonebank_gen: %d messages\n", n);
+
+    return 0;
+}
@@ -0,0 +1,349 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  txchannel_sim.c - Host checks of TxChannel on simulated hardware.
+//
+//  DESCRIPTION
+//      Builds TxChannel module with TX_CHANNEL_HOST, so the timer, alarm
+//      IRQs and DCO are the simulated ones below (see TxChannelHost.h).
+//
+//      Checks DCO word precompute of DMA backend (TxChannelFrameWords):
+//      FT8, FT4 and WSPR frames of random tones are turned into control
+//      words, with GPS correction and with the temperature fallback one.
+//      Every word must be the one the symbol ISR would set for its tone,
+//      followed by a pad word repeating the last one: n+1 words. The DCO
+//      itself must stay intact, a frame which doesn't fit is refused.
+//
+//      Checks that channels keep their own timing: two channels on their
+//      own alarms, FT8 and FT4 symbol periods, send frames which overlap
+//      in time, with random ISR latency injected. Every symbol edge of
+//      each channel (a DCO word change) must come at its own start time
+//      plus a whole count of its own periods with the right tone; late
+//      by no more than the injected latency, twice that when the other
+//      channel's ISR was due at the same time. The end of frame event
+//      must follow the last symbol's full period.
+//
+//  HOWTOSTART
+//      cc -O2 -DTX_CHANNEL_HOST -I. -ITxChannel -o txchannel_sim
+//         tools/txchannel_sim.c TxChannel/TxChannel.c TxChannel/TonePack.c
+//      ./txchannel_sim
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <TxChannel.h>
+#include <defines.h>
+
+#define DIAL_HZ             14074000UL
+#define CLK_HZ              135000000UL
+#define GPS_SHIFT_MILHZ     (-1234)
+#define FALLBACK_PPB        (-2300)
+#define MAX_LATENCY_US      40
+#define MAX_LATE_US         (2 * MAX_LATENCY_US)    /* Both alarms due at once. */
+#define MAX_EDGES           512
+
+/* Simulated hardware, see TxChannelHost.h */
+static timer_hw_t sTimer;
+timer_hw_t *timer_hw = &sTimer;
+static uint64_t su64_now_us = 1000000;
+static irq_handler_t spHandler[NUM_ALARMS];
+static uint32_t spu32_fired[NUM_ALARMS];     /* Alarm value of the last fire. */
+
+typedef struct
+{
+    const PioDco *_pDCO;
+    uint64_t _pu64_time_us[MAX_EDGES];
+    int32_t _pi32_word[MAX_EDGES];
+    int _n;
+
+} EdgeLog;
+
+static EdgeLog sEdges[2];
+
+uint64_t time_us_64(void)
+{
+    return su64_now_us;
+}
+
+static void SimSetNow(uint64_t u64_now_us)
+{
+    su64_now_us = u64_now_us;
+    timer_hw->timerawl = (uint32_t)u64_now_us;
+}
+
+void irq_set_exclusive_handler(unsigned num, irq_handler_t handler)
+{
+    spHandler[num] = handler;
+}
+
+/// @brief Runs the alarm ISR which is due first, if it's due before the
+/// @brief given time; else moves the time there. An alarm is armed when
+/// @brief its register has been written since it last fired. Every ISR is
+/// @brief entered late by a random 0..MAX_LATENCY_US.
+/// @return 1 if an ISR has run.
+static int SimFireNext(uint64_t u64_until_us)
+{
+    int ifire = -1;
+    int32_t i32_first = 0;
+    for(int n = 0; n < NUM_ALARMS; ++n)
+    {
+        if(!spHandler[n] || !(timer_hw->inte & (1U << n)) || timer_hw->alarm[n] == spu32_fired[n])
+        {
+            continue;
+        }
+        const int32_t i32_due = (int32_t)(timer_hw->alarm[n] - (uint32_t)su64_now_us);
+        if(ifire < 0 || i32_due < i32_first)
+        {
+            ifire = n;
+            i32_first = i32_due;
+        }
+    }
+    const uint64_t u64_due = su64_now_us + (i32_first > 0 ? i32_first : 0);
+    if(ifire < 0 || u64_due > u64_until_us)
+    {
+        SimSetNow(u64_until_us);
+        return 0;
+    }
+
+    spu32_fired[ifire] = timer_hw->alarm[ifire];
+    SimSetNow(u64_due + rand() % (MAX_LATENCY_US + 1));
+    spHandler[ifire]();
+
+    return 1;
+}
+
+/// @brief DCO model: a word unique to the output frequency, as the real
+/// @brief PIO DCO's count of clock cycles per half period (scaled).
+static int32_t DcoWord(uint32_t u32_clk_hz, uint32_t u32_frq_hz, int32_t i32_millihz)
+{
+    return (int32_t)(((uint64_t)u32_clk_hz << 32) / ((uint64_t)u32_frq_hz * 1000 + i32_millihz));
+}
+
+int PioDCOSetFreq(PioDco *pdco, uint32_t u32_frq_hz, int32_t u32_frq_millihz)
+{
+    pdco->_frq_cycles_per_pi = DcoWord(pdco->_clkfreq_hz, u32_frq_hz, u32_frq_millihz);
+
+    for(int i = 0; i < 2; ++i)
+    {
+        EdgeLog *pE = &sEdges[i];
+        if(pE->_pDCO == pdco && pE->_n < MAX_EDGES)
+        {
+            pE->_pu64_time_us[pE->_n] = su64_now_us;
+            pE->_pi32_word[pE->_n] = pdco->_frq_cycles_per_pi;
+            ++pE->_n;
+        }
+    }
+
+    return 0;
+}
+
+int32_t PioDCOGetFreqShiftMilliHertz(const PioDco *pdco, uint64_t u64_desired_frq_millihz)
+{
+    (void)pdco;
+    (void)u64_desired_frq_millihz;
+    return GPS_SHIFT_MILHZ;
+}
+
+void StampPrintf(const char *pformat, ...)
+{
+    va_list argptr;
+    va_start(argptr, pformat);
+    vprintf(pformat, argptr);
+    va_end(argptr);
+    printf("\n");
+}
+
+static int snchecked = 0, snfailed = 0;
+
+static void Expect(int ok, const char *what)
+{
+    ++snchecked;
+    if(!ok)
+    {
+        ++snfailed;
+        printf("FAILED: %s\n", what);
+    }
+}
+
+/// @brief Precomputes the words of a random frame and checks them.
+/// @param pTX Channel.
+/// @param n A count of tones.
+/// @param bits Bits per tone.
+/// @param i32_comp_millis The correction the channel must apply.
+static void CheckWords(TxChannelContext *pTX, int n, uint8_t bits, int32_t i32_comp_millis)
+{
+    uint8_t tones[256] = { 0 }, packed[TONE_PACK_BYTES(256, TONE_PACK_MAX_BITS)];
+    uint32_t words[257];
+    for(int i = 0; i < n; ++i)
+    {
+        tones[i] = rand() & ((1 << bits) - 1);
+    }
+    TonePackedFrame frame;
+    TonePackFrame(&frame, packed, sizeof(packed), tones, n, bits);
+
+    const PioDco dco_before = *pTX->_p_oscillator;
+    memset(words, 0xA5, sizeof(words));
+    const int nwords = TxChannelFrameWords(pTX, &frame, words, n + 1);
+
+    char what[96];
+    snprintf(what, sizeof(what), "%d tones of %u bits: %d words", n, bits, nwords);
+    Expect(nwords == n + 1, what);
+
+    int nbad = 0;
+    for(int i = 0; i < n; ++i)
+    {
+        const int32_t i32_word = DcoWord(CLK_HZ, pTX->_u32_dialfreqhz,
+                                         tones[i] * (int32_t)pTX->_u32_tone_step_milhz - 2 * i32_comp_millis);
+        nbad += (int32_t)words[i] != i32_word;
+    }
+    snprintf(what, sizeof(what), "%d tones of %u bits: %d wrong words", n, bits, nbad);
+    Expect(!nbad, what);
+
+    const uint32_t u32_pad = n ? words[n - 1] : (uint32_t)dco_before._frq_cycles_per_pi;
+    snprintf(what, sizeof(what), "%d tones of %u bits: pad word", n, bits);
+    Expect(words[n] == u32_pad, what);
+    Expect(words[n + 1] == 0xA5A5A5A5UL, "nothing written past the pad word");
+    Expect(!memcmp(&dco_before, pTX->_p_oscillator, sizeof(PioDco)), "DCO intact");
+
+    Expect(-1 == TxChannelFrameWords(pTX, &frame, words, n), "frame over capacity refused");
+}
+
+typedef struct
+{
+    TxChannelContext *_pTX;
+    EdgeLog *_pE;
+    uint8_t _pu8_tones[256];
+    uint8_t _pu8_packed[TONE_PACK_BYTES(256, TONE_PACK_MAX_BITS)];
+    int _n;
+    uint64_t _u64_start_us;
+    uint64_t _u64_done_us;              /* End of frame event seen, 0 - not yet. */
+
+} SimFrame;
+
+/// @brief Queues a frame of random tones to start at the given time.
+static void SimQueue(SimFrame *pF, int n, uint8_t bits, uint64_t u64_start_us)
+{
+    for(int i = 0; i < n; ++i)
+    {
+        pF->_pu8_tones[i] = rand() & ((1 << bits) - 1);
+    }
+    pF->_n = n;
+    pF->_u64_start_us = u64_start_us;
+    pF->_u64_done_us = 0;
+    pF->_pE->_n = 0;
+
+    TxChannelFrame frame = { { 0 }, u64_start_us, 0, NULL, NULL };
+    TonePackFrame(&frame._tones, pF->_pu8_packed, sizeof(pF->_pu8_packed), pF->_pu8_tones, n, bits);
+    TxChannelClear(pF->_pTX);
+    Expect(0 == TxChannelQueueFrame(pF->_pTX, &frame), "frame queued");
+}
+
+/// @brief Checks the symbol edges of a frame sent by a channel.
+static void CheckEdges(const SimFrame *pF, const char *name)
+{
+    const TxChannelContext *pTX = pF->_pTX;
+    const EdgeLog *pE = pF->_pE;
+    char what[128];
+
+    snprintf(what, sizeof(what), "%s: %d edges of %d tones", name, pE->_n, pF->_n);
+    Expect(pE->_n == pF->_n, what);
+
+    int nlate = 0, nearly = 0, nbad = 0;
+    for(int i = 0; i < pE->_n && i < pF->_n; ++i)
+    {
+        const uint64_t u64_ideal = pF->_u64_start_us + (uint64_t)i * pTX->_bit_period_us;
+        nearly += pE->_pu64_time_us[i] < u64_ideal;
+        nlate += pE->_pu64_time_us[i] > u64_ideal + MAX_LATE_US;
+        nbad += pE->_pi32_word[i] != DcoWord(CLK_HZ, pTX->_u32_dialfreqhz,
+                                             pF->_pu8_tones[i] * (int32_t)pTX->_u32_tone_step_milhz
+                                             - 2 * GPS_SHIFT_MILHZ);
+    }
+    snprintf(what, sizeof(what), "%s: edges early %d, late %d, wrong tone %d", name, nearly, nlate, nbad);
+    Expect(!nearly && !nlate && !nbad, what);
+
+    const uint64_t u64_end = pF->_u64_start_us + (uint64_t)pF->_n * pTX->_bit_period_us;
+    snprintf(what, sizeof(what), "%s: end of frame at %+lld us", name,
+             pF->_u64_done_us ? (long long)(pF->_u64_done_us - u64_end) : -1LL);
+    Expect(pF->_u64_done_us >= u64_end && pF->_u64_done_us <= u64_end + MAX_LATE_US, what);
+
+    TxJitterStats stats;
+    TxChannelGetJitter(pTX, &stats);
+    snprintf(what, sizeof(what), "%s: jitter n:%u max:%u us", name, stats._u32_count, stats._u32_max_us);
+    Expect((int)stats._u32_count == pF->_n && stats._u32_max_us <= MAX_LATE_US, what);
+
+    printf("%s: %d symbols of %u us from %llu us, end %llu us\n", name, pE->_n,
+           pTX->_bit_period_us, (unsigned long long)pF->_u64_start_us,
+           (unsigned long long)pF->_u64_done_us);
+}
+
+/// @brief Runs two channels of different periods over overlapping frames.
+/// @param pA FT8 channel.
+/// @param pB FT4 channel.
+/// @param i32_offset_us Start of FT4 frame relative to FT8 one.
+static void CheckTwoChannels(SimFrame *pA, SimFrame *pB, int32_t i32_offset_us)
+{
+    const uint64_t u64_start = su64_now_us + 500000;
+    SimQueue(pA, 79, 3, u64_start);
+    SimQueue(pB, 105, 2, u64_start + i32_offset_us);
+
+    const uint64_t u64_end = u64_start + 79ULL * 159000 + 105ULL * 48000 + 1000000;
+    while(su64_now_us < u64_end)
+    {
+        SimFireNext(u64_end);
+        SimFrame *pF[2] = { pA, pB };
+        for(int i = 0; i < 2; ++i)
+        {
+            if(!pF[i]->_u64_done_us && TxChannelFrameDone(pF[i]->_pTX))
+            {
+                pF[i]->_u64_done_us = su64_now_us;
+            }
+        }
+    }
+
+    CheckEdges(pA, "FT8 channel");
+    CheckEdges(pB, "FT4 channel");
+}
+
+int main(void)
+{
+    GPStimeContext gps = { { YES } };
+    PioDco dco = { 0, CLK_HZ, &gps };
+    PioDCOSetFreq(&dco, DIAL_HZ, 0);
+
+    TxChannelContext *pTX = TxChannelInit(159000, 0, 256, &dco);
+    pTX->_u32_dialfreqhz = DIAL_HZ;
+
+    /* FT8, FT4, WSPR-long and an empty frame, GPS correction. */
+    CheckWords(pTX, 79, 3, GPS_SHIFT_MILHZ);
+    pTX->_u32_tone_step_milhz = FT4_FREQ_STEP_MILHZ;
+    CheckWords(pTX, 105, 2, GPS_SHIFT_MILHZ);
+    CheckWords(pTX, 162, 2, GPS_SHIFT_MILHZ);
+    CheckWords(pTX, 0, 3, GPS_SHIFT_MILHZ);
+
+    /* No GPS: temperature model correction. */
+    gps._time_data._u8_is_solution_active = NO;
+    TxChannelSetFallbackPpb(pTX, FALLBACK_PPB);
+    pTX->_u32_tone_step_milhz = WSPR_FREQ_STEP_MILHZ;
+    CheckWords(pTX, 79, 3, (int32_t)((int64_t)DIAL_HZ * FALLBACK_PPB / 1000000LL));
+
+    /* Two channels, each on its own alarm & DCO. */
+    gps._time_data._u8_is_solution_active = YES;
+    PioDco dco_a = { 0, CLK_HZ, &gps }, dco_b = { 0, CLK_HZ, &gps };
+    SimFrame a = { ._pTX = TxChannelInit(159000, 1, 256, &dco_a), ._pE = &sEdges[0] };
+    SimFrame b = { ._pTX = TxChannelInit(48000, 2, 256, &dco_b), ._pE = &sEdges[1] };
+    a._pTX->_u32_dialfreqhz = DIAL_HZ;
+    b._pTX->_u32_dialfreqhz = DIAL_HZ + 1000;
+    b._pTX->_u32_tone_step_milhz = FT4_FREQ_STEP_MILHZ;
+    sEdges[0]._pDCO = &dco_a;
+    sEdges[1]._pDCO = &dco_b;
+
+    CheckTwoChannels(&a, &b, 0);
+    CheckTwoChannels(&a, &b, 13);
+    CheckTwoChannels(&a, &b, 3000001);
+
+    printf("checked: %d, failed: %d\n", snchecked, snfailed);
+    printf("verdict: %s\n", snfailed ? "FAIL" : "PASS");
+
+    return snfailed ? 2 : 0;
+}
@@ -0,0 +1,862 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  txpacer_sim.c - Host checks of the DMA backend's symbol pacer.
+//
+//  DESCRIPTION
+//      Builds TxChannelDMA.c with TX_CHANNEL_HOST on an emulated PIO
+//      state machine and two DMA channels, cycle by cycle of sys clock.
+//      The pacer program is assembled from TxChannel/txpacer.pio at run
+//      time and loaded by the real txpacer_program_init (its c-sdk block),
+//      so its loop, wrap and overhead constant are the ones of the tree.
+//
+//      FT8, FT4 and WSPR frames are sent at 125 and 48 MHz sys clock.
+//      Every control word must reach the DCO word exactly one symbol
+//      period (bit period in sys clocks) after the previous one, in frame
+//      order, followed by the pad word. The end of frame IRQ (DMA_IRQ_1)
+//      must come once, when the pad word is taken, i.e. after the last
+//      symbol's full period. Pending count must follow the symbols.
+//
+//      Also: a frame stopped midway doesn't signal its end (abort raises
+//      a spurious IRQ, RP2040-E13, which Stop must swallow) and the next
+//      one keeps the period; the period follows a change of the bit
+//      period or sys clock by TxChannelDMASetPeriod / TxChannelDMASend.
+//
+//      DMA moves a word in the cycle its DREQ is up, a simplification:
+//      the real latency is a few cycles, the same for every word.
+//
+//  HOWTOSTART
+//      mkdir -p _host && sed -e '/^% c-sdk {/,/^%}/!d' -e '/^%/d'
+//         TxChannel/txpacer.pio > _host/txpacer.pio.h
+//      cc -O2 -DTX_CHANNEL_HOST -DTXCHANNEL_DMA_BACKEND=1 -I. -I_host
+//         -ITxChannel -o txpacer_sim tools/txpacer_sim.c
+//         TxChannel/TxChannelDMA.c TxChannel/TxChannel.c TxChannel/TonePack.c
+//      ./txpacer_sim [TxChannel/txpacer.pio]
+//
+///////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <TxChannelDMA.h>
+#include <defines.h>
+
+#define DIAL_HZ             14074000UL
+#define CLK_HZ              125000000UL
+#define SLEEP_CLK_HZ        48000000UL
+#define GPS_SHIFT_MILHZ     (-1234)
+#define PIO_FIFO_DEPTH      4
+#define PIO_MEM_SIZE        32
+#define NUM_DMA_CHANNELS    12
+#define DREQ_PIO0_TX0       0
+#define DREQ_PIO0_RX0       4
+#define MAX_WRITES          (TX_DMA_MAX_SYMBOLS + 8)
+#define FT8_PERIOD_US       159000          /* As WSPRbeaconSetMode sets. */
+#define FT4_PERIOD_US       48000
+#define WSPR_PERIOD_US      682667
+
+/* Simulated hardware, see TxChannelHost.h */
+static timer_hw_t sTimer;
+timer_hw_t *timer_hw = &sTimer;
+static uint32_t su32_clk_hz = CLK_HZ;
+static uint64_t su64_cycle = 0;                 /* Sys clock cycles. */
+static irq_handler_t spDmaIrq1Handler;
+
+typedef struct
+{
+    uint8_t _en;
+    uint8_t _pc, _wrap_bottom, _wrap_top;
+    uint32_t _x, _y, _isr, _osr;
+    uint32_t _ptxf[PIO_FIFO_DEPTH];
+    uint32_t _prxf[PIO_FIFO_DEPTH];
+    int _ntx, _nrx;
+    uint32_t _u32_clkdiv_int;
+
+} SimSm;
+
+typedef struct
+{
+    pio_hw_t _regs;                             /* Only the FIFO addresses are used. */
+    uint16_t _pu16_mem[PIO_MEM_SIZE];
+    int _used;
+    uint8_t _sm_claimed;
+    SimSm _sm[NUM_PIO_STATE_MACHINES];
+
+} SimPio;
+
+typedef struct
+{
+    uint8_t _claimed, _busy, _irq1_en, _irq1;
+    dma_channel_config _cfg;
+    volatile uint8_t *_pread, *_pwrite;
+    dma_channel_hw_t _hw;
+
+} SimDma;
+
+static SimPio sPio;
+static SimDma sDma[NUM_DMA_CHANNELS];
+
+/* The pacer as assembled from the .pio, see LoadProgram; its length is
+   known at run time only, so snprog stands for txpacer_program.length. */
+static uint16_t spu16_prog[PIO_MEM_SIZE];
+static int snprog, swrap_target = -1, swrap = -1;
+const struct pio_program txpacer_program = { spu16_prog, PIO_MEM_SIZE, -1 };
+
+/* DCO word writes by DMA. */
+static const volatile int32_t *spi32_dco_word;
+static uint64_t spu64_write_cycle[MAX_WRITES];
+static uint32_t spu32_write_word[MAX_WRITES];
+static int snwrites;
+static uint64_t spu64_irq_cycle[8];
+static int snirqs;
+
+uint64_t time_us_64(void)
+{
+    return su64_cycle / (su32_clk_hz / 1000000U);
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+    (void)clk_index;
+    return su32_clk_hz;
+}
+
+void irq_set_exclusive_handler(unsigned num, irq_handler_t handler)
+{
+    if(DMA_IRQ_1 == num)
+    {
+        spDmaIrq1Handler = handler;
+    }
+}
+
+static int32_t DcoWord(uint32_t u32_clk_hz, uint32_t u32_frq_hz, int32_t i32_millihz)
+{
+    return (int32_t)(((uint64_t)u32_clk_hz << 32) / ((uint64_t)u32_frq_hz * 1000 + i32_millihz));
+}
+
+int PioDCOSetFreq(PioDco *pdco, uint32_t u32_frq_hz, int32_t u32_frq_millihz)
+{
+    pdco->_frq_cycles_per_pi = DcoWord(pdco->_clkfreq_hz, u32_frq_hz, u32_frq_millihz);
+    return 0;
+}
+
+int32_t PioDCOGetFreqShiftMilliHertz(const PioDco *pdco, uint64_t u64_desired_frq_millihz)
+{
+    (void)pdco;
+    (void)u64_desired_frq_millihz;
+    return GPS_SHIFT_MILHZ;
+}
+
+void StampPrintf(const char *pformat, ...)
+{
+    va_list argptr;
+    va_start(argptr, pformat);
+    vprintf(pformat, argptr);
+    va_end(argptr);
+    printf("\n");
+}
+
+/* ---------------------------------------------------------------- PIO -- */
+
+static SimSm *Sm(PIO pio, uint sm)
+{
+    assert(pio == &sPio._regs && sm < NUM_PIO_STATE_MACHINES);
+    return &sPio._sm[sm];
+}
+
+int pio_claim_unused_sm(PIO pio, bool required)
+{
+    (void)pio;
+    for(int i = 0; i < NUM_PIO_STATE_MACHINES; ++i)
+    {
+        if(!(sPio._sm_claimed & (1U << i)))
+        {
+            sPio._sm_claimed |= 1U << i;
+            return i;
+        }
+    }
+    assert(!required);
+    return -1;
+}
+
+/// @brief Loads a program at the end of free memory, relocating JMPs as
+/// @brief the SDK does.
+uint pio_add_program(PIO pio, const struct pio_program *program)
+{
+    (void)pio;
+    assert(program == &txpacer_program && snprog > 0);
+    const int offset = PIO_MEM_SIZE - sPio._used - snprog;
+    assert(offset >= 0);
+    for(int i = 0; i < snprog; ++i)
+    {
+        const uint16_t instr = program->instructions[i];
+        sPio._pu16_mem[offset + i] = (instr >> 13) ? instr : (uint16_t)(instr + offset);
+    }
+    sPio._used += snprog;
+    return (uint)offset;
+}
+
+pio_sm_config txpacer_program_get_default_config(uint offset)
+{
+    pio_sm_config c = { 1, 0, (uint8_t)(offset + swrap_target), (uint8_t)(offset + swrap) };
+    return c;
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm)
+{
+    SimSm *p = Sm(pio, sm);
+    p->_ntx = p->_nrx = 0;
+}
+
+/// @brief As the SDK: stops, configures, clears FIFOs, restarts (X, Y
+/// @brief are kept) and jumps to the initial pc.
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config)
+{
+    SimSm *p = Sm(pio, sm);
+    p->_en = 0;
+    p->_wrap_bottom = config->_u8_wrap_target;
+    p->_wrap_top = config->_u8_wrap;
+    p->_u32_clkdiv_int = config->_u32_clkdiv_int + (config->_u8_clkdiv_frac ? 1000 : 0);
+    pio_sm_clear_fifos(pio, sm);
+    p->_isr = p->_osr = 0;
+    p->_pc = (uint8_t)initial_pc;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled)
+{
+    Sm(pio, sm)->_en = enabled;
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data)
+{
+    SimSm *p = Sm(pio, sm);
+    assert(p->_ntx < PIO_FIFO_DEPTH);
+    p->_ptxf[p->_ntx++] = data;
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+    (void)pio;
+    return (is_tx ? DREQ_PIO0_TX0 : DREQ_PIO0_RX0) + sm;
+}
+
+static uint32_t PioSource(const SimSm *p, int src)
+{
+    switch(src)
+    {
+        case pio_x:   return p->_x;
+        case pio_y:   return p->_y;
+        case pio_null: return 0;
+        case pio_isr: return p->_isr;
+        case pio_osr: return p->_osr;
+        default: break;
+    }
+    fprintf(stderr, "Unsupported mov source %d\n", src);
+    exit(1);
+}
+
+/// @brief Executes an instruction (JMP, PUSH, PULL, MOV subset).
+/// @return 1 if executed, 0 if stalled.
+static int PioExec(SimSm *p, uint16_t instr, int from_mem)
+{
+    const int delay = (instr >> 8) & 0x1F;
+    if(delay)
+    {
+        fprintf(stderr, "Delay/side-set isn't emulated: %04x\n", instr);
+        exit(1);
+    }
+
+    int jumped = 0;
+    switch(instr >> 13)
+    {
+        case 0:                                 /* JMP */
+        {
+        int take = 0;
+        switch((instr >> 5) & 7)
+        {
+            case 0: take = 1; break;
+            case 1: take = !p->_x; break;
+            case 2: take = 0 != p->_x--; break;
+            case 3: take = !p->_y; break;
+            case 4: take = 0 != p->_y--; break;
+            case 5: take = p->_x != p->_y; break;
+            default:
+            fprintf(stderr, "Unsupported jmp condition: %04x\n", instr);
+            exit(1);
+        }
+        if(take)
+        {
+            p->_pc = instr & 0x1F;
+            jumped = 1;
+        }
+        }
+        break;
+
+        case 4:                                 /* PUSH / PULL */
+        if(instr & 0x80)
+        {
+            if(!p->_ntx)
+            {
+                if(instr & 0x20)
+                {
+                    return 0;
+                }
+                p->_osr = p->_x;
+                break;
+            }
+            p->_osr = p->_ptxf[0];
+            memmove(p->_ptxf, p->_ptxf + 1, --p->_ntx * sizeof(uint32_t));
+        }
+        else
+        {
+            if(PIO_FIFO_DEPTH == p->_nrx)
+            {
+                if(instr & 0x20)
+                {
+                    return 0;
+                }
+                break;
+            }
+            p->_prxf[p->_nrx++] = p->_isr;
+            p->_isr = 0;
+        }
+        break;
+
+        case 5:                                 /* MOV */
+        {
+        uint32_t v = PioSource(p, instr & 7);
+        if(1 == ((instr >> 3) & 3))
+        {
+            v = ~v;
+        }
+        else if((instr >> 3) & 3)
+        {
+            fprintf(stderr, "Unsupported mov op: %04x\n", instr);
+            exit(1);
+        }
+        switch((instr >> 5) & 7)
+        {
+            case pio_x:   p->_x = v; break;
+            case pio_y:   p->_y = v; break;
+            case pio_isr: p->_isr = v; break;
+            case pio_osr: p->_osr = v; break;
+            case pio_pc:  p->_pc = (uint8_t)(v & 0x1F); jumped = 1; break;
+            default:
+            fprintf(stderr, "Unsupported mov destination: %04x\n", instr);
+            exit(1);
+        }
+        }
+        break;
+
+        default:
+        fprintf(stderr, "Unsupported instruction: %04x\n", instr);
+        exit(1);
+    }
+
+    if(from_mem && !jumped)
+    {
+        p->_pc = p->_pc == p->_wrap_top ? p->_wrap_bottom : (uint8_t)((p->_pc + 1) % PIO_MEM_SIZE);
+    }
+
+    return 1;
+}
+
+void pio_sm_exec(PIO pio, uint sm, uint instr)
+{
+    const int done = PioExec(Sm(pio, sm), (uint16_t)instr, 0);
+    assert(done);
+    (void)done;
+}
+
+/* ---------------------------------------------------------------- DMA -- */
+
+int dma_claim_unused_channel(bool required)
+{
+    for(int i = 0; i < NUM_DMA_CHANNELS; ++i)
+    {
+        if(!sDma[i]._claimed)
+        {
+            sDma[i]._claimed = 1;
+            return i;
+        }
+    }
+    assert(!required);
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    (void)channel;
+    dma_channel_config c = { DMA_SIZE_32, true, false, 0x3F };
+    return c;
+}
+
+/// @brief Raises DMA_IRQ_1 at once if a channel's flag is up and enabled.
+static void DmaIrq(void)
+{
+    for(int i = 0; i < NUM_DMA_CHANNELS; ++i)
+    {
+        if(sDma[i]._irq1 && sDma[i]._irq1_en && spDmaIrq1Handler)
+        {
+            if(snirqs < 8)
+            {
+                spu64_irq_cycle[snirqs] = su64_cycle;
+            }
+            ++snirqs;
+            spDmaIrq1Handler();
+            assert(!sDma[i]._irq1);             /* Must be acknowledged. */
+        }
+    }
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+    SimDma *p = &sDma[channel];
+    assert(DMA_SIZE_32 == config->_u8_size);
+    p->_cfg = *config;
+    p->_pwrite = (volatile uint8_t *)write_addr;
+    p->_pread = (volatile uint8_t *)read_addr;
+    p->_hw.transfer_count = transfer_count;
+    p->_busy = trigger;
+}
+
+void dma_start_channel_mask(uint32_t chan_mask)
+{
+    for(int i = 0; i < NUM_DMA_CHANNELS; ++i)
+    {
+        if(chan_mask & (1U << i))
+        {
+            sDma[i]._busy = sDma[i]._hw.transfer_count > 0;
+        }
+    }
+}
+
+/// @brief Aborting a busy channel raises its completion IRQ (RP2040-E13).
+void dma_channel_abort(uint channel)
+{
+    if(sDma[channel]._busy)
+    {
+        sDma[channel]._busy = 0;
+        sDma[channel]._irq1 = 1;
+        DmaIrq();
+    }
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled)
+{
+    sDma[channel]._irq1_en = enabled;
+    DmaIrq();
+}
+
+void dma_channel_acknowledge_irq1(uint channel)
+{
+    sDma[channel]._irq1 = 0;
+}
+
+bool dma_channel_is_busy(uint channel)
+{
+    return sDma[channel]._busy;
+}
+
+dma_channel_hw_t *dma_channel_hw_addr(uint channel)
+{
+    return &sDma[channel]._hw;
+}
+
+/// @brief Moves a word by every channel whose DREQ is up, until none is.
+static void DmaService(void)
+{
+    int moved;
+    do
+    {
+        moved = 0;
+        for(int i = 0; i < NUM_DMA_CHANNELS; ++i)
+        {
+            SimDma *p = &sDma[i];
+            if(!p->_busy)
+            {
+                continue;
+            }
+            const uint dreq = p->_cfg._dreq;
+            SimSm *pSm = &sPio._sm[dreq % NUM_PIO_STATE_MACHINES];
+            if(dreq < DREQ_PIO0_RX0 ? PIO_FIFO_DEPTH == pSm->_ntx : !pSm->_nrx)
+            {
+                continue;
+            }
+
+            uint32_t v;
+            if(p->_pread == (volatile uint8_t *)&sPio._regs.rxf[dreq - DREQ_PIO0_RX0])
+            {
+                v = pSm->_prxf[0];
+                memmove(pSm->_prxf, pSm->_prxf + 1, --pSm->_nrx * sizeof(uint32_t));
+            }
+            else
+            {
+                v = *(volatile uint32_t *)p->_pread;
+            }
+            if(p->_pwrite == (volatile uint8_t *)&sPio._regs.txf[dreq])
+            {
+                pSm->_ptxf[pSm->_ntx++] = v;
+            }
+            else
+            {
+                *(volatile uint32_t *)p->_pwrite = v;
+                if(p->_pwrite == (volatile uint8_t *)spi32_dco_word && snwrites < MAX_WRITES)
+                {
+                    spu64_write_cycle[snwrites] = su64_cycle;
+                    spu32_write_word[snwrites] = v;
+                    ++snwrites;
+                }
+            }
+            p->_pread += p->_cfg._read_incr ? 4 : 0;
+            p->_pwrite += p->_cfg._write_incr ? 4 : 0;
+            if(!--p->_hw.transfer_count)
+            {
+                p->_busy = 0;
+                p->_irq1 = 1;
+            }
+            moved = 1;
+        }
+    } while(moved);
+
+    DmaIrq();
+}
+
+/// @brief Runs the machine for a count of sys clock cycles. A `jmp x--`
+/// @brief onto itself and a stall are fast-forwarded: nothing else
+/// @brief changes meanwhile.
+static void SimRun(uint64_t u64_cycles)
+{
+    const uint64_t u64_end = su64_cycle + u64_cycles;
+    while(su64_cycle < u64_end)
+    {
+        DmaService();
+
+        SimSm *p = NULL;
+        for(int i = 0; i < NUM_PIO_STATE_MACHINES; ++i)
+        {
+            if(sPio._sm[i]._en)
+            {
+                assert(!p);                     /* One pacer only. */
+                p = &sPio._sm[i];
+            }
+        }
+        if(!p)
+        {
+            su64_cycle = u64_end;
+            break;
+        }
+        assert(1 == p->_u32_clkdiv_int);
+
+        const uint16_t instr = sPio._pu16_mem[p->_pc];
+        if(!(instr >> 13) && 2 == ((instr >> 5) & 7) && (instr & 0x1F) == p->_pc && p->_x > 1)
+        {
+            const uint64_t u64_n = p->_x - 1;
+            const uint64_t u64_skip = u64_n < u64_end - su64_cycle ? u64_n : u64_end - su64_cycle;
+            p->_x -= (uint32_t)u64_skip;
+            su64_cycle += u64_skip;
+            continue;
+        }
+        if(!PioExec(p, instr, 1))
+        {
+            /* Stalled, and DMA has just had its chance: idle to the end. */
+            su64_cycle = u64_end;
+            break;
+        }
+        ++su64_cycle;
+    }
+}
+
+/* ------------------------------------------------------------ .pio -- */
+
+static int ParseReg(const char *s)
+{
+    static const char *kNames[] = { "pins", "x", "y", "null", "exec", "pc", "isr", "osr" };
+    for(int i = 0; i < 8; ++i)
+    {
+        if(!strcmp(s, kNames[i]))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/// @brief Assembles the subset of PIO assembly the pacer uses, two passes
+/// @brief for labels. Exits on anything else.
+static void LoadProgram(const char *path)
+{
+    char labels[PIO_MEM_SIZE][32];
+    int label_addr[PIO_MEM_SIZE], nlabels = 0;
+
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        FILE *f = fopen(path, "r");
+        if(!f)
+        {
+            perror(path);
+            exit(1);
+        }
+        char line[256];
+        int in_sdk = 0, addr = 0;
+        while(fgets(line, sizeof(line), f))
+        {
+            char *pc = strchr(line, ';');
+            if(pc)
+            {
+                *pc = '\0';
+            }
+            if('%' == line[0])
+            {
+                in_sdk = NULL != strchr(line, '{');
+                continue;
+            }
+            char tok[4][32] = { "", "", "", "" };
+            const int ntok = in_sdk ? 0 : sscanf(line, " %31[^ \t\n,] %31[^ \t\n,] , %31s %31s",
+                                                 tok[0], tok[1], tok[2], tok[3]);
+            if(ntok <= 0)
+            {
+                continue;
+            }
+            if(!strcmp(tok[0], ".program"))
+            {
+                continue;
+            }
+            if(!strcmp(tok[0], ".wrap_target"))
+            {
+                swrap_target = addr;
+                continue;
+            }
+            if(!strcmp(tok[0], ".wrap"))
+            {
+                swrap = addr - 1;
+                continue;
+            }
+            const size_t len = strlen(tok[0]);
+            if(':' == tok[0][len - 1])
+            {
+                if(!pass)
+                {
+                    tok[0][len - 1] = '\0';
+                    strcpy(labels[nlabels], tok[0]);
+                    label_addr[nlabels++] = addr;
+                }
+                continue;
+            }
+
+            uint16_t instr = 0;
+            if(!strcmp(tok[0], "pull") || !strcmp(tok[0], "push"))
+            {
+                const int pull = 'l' == tok[0][2];
+                instr = 0x8000 | (pull ? 0x80 : 0) | 0x20;
+                if(!strcmp(tok[1], "noblock"))
+                {
+                    instr &= ~0x20;
+                }
+                else if(tok[1][0] && strcmp(tok[1], "block"))
+                {
+                    fprintf(stderr, "%s: unsupported `%s %s`\n", path, tok[0], tok[1]);
+                    exit(1);
+                }
+            }
+            else if(!strcmp(tok[0], "mov"))
+            {
+                /* `mov dst, src`: sscanf has split it at the comma. */
+                const int dst = ParseReg(tok[1]), src = ParseReg(tok[2]);
+                if(dst < 0 || src < 0)
+                {
+                    fprintf(stderr, "%s: unsupported `mov %s, %s`\n", path, tok[1], tok[2]);
+                    exit(1);
+                }
+                instr = (uint16_t)pio_encode_mov((enum pio_src_dest)dst, (enum pio_src_dest)src);
+            }
+            else if(!strcmp(tok[0], "jmp"))
+            {
+                static const char *kConds[] = { "", "!x", "x--", "!y", "y--", "x!=y", "pin", "!osre" };
+                /* `jmp [cond] label`; the label is the last token. */
+                char cond[32] = "", target[32] = "";
+                if(2 != sscanf(line, " jmp %31s %31s", cond, target))
+                {
+                    strcpy(target, cond);
+                    cond[0] = '\0';
+                }
+                int icond = -1, iaddr = -1;
+                for(int i = 0; i < 8; ++i)
+                {
+                    icond = !strcmp(cond, kConds[i]) ? i : icond;
+                }
+                for(int i = 0; i < nlabels; ++i)
+                {
+                    iaddr = !strcmp(target, labels[i]) ? label_addr[i] : iaddr;
+                }
+                if(icond < 0 || (pass && iaddr < 0))
+                {
+                    fprintf(stderr, "%s: unsupported `jmp %s %s`\n", path, cond, target);
+                    exit(1);
+                }
+                instr = (uint16_t)(icond << 5 | (iaddr < 0 ? 0 : iaddr));
+            }
+            else
+            {
+                fprintf(stderr, "%s: unsupported `%s`\n", path, tok[0]);
+                exit(1);
+            }
+            if(pass)
+            {
+                spu16_prog[addr] = instr;
+            }
+            ++addr;
+        }
+        fclose(f);
+        snprog = addr;
+    }
+    if(swrap_target < 0)
+    {
+        swrap_target = 0;
+    }
+    if(swrap < 0)
+    {
+        swrap = snprog - 1;
+    }
+}
+
+/* ------------------------------------------------------------ checks -- */
+
+static int snchecked = 0, snfailed = 0;
+
+static void Expect(int ok, const char *pformat, ...)
+{
+    ++snchecked;
+    if(!ok)
+    {
+        ++snfailed;
+        va_list argptr;
+        va_start(argptr, pformat);
+        printf("FAILED: ");
+        vprintf(pformat, argptr);
+        va_end(argptr);
+        printf("\n");
+    }
+}
+
+static void RandomFrame(TonePackedFrame *pframe, uint8_t *ppacked, size_t size, int n, uint8_t bits)
+{
+    uint8_t tones[TX_DMA_MAX_SYMBOLS];
+    for(int i = 0; i < n; ++i)
+    {
+        tones[i] = rand() & ((1 << bits) - 1);
+    }
+    TonePackFrame(pframe, ppacked, size, tones, n, bits);
+}
+
+/// @brief Sends a frame and checks its words, period and end of frame IRQ.
+static void CheckFrame(TxChannelDMAContext *pDMA, const char *name, int n, uint8_t bits)
+{
+    TxChannelContext *pTX = pDMA->_pTX;
+    uint8_t packed[TONE_PACK_BYTES(TX_DMA_MAX_SYMBOLS, TONE_PACK_MAX_BITS)];
+    TonePackedFrame frame;
+    RandomFrame(&frame, packed, sizeof(packed), n, bits);
+
+    uint32_t words[TX_DMA_MAX_SYMBOLS + 1];
+    const int nwords = TxChannelFrameWords(pTX, &frame, words, TX_DMA_MAX_SYMBOLS + 1);
+
+    const uint64_t u64_period = (uint64_t)pTX->_bit_period_us * su32_clk_hz / 1000000ULL;
+    snwrites = snirqs = 0;
+    const uint64_t u64_start = su64_cycle;
+    Expect(!TxChannelDMASend(pDMA, &frame), "%s: send", name);
+    Expect(pDMA->_u32_period_cycles == u64_period, "%s: pacer period %lu, expected %llu", name,
+           pDMA->_u32_period_cycles, (unsigned long long)u64_period);
+
+    /* Half way: the pending count follows the symbols. */
+    SimRun(u64_period * (n / 2) + u64_period / 2);
+    const uint32_t u32_pending = TxChannelDMAPending(pDMA);
+    Expect(u32_pending == (uint32_t)(nwords - (n / 2 + 1)), "%s: %lu pending half way, expected %d",
+           name, u32_pending, nwords - (n / 2 + 1));
+    Expect(!snirqs, "%s: end of frame IRQ half way", name);
+
+    SimRun(u64_period * (n - n / 2 + 2));
+    Expect(snwrites == nwords, "%s: %d DCO words written, expected %d", name, snwrites, nwords);
+
+    int nbad_word = 0, nbad_period = 0;
+    for(int i = 0; i < snwrites && i < nwords; ++i)
+    {
+        nbad_word += spu32_write_word[i] != words[i];
+        nbad_period += i && spu64_write_cycle[i] - spu64_write_cycle[i - 1] != u64_period;
+    }
+    Expect(!nbad_word, "%s: %d wrong words", name, nbad_word);
+    Expect(!nbad_period, "%s: %d symbols off the period of %llu cycles", name, nbad_period,
+           (unsigned long long)u64_period);
+    Expect(snwrites && spu64_write_cycle[0] - u64_start < 8, "%s: first word after %llu cycles",
+           name, snwrites ? (unsigned long long)(spu64_write_cycle[0] - u64_start) : 0ULL);
+    Expect(spu32_write_word[nwords - 1] == spu32_write_word[nwords - 2],
+           "%s: the pad word repeats the last one", name);
+
+    Expect(1 == snirqs, "%s: %d end of frame IRQs", name, snirqs);
+    Expect(snirqs && snwrites == nwords && spu64_irq_cycle[0] == spu64_write_cycle[nwords - 1],
+           "%s: end of frame IRQ isn't at the pad word", name);
+    Expect(TxChannelFrameDone(pTX), "%s: frame done", name);
+    Expect(!TxChannelDMAPending(pDMA), "%s: pending after the end", name);
+}
+
+/// @brief Stops a frame midway, then sends another one.
+static void CheckStop(TxChannelDMAContext *pDMA)
+{
+    uint8_t packed[TONE_PACK_BYTES(TX_DMA_MAX_SYMBOLS, TONE_PACK_MAX_BITS)];
+    TonePackedFrame frame;
+    RandomFrame(&frame, packed, sizeof(packed), 79, 3);
+
+    const uint64_t u64_period = pDMA->_u32_period_cycles;
+    TxChannelDMASend(pDMA, &frame);
+    SimRun(u64_period * 10 + 123);
+    snirqs = 0;
+    TxChannelDMAStop(pDMA);
+    SimRun(u64_period * 3);
+    Expect(!snirqs && !TxChannelFrameDone(pDMA->_pTX), "stop: the aborted frame has signalled its end");
+    Expect(!TxChannelDMAPending(pDMA), "stop: pending after abort");
+
+    CheckFrame(pDMA, "after stop", 79, 3);
+}
+
+int main(int argc, char **argv)
+{
+    LoadProgram(argc > 1 ? argv[1] : "TxChannel/txpacer.pio");
+
+    GPStimeContext gps = { { YES } };
+    PioDco dco = { 0, CLK_HZ, &gps };
+    PioDCOSetFreq(&dco, DIAL_HZ, 0);
+    spi32_dco_word = &dco._frq_cycles_per_pi;
+
+    TxChannelContext *pTX = TxChannelInit(FT8_PERIOD_US, 0, 256, &dco);
+    pTX->_u32_dialfreqhz = DIAL_HZ;
+    TxChannelDMAContext *pDMA = TxChannelDMAInit(pTX, &sPio._regs);
+
+    CheckFrame(pDMA, "FT8", 79, 3);
+
+    /* FT4: WSPRbeaconSetMode changes the period and re-times the pacer. */
+    pTX->_bit_period_us = FT4_PERIOD_US;
+    pTX->_u32_tone_step_milhz = FT4_FREQ_STEP_MILHZ;
+    TxChannelDMASetPeriod(pDMA);
+    CheckFrame(pDMA, "FT4", 105, 2);
+
+    pTX->_bit_period_us = WSPR_PERIOD_US;
+    pTX->_u32_tone_step_milhz = WSPR_FREQ_STEP_MILHZ;
+    CheckFrame(pDMA, "WSPR", 162, 2);
+
+    /* Sys clock lowered (PowerMgr): Send re-times by itself. */
+    su32_clk_hz = SLEEP_CLK_HZ;
+    su64_cycle = su64_cycle / (CLK_HZ / 1000000U) * (SLEEP_CLK_HZ / 1000000U);
+    pTX->_bit_period_us = FT8_PERIOD_US;
+    pTX->_u32_tone_step_milhz = WSPR_FREQ_STEP_MILHZ;
+    CheckFrame(pDMA, "FT8 at 48 MHz", 79, 3);
+
+    su32_clk_hz = CLK_HZ;
+    su64_cycle = su64_cycle / (SLEEP_CLK_HZ / 1000000U) * (CLK_HZ / 1000000U);
+    CheckStop(pDMA);
+
+    printf("pacer: %d instructions, wrap %d..%d, %llu cycles per FT8 symbol\n", snprog,
+           swrap_target, swrap, (unsigned long long)pDMA->_u32_period_cycles);
+    printf("checked: %d, failed: %d\n", snchecked, snfailed);
+    printf("verdict: %s\n", snfailed ? "FAIL" : "PASS");
+
+    return snfailed ? 2 : 0;
+}
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Roman Piksaykin [piksaykin@gmail.com], R2BDY
+//  https://www.qrz.com/db/r2bdy
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//
+//  flashmem.c - Utility of writing & reading a data from/to Pico's flash mem.
+// 
+//  DESCRIPTION
+//      Keeps a small record in the last sector of flash. Writing is done
+//      by flash_safe_execute, so core1 (the DCO) is paused for the time
+//      of sector erase; don't write while transmitting.
+//
+//  HOWTOSTART
+//  .
+//
+//  PLATFORM
+//      Raspberry Pi pico.
+//
+//  REVISION HISTORY
+// 
+//      Rev 0.1   02 Dec 2023
+//  Initial release.
+//
+//  PROJECT PAGE
+//      https://github.com/RPiks/pico-WSPR-tx
+//
+//  LICENCE
+//      MIT License (http://www.opensource.org/licenses/mit-license.php)
+//
+//  Copyright (c) 2023 by Roman Piksaykin
+//  
+//  Permission is hereby granted, free of charge,to any person obtaining a copy
+//  of this software and associated documentation files (the Software), to deal
+//  in the Software without restriction,including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY,WHETHER IN AN ACTION OF CONTRACT,TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+///////////////////////////////////////////////////////////////////////////////
+#include "flashmem.h"
+#include <string.h>
+#include "pico/flash.h"
+
+typedef struct
+{
+    const void *_psrc;
+    size_t _n;
+
+} FlashMemJob;
+
+/// @brief Erases the sector and programs the record. Runs from RAM with
+/// @brief the other core locked out and IRQs disabled.
+/// @param pjob Ptr to FlashMemJob.
+static void __not_in_flash_func (FlashMemDoWrite)(void *pjob)
+{
+    const FlashMemJob *p = (const FlashMemJob *)pjob;
+    static uint8_t su8_page[FLASH_PAGE_SIZE];
+
+    flash_range_erase(FLASHMEM_OFFSET, FLASH_SECTOR_SIZE);
+    for(size_t ofs = 0; ofs < p->_n; ofs += FLASH_PAGE_SIZE)
+    {
+        const size_t n = p->_n - ofs < FLASH_PAGE_SIZE ? p->_n - ofs : FLASH_PAGE_SIZE;
+        memset(su8_page, 0xFF, sizeof(su8_page));
+        memcpy(su8_page, (const uint8_t *)p->_psrc + ofs, n);
+        flash_range_program(FLASHMEM_OFFSET + ofs, su8_page, FLASH_PAGE_SIZE);
+    }
+}
+
+/// @brief Gets the record stored, memory mapped.
+/// @return Ptr to the record (all 0xFF if it has never been written).
+const void *FlashMemGet(void)
+{
+    return (const void *)(XIP_BASE + FLASHMEM_OFFSET);
+}
+
+/// @brief Writes the record replacing the previous one.
+/// @param psrc Ptr to data (must not be in flash).
+/// @param n Size of data, up to FLASH_SECTOR_SIZE.
+/// @return 0 if OK, error code of flash_safe_execute otherwise.
+int FlashMemWrite(const void *psrc, size_t n)
+{
+    if(!psrc || n > FLASH_SECTOR_SIZE)
+    {
+        return -1;
+    }
+
+    FlashMemJob job = { psrc, n };
+
+    return flash_safe_execute(FlashMemDoWrite, &job, 100);
+}
@@ -9,7 +9,9 @@
 //  flashmem.h - Utility of writing & reading a data from/to Pico's flash mem.
 // 
 //  DESCRIPTION
-//  .
+//      Keeps a small record in the last sector of flash. Writing is done
+//      by flash_safe_execute, so core1 (the DCO) is paused for the time
+//      of sector erase; don't write while transmitting.
 //
 //  HOWTOSTART
 //  .
@@ -51,14 +53,19 @@
 #ifndef FLASHMEM_H_
 #define FLASHMEM_H_
 
+#include <stdint.h>
+#include <stddef.h>
 #include "hardware/flash.h"
 
+#define FLASHMEM_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+
 typedef struct
 {
     void *_pFlashTargetOffset;
 
 } FlashMemContext;
 
-
+const void *FlashMemGet(void);
+int FlashMemWrite(const void *psrc, size_t n);
 
 #endif